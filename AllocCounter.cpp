@@ -0,0 +1,81 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "AllocCounter.h"
+
+#if defined(M17_COUNT_ALLOCS)
+#include <cstdlib>
+#include <new>
+
+static thread_local unsigned long long allocs = 0ULL;
+
+static void* allocate(std::size_t size)
+{
+	allocs++;
+
+	void* p = std::malloc(size == 0U ? 1U : size);
+	if (p == nullptr)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void* operator new(std::size_t size)
+{
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	allocs++;
+
+	return std::malloc(size == 0U ? 1U : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	allocs++;
+
+	return std::malloc(size == 0U ? 1U : size);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+unsigned long long CAllocCounter::get()
+{
+	return allocs;
+}
+#else
+unsigned long long CAllocCounter::get()
+{
+	return 0ULL;
+}
+#endif
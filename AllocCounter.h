@@ -0,0 +1,31 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(AllocCounter_H)
+#define	AllocCounter_H
+
+// Counts the heap allocations made by the calling thread. Only a build with
+// M17_COUNT_ALLOCS defined replaces operator new to do the counting, in any
+// other build the count stays at zero. The forwarder uses it to assert that
+// forwarding a frame never allocates.
+class CAllocCounter {
+public:
+	static unsigned long long get();
+};
+
+#endif
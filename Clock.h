@@ -0,0 +1,41 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(Clock_H)
+#define	Clock_H
+
+// The source of time for CStopWatch and CThread::sleep, and so for every
+// CTimer, whose ticks come from a CStopWatch. It is the monotonic clock unless
+// a test or the replay tool has set another, such as a CManualClock, so that
+// the gateway can be run in virtual time.
+class CClock {
+public:
+	virtual ~CClock();
+
+	// Nanoseconds from an arbitrary point, never going backwards
+	virtual unsigned long long nanoseconds() const = 0;
+
+	virtual void sleep(unsigned int ms) = 0;
+
+	static CClock& get();
+
+	// Only before the threads that use the clock are started, nullptr restores the monotonic clock
+	static void set(CClock* clock);
+};
+
+#endif
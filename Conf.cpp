@@ -21,6 +21,9 @@
 #include "M17Defines.h"
 
 #include <algorithm>
+#include <cassert>
+#include <cstdarg>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -28,17 +31,6 @@
 
 const int BUFFER_SIZE = 500;
 
-enum class SECTION {
-	NONE,
-	GENERAL,
-	INFO,
-	LOG,
-	APRS,
-	VOICE,
-	NETWORK,
-	REMOTE_COMMANDS
-};
-
 CConf::CConf(const std::string& file) :
 m_file(file),
 m_callsign(),
@@ -61,6 +53,8 @@ m_logFileLevel(0U),
 m_logFilePath(),
 m_logFileRoot(),
 m_logFileRotate(true),
+m_logAsync(false),
+m_logAsyncLength(256U),
 m_aprsEnabled(false),
 m_aprsAddress("127.0.0.1"),
 m_aprsPort(8673U),
@@ -80,7 +74,37 @@ m_networkStartup(),
 m_networkRevert(false),
 m_networkDebug(false),
 m_remoteCommandsEnabled(false),
-m_remoteCommandsPort(6076U)
+m_remoteCommandsPort(6076U),
+m_captureEnabled(false),
+m_captureFilePath(),
+m_captureFileRoot("M17Gateway"),
+m_captureMaxSize(10U),
+m_captureFiles(5U),
+m_eventsEnabled(false),
+m_eventsFile(),
+m_eventsSocket(),
+m_metricsEnabled(false),
+m_metricsAddress("127.0.0.1"),
+m_metricsPort(9117U),
+m_metricsSocket(),
+m_controlEnabled(false),
+m_controlSocket("/tmp/M17Gateway.sock"),
+m_controlStatsInterval(10U),
+m_flightRecorderEnabled(true),
+m_flightRecorderFilePath("."),
+m_flightRecorderFileRoot("M17Gateway"),
+m_flightRecorderSeconds(30U),
+m_workersCount(0U),
+m_workersPin(true),
+m_ioThreadEnabled(false),
+m_realTimeEnabled(false),
+m_realTimePolicy("FIFO"),
+m_realTimePriority(50U),
+m_realTimeCPU(-1),
+m_realTimeLockMemory(true),
+m_realTimePrefault(true),
+m_repeaters(),
+m_errors()
 {
 }
 
@@ -88,6 +112,150 @@ CConf::~CConf()
 {
 }
 
+// The ones which are marked as reloadable can be applied by a running gateway
+const CConf::CConfItem<CConf> CConf::ITEMS[] = {
+	CConfItem<CConf>("General", "Callsign",    false, &CConf::m_callsign, CONF_TYPE::UPPER),
+	CConfItem<CConf>("General", "Suffix",      false, &CConf::m_suffix, CONF_TYPE::UPPER),
+	CConfItem<CConf>("General", "RptAddress",  false, &CConf::m_rptAddress),
+	CConfItem<CConf>("General", "RptPort",     false, &CConf::m_rptPort),
+	CConfItem<CConf>("General", "LocalPort",   false, &CConf::m_myPort),
+	CConfItem<CConf>("General", "Debug",       false, &CConf::m_debug),
+	CConfItem<CConf>("General", "Daemon",      false, &CConf::m_daemon),
+
+	CConfItem<CConf>("Info", "TXFrequency",    true,  &CConf::m_txFrequency),
+	CConfItem<CConf>("Info", "RXFrequency",    true,  &CConf::m_rxFrequency),
+	CConfItem<CConf>("Info", "Power",          true,  &CConf::m_power),
+	CConfItem<CConf>("Info", "Latitude",       true,  &CConf::m_latitude),
+	CConfItem<CConf>("Info", "Longitude",      true,  &CConf::m_longitude),
+	CConfItem<CConf>("Info", "Height",         true,  &CConf::m_height),
+	CConfItem<CConf>("Info", "Name",           true,  &CConf::m_name),
+	CConfItem<CConf>("Info", "Description",    true,  &CConf::m_description),
+
+	CConfItem<CConf>("Log", "FilePath",        false, &CConf::m_logFilePath),
+	CConfItem<CConf>("Log", "FileRoot",        false, &CConf::m_logFileRoot),
+	CConfItem<CConf>("Log", "FileLevel",       true,  &CConf::m_logFileLevel),
+	CConfItem<CConf>("Log", "DisplayLevel",    true,  &CConf::m_logDisplayLevel),
+	CConfItem<CConf>("Log", "FileRotate",      false, &CConf::m_logFileRotate),
+	CConfItem<CConf>("Log", "Async",           false, &CConf::m_logAsync),
+	CConfItem<CConf>("Log", "AsyncLength",     false, &CConf::m_logAsyncLength),
+
+	CConfItem<CConf>("APRS", "Enable",         true,  &CConf::m_aprsEnabled),
+	CConfItem<CConf>("APRS", "Address",        true,  &CConf::m_aprsAddress),
+	CConfItem<CConf>("APRS", "Port",           true,  &CConf::m_aprsPort),
+	CConfItem<CConf>("APRS", "Suffix",         true,  &CConf::m_aprsSuffix),
+	CConfItem<CConf>("APRS", "Description",    true,  &CConf::m_aprsDescription),
+	CConfItem<CConf>("APRS", "Symbol",         true,  &CConf::m_aprsSymbol),
+
+	CConfItem<CConf>("Voice", "Enabled",       false, &CConf::m_voiceEnabled),
+	CConfItem<CConf>("Voice", "Language",      false, &CConf::m_voiceLanguage),
+	CConfItem<CConf>("Voice", "Directory",     false, &CConf::m_voiceDirectory),
+
+	CConfItem<CConf>("Network", "Port",        false, &CConf::m_networkPort),
+	CConfItem<CConf>("Network", "LocalPort",   false, &CConf::m_networkLocalPort),
+	CConfItem<CConf>("Network", "HostsFile1",  true,  &CConf::m_networkHosts1),
+	CConfItem<CConf>("Network", "HostsFile2",  true,  &CConf::m_networkHosts2),
+	CConfItem<CConf>("Network", "ReloadTime",  true,  &CConf::m_networkReloadTime),
+	CConfItem<CConf>("Network", "HangTime",    true,  &CConf::m_networkHangTime),
+	CConfItem<CConf>("Network", "Startup",     true,  &CConf::m_networkStartup, CONF_TYPE::REFLECTOR),
+	CConfItem<CConf>("Network", "Revert",      true,  &CConf::m_networkRevert),
+	CConfItem<CConf>("Network", "Debug",       false, &CConf::m_networkDebug),
+
+	CConfItem<CConf>("Remote Commands", "Enable", false, &CConf::m_remoteCommandsEnabled),
+	CConfItem<CConf>("Remote Commands", "Port",   false, &CConf::m_remoteCommandsPort),
+
+	CConfItem<CConf>("Capture", "Enable",      false, &CConf::m_captureEnabled),
+	CConfItem<CConf>("Capture", "FilePath",    false, &CConf::m_captureFilePath),
+	CConfItem<CConf>("Capture", "FileRoot",    false, &CConf::m_captureFileRoot),
+	CConfItem<CConf>("Capture", "MaxSize",     false, &CConf::m_captureMaxSize),
+	CConfItem<CConf>("Capture", "Files",       false, &CConf::m_captureFiles),
+
+	CConfItem<CConf>("Events", "Enable",       false, &CConf::m_eventsEnabled),
+	CConfItem<CConf>("Events", "File",         false, &CConf::m_eventsFile),
+	CConfItem<CConf>("Events", "Socket",       false, &CConf::m_eventsSocket),
+
+	CConfItem<CConf>("Metrics", "Enable",      false, &CConf::m_metricsEnabled),
+	CConfItem<CConf>("Metrics", "Address",     false, &CConf::m_metricsAddress),
+	CConfItem<CConf>("Metrics", "Port",        false, &CConf::m_metricsPort),
+	CConfItem<CConf>("Metrics", "Socket",      false, &CConf::m_metricsSocket),
+
+	CConfItem<CConf>("Control", "Enable",        false, &CConf::m_controlEnabled),
+	CConfItem<CConf>("Control", "Socket",        false, &CConf::m_controlSocket),
+	CConfItem<CConf>("Control", "StatsInterval", true,  &CConf::m_controlStatsInterval),
+
+	CConfItem<CConf>("Flight Recorder", "Enable",   false, &CConf::m_flightRecorderEnabled),
+	CConfItem<CConf>("Flight Recorder", "FilePath", false, &CConf::m_flightRecorderFilePath),
+	CConfItem<CConf>("Flight Recorder", "FileRoot", false, &CConf::m_flightRecorderFileRoot),
+	CConfItem<CConf>("Flight Recorder", "Seconds",  false, &CConf::m_flightRecorderSeconds),
+
+	CConfItem<CConf>("Workers", "Count", false, &CConf::m_workersCount),
+	CConfItem<CConf>("Workers", "Pin",   false, &CConf::m_workersPin),
+
+	CConfItem<CConf>("IO Thread", "Enable", false, &CConf::m_ioThreadEnabled),
+
+	CConfItem<CConf>("Real Time", "Enable",     false, &CConf::m_realTimeEnabled),
+	CConfItem<CConf>("Real Time", "Policy",     false, &CConf::m_realTimePolicy, CONF_TYPE::POLICY),
+	CConfItem<CConf>("Real Time", "Priority",   false, &CConf::m_realTimePriority),
+	CConfItem<CConf>("Real Time", "CPU",        false, &CConf::m_realTimeCPU),
+	CConfItem<CConf>("Real Time", "LockMemory", false, &CConf::m_realTimeLockMemory),
+	CConfItem<CConf>("Real Time", "Prefault",   false, &CConf::m_realTimePrefault)
+};
+
+const unsigned int CConf::ITEM_COUNT = sizeof(CConf::ITEMS) / sizeof(CConf::ITEMS[0U]);
+
+// As with the first repeater, only the hang time, the startup reflector and revert can be reloaded
+const CConf::CConfItem<CRepeaterConf> CConf::REPEATER_ITEMS[] = {
+	CConfItem<CRepeaterConf>("Repeater", "Callsign",    false, &CRepeaterConf::m_callsign, CONF_TYPE::UPPER),
+	CConfItem<CRepeaterConf>("Repeater", "Suffix",      false, &CRepeaterConf::m_suffix, CONF_TYPE::UPPER),
+	CConfItem<CRepeaterConf>("Repeater", "RptAddress",  false, &CRepeaterConf::m_rptAddress),
+	CConfItem<CRepeaterConf>("Repeater", "RptPort",     false, &CRepeaterConf::m_rptPort),
+	CConfItem<CRepeaterConf>("Repeater", "LocalPort",   false, &CRepeaterConf::m_localPort),
+	CConfItem<CRepeaterConf>("Repeater", "NetworkPort", false, &CRepeaterConf::m_networkPort),
+	CConfItem<CRepeaterConf>("Repeater", "RemotePort",  false, &CRepeaterConf::m_remotePort),
+	CConfItem<CRepeaterConf>("Repeater", "HangTime",    true,  &CRepeaterConf::m_hangTime),
+	CConfItem<CRepeaterConf>("Repeater", "Startup",     true,  &CRepeaterConf::m_startup, CONF_TYPE::REFLECTOR),
+	CConfItem<CRepeaterConf>("Repeater", "Revert",      true,  &CRepeaterConf::m_revert)
+};
+
+const unsigned int CConf::REPEATER_ITEM_COUNT = sizeof(CConf::REPEATER_ITEMS) / sizeof(CConf::REPEATER_ITEMS[0U]);
+
+CRepeaterConf::CRepeaterConf() :
+m_name(),
+m_callsign(),
+m_suffix("M"),
+m_rptAddress("127.0.0.1"),
+m_rptPort(0U),
+m_localPort(0U),
+m_networkPort(0U),
+m_remotePort(0U),
+m_hangTime(60U),
+m_startup(),
+m_revert(false),
+m_line(0U)
+{
+}
+
+// Open addressing, kept at less than half full
+const unsigned int HASH_SIZE = 256U;
+
+// FNV-1a over the section and the key
+static unsigned int hash(const char* section, const char* key)
+{
+	assert(section != nullptr);
+	assert(key != nullptr);
+
+	uint32_t h = 2166136261U;
+
+	for (const char* p = section; *p != '\0'; p++)
+		h = (h ^ uint8_t(*p)) * 16777619U;
+
+	h = (h ^ uint8_t(']')) * 16777619U;
+
+	for (const char* p = key; *p != '\0'; p++)
+		h = (h ^ uint8_t(*p)) * 16777619U;
+
+	return h & (HASH_SIZE - 1U);
+}
+
 bool CConf::read()
 {
 	FILE* fp = ::fopen(m_file.c_str(), "rt");
@@ -96,30 +264,50 @@ bool CConf::read()
 		return false;
 	}
 
-	SECTION section = SECTION::NONE;
+	m_errors.clear();
+	m_repeaters.clear();
+
+	char section[BUFFER_SIZE];
+	section[0U] = '\0';
+	bool known = false;
+	bool repeater = false;
+
+	unsigned int line = 0U;
 
 	char buffer[BUFFER_SIZE];
 	while (::fgets(buffer, BUFFER_SIZE, fp) != nullptr) {
+		line++;
+
 		if (buffer[0U] == '#')
 			continue;
 
 		if (buffer[0U] == '[') {
-			if (::strncmp(buffer, "[General]", 9U) == 0)
-				section = SECTION::GENERAL;
-			else if (::strncmp(buffer, "[Info]", 6U) == 0)
-				section = SECTION::INFO;
-			else if (::strncmp(buffer, "[Log]", 5U) == 0)
-				section = SECTION::LOG;
-			else if (::strncmp(buffer, "[APRS]", 6U) == 0)
-				section = SECTION::APRS;
-			else if (::strncmp(buffer, "[Voice]", 7U) == 0)
-				section = SECTION::VOICE;
-			else if (::strncmp(buffer, "[Network]", 9U) == 0)
-				section = SECTION::NETWORK;
-			else if (::strncmp(buffer, "[Remote Commands]", 17U) == 0)
-				section = SECTION::REMOTE_COMMANDS;
-			else
-				section = SECTION::NONE;
+			char* end = ::strchr(buffer, ']');
+			if (end == nullptr) {
+				error(line, "the section header is missing a ]");
+				section[0U] = '\0';
+				known = false;
+				continue;
+			}
+
+			if (repeater)
+				checkRepeater();
+
+			*end = '\0';
+			::strcpy(section, buffer + 1U);
+
+			// Any number of these, each one adds a repeater
+			repeater = ::strncmp(section, "Repeater ", 9U) == 0;
+			if (repeater) {
+				CRepeaterConf conf;
+				conf.m_name = section;
+				conf.m_line = line;
+				m_repeaters.push_back(conf);
+			}
+
+			known = repeater || isSection(section);
+			if (!known)
+				error(line, "unknown section [%s]", section);
 
 			continue;
 		}
@@ -149,109 +337,360 @@ bool CConf::read()
 				*p = '\0';
 		}
 
-		if (section == SECTION::GENERAL) {
-			if (::strcmp(key, "Callsign") == 0) {
-				// Convert the callsign to upper case
-				for (unsigned int i = 0U; value[i] != 0; i++)
-					value[i] = ::toupper(value[i]);
-				m_callsign = value;
-			} else if (::strcmp(key, "Suffix") == 0) {
-				// Convert the suffix to upper case
-				for (unsigned int i = 0U; value[i] != 0; i++)
-					value[i] = ::toupper(value[i]);
-				m_suffix = value;
-			} else if (::strcmp(key, "RptAddress") == 0)
-				m_rptAddress = value;
-			else if (::strcmp(key, "RptPort") == 0)
-				m_rptPort = (unsigned short)::atoi(value);
-			else if (::strcmp(key, "LocalPort") == 0)
-				m_myPort = (unsigned short)::atoi(value);
-			else if (::strcmp(key, "Debug") == 0)
-				m_debug = ::atoi(value) == 1;
-			else if (::strcmp(key, "Daemon") == 0)
-				m_daemon = ::atoi(value) == 1;
-		} else if (section == SECTION::INFO) {
-			if (::strcmp(key, "TXFrequency") == 0)
-				m_txFrequency = (unsigned int)::atoi(value);
-			else if (::strcmp(key, "RXFrequency") == 0)
-				m_rxFrequency = (unsigned int)::atoi(value);
-			else if (::strcmp(key, "Power") == 0)
-				m_power = (unsigned int)::atoi(value);
-			else if (::strcmp(key, "Latitude") == 0)
-				m_latitude = float(::atof(value));
-			else if (::strcmp(key, "Longitude") == 0)
-				m_longitude = float(::atof(value));
-			else if (::strcmp(key, "Height") == 0)
-				m_height = ::atoi(value);
-			else if (::strcmp(key, "Name") == 0)
-				m_name = value;
-			else if (::strcmp(key, "Description") == 0)
-				m_description = value;
-		} else if (section == SECTION::LOG) {
-			if (::strcmp(key, "FilePath") == 0)
-				m_logFilePath = value;
-			else if (::strcmp(key, "FileRoot") == 0)
-				m_logFileRoot = value;
-			else if (::strcmp(key, "FileLevel") == 0)
-				m_logFileLevel = (unsigned int)::atoi(value);
-			else if (::strcmp(key, "DisplayLevel") == 0)
-				m_logDisplayLevel = (unsigned int)::atoi(value);
-			else if (::strcmp(key, "FileRotate") == 0)
-				m_logFileRotate = ::atoi(value) ==  1;
-		} else if (section == SECTION::APRS) {
-			if (::strcmp(key, "Enable") == 0)
-				m_aprsEnabled = ::atoi(value) == 1;
-			else if (::strcmp(key, "Address") == 0)
-				m_aprsAddress = value;
-			else if (::strcmp(key, "Port") == 0)
-				m_aprsPort = (unsigned int)::atoi(value);
-			else if (::strcmp(key, "Suffix") == 0)
-				m_aprsSuffix = value;
-			else if (::strcmp(key, "Description") == 0)
-				m_aprsDescription = value;
-                        else if (::strcmp(key, "Symbol") == 0)
-                                m_aprsSymbol = value;
-		} else if (section == SECTION::VOICE) {
-			if (::strcmp(key, "Enabled") == 0)
-				m_voiceEnabled = ::atoi(value) == 1;
-			else if (::strcmp(key, "Language") == 0)
-				m_voiceLanguage = value;
-			else if (::strcmp(key, "Directory") == 0)
-				m_voiceDirectory = value;
-		} else if (section == SECTION::NETWORK) {
-			if (::strcmp(key, "Port") == 0)
-				m_networkPort = (unsigned short)::atoi(value);
-			else if (::strcmp(key, "LocalPort") == 0)
-				m_networkLocalPort = (unsigned short)::atoi(value);
-			else if (::strcmp(key, "HostsFile1") == 0)
-				m_networkHosts1 = value;
-			else if (::strcmp(key, "HostsFile2") == 0)
-				m_networkHosts2 = value;
-			else if (::strcmp(key, "ReloadTime") == 0)
-				m_networkReloadTime = (unsigned int)::atoi(value);
-			else if (::strcmp(key, "HangTime") == 0)
-				m_networkHangTime = (unsigned int)::atoi(value);
-			else if (::strcmp(key, "Startup") == 0) {
-				m_networkStartup = value;
-				std::replace(m_networkStartup.begin(), m_networkStartup.end(), '_', ' ');
-				m_networkStartup.resize(M17_CALLSIGN_LENGTH, ' ');
-			} else if (::strcmp(key, "Revert") == 0)
-				m_networkRevert = ::atoi(value) == 1;
-			else if (::strcmp(key, "Debug") == 0)
-				m_networkDebug = ::atoi(value) == 1;
-		} else if (section == SECTION::REMOTE_COMMANDS) {
-			if (::strcmp(key, "Enable") == 0)
-				m_remoteCommandsEnabled = ::atoi(value) == 1;
-			else if (::strcmp(key, "Port") == 0)
-				m_remoteCommandsPort = (unsigned short)::atoi(value);
+		// The keys of an unknown section have been reported with it
+		if (section[0U] == '\0') {
+			error(line, "%s is not in a section", key);
+			continue;
+		} else if (!known) {
+			continue;
+		}
+
+		if (repeater) {
+			const CConfItem<CRepeaterConf>* item = findRepeater(key);
+			if (item == nullptr)
+				error(line, "unknown key %s in [%s]", key, section);
+			else if (!set(m_repeaters.back(), *item, value))
+				error(line, "bad value \"%s\" for %s in [%s], using %s", value, key, section, format(m_repeaters.back(), *item).c_str());
+			continue;
+		}
+
+		const CConfItem<CConf>* item = find(section, key);
+		if (item == nullptr) {
+			error(line, "unknown key %s in [%s]", key, section);
+			continue;
 		}
+
+		if (!set(*this, *item, value))
+			error(line, "bad value \"%s\" for %s in [%s], using %s", value, key, section, format(*this, *item).c_str());
 	}
 
+	if (repeater)
+		checkRepeater();
+
 	::fclose(fp);
 
 	return true;
 }
 
+const std::vector<std::string>& CConf::getErrors() const
+{
+	return m_errors;
+}
+
+void CConf::diff(const CConf& conf, std::vector<std::string>& reloadable, std::vector<std::string>& restart) const
+{
+	for (unsigned int i = 0U; i < ITEM_COUNT; i++) {
+		const CConfItem<CConf>& item = ITEMS[i];
+
+		if (!equal(*this, conf, item)) {
+			std::string name = std::string("[") + item.m_section + "] " + item.m_key;
+			if (item.m_reload)
+				reloadable.push_back(name);
+			else
+				restart.push_back(name);
+		}
+	}
+
+	if (m_repeaters.size() != conf.m_repeaters.size()) {
+		restart.push_back("the number of [Repeater] sections");
+		return;
+	}
+
+	for (unsigned int n = 0U; n < m_repeaters.size(); n++) {
+		for (unsigned int i = 0U; i < REPEATER_ITEM_COUNT; i++) {
+			const CConfItem<CRepeaterConf>& item = REPEATER_ITEMS[i];
+
+			if (!equal(m_repeaters.at(n), conf.m_repeaters.at(n), item)) {
+				std::string name = "[" + m_repeaters.at(n).m_name + "] " + item.m_key;
+				if (item.m_reload)
+					reloadable.push_back(name);
+				else
+					restart.push_back(name);
+			}
+		}
+	}
+}
+
+void CConf::update(const CConf& conf)
+{
+	for (unsigned int i = 0U; i < ITEM_COUNT; i++) {
+		const CConfItem<CConf>& item = ITEMS[i];
+
+		if (item.m_reload)
+			copy(*this, conf, item);
+	}
+
+	// Repeaters added or removed need a restart, so there is nothing to take from them
+	if (m_repeaters.size() != conf.m_repeaters.size())
+		return;
+
+	for (unsigned int n = 0U; n < m_repeaters.size(); n++) {
+		for (unsigned int i = 0U; i < REPEATER_ITEM_COUNT; i++) {
+			const CConfItem<CRepeaterConf>& item = REPEATER_ITEMS[i];
+
+			if (item.m_reload)
+				copy(m_repeaters.at(n), conf.m_repeaters.at(n), item);
+		}
+	}
+}
+
+bool CConf::isSection(const char* section) const
+{
+	assert(section != nullptr);
+
+	for (unsigned int i = 0U; i < ITEM_COUNT; i++) {
+		if (::strcmp(ITEMS[i].m_section, section) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+const CConf::CConfItem<CConf>* CConf::find(const char* section, const char* key) const
+{
+	assert(section != nullptr);
+	assert(key != nullptr);
+
+	// Built on first use, an empty slot is -1
+	static int table[HASH_SIZE];
+	static bool built = false;
+
+	if (!built) {
+		for (unsigned int i = 0U; i < HASH_SIZE; i++)
+			table[i] = -1;
+
+		for (unsigned int i = 0U; i < ITEM_COUNT; i++) {
+			unsigned int h = hash(ITEMS[i].m_section, ITEMS[i].m_key);
+			while (table[h] != -1)
+				h = (h + 1U) & (HASH_SIZE - 1U);
+
+			table[h] = int(i);
+		}
+
+		built = true;
+	}
+
+	unsigned int h = hash(section, key);
+	while (table[h] != -1) {
+		const CConfItem<CConf>& item = ITEMS[table[h]];
+		if (::strcmp(item.m_key, key) == 0 && ::strcmp(item.m_section, section) == 0)
+			return &item;
+
+		h = (h + 1U) & (HASH_SIZE - 1U);
+	}
+
+	return nullptr;
+}
+
+const CConf::CConfItem<CRepeaterConf>* CConf::findRepeater(const char* key) const
+{
+	assert(key != nullptr);
+
+	for (unsigned int i = 0U; i < REPEATER_ITEM_COUNT; i++) {
+		if (::strcmp(REPEATER_ITEMS[i].m_key, key) == 0)
+			return &REPEATER_ITEMS[i];
+	}
+
+	return nullptr;
+}
+
+// Drops a repeater section which can't work, reported at the line of its header
+void CConf::checkRepeater()
+{
+	const CRepeaterConf& conf = m_repeaters.back();
+
+	if (conf.m_callsign.empty() || conf.m_rptPort == 0U || conf.m_localPort == 0U) {
+		error(conf.m_line, "[%s] needs a Callsign, RptPort and LocalPort, ignoring it", conf.m_name.c_str());
+		m_repeaters.pop_back();
+	}
+}
+
+template<class T> bool CConf::set(T& target, const CConfItem<T>& item, const char* value)
+{
+	assert(value != nullptr);
+
+	char* end = nullptr;
+
+	switch (item.m_type) {
+	case CONF_TYPE::STRING:
+		target.*item.m_string = value;
+		return true;
+
+	case CONF_TYPE::UPPER: {
+			std::string text = value;
+			for (std::string::iterator it = text.begin(); it != text.end(); ++it)
+				*it = ::toupper(*it);
+			target.*item.m_string = text;
+		}
+		return true;
+
+	case CONF_TYPE::REFLECTOR: {
+			std::string text = value;
+			std::replace(text.begin(), text.end(), '_', ' ');
+			text.resize(M17_CALLSIGN_LENGTH, ' ');
+			target.*item.m_string = text;
+		}
+		return true;
+
+	case CONF_TYPE::POLICY: {
+			std::string text = value;
+			for (std::string::iterator it = text.begin(); it != text.end(); ++it)
+				*it = ::toupper(*it);
+			if (text != "FIFO" && text != "RR")
+				return false;
+			target.*item.m_string = text;
+		}
+		return true;
+
+	case CONF_TYPE::BOOL:
+		if (::strcmp(value, "0") != 0 && ::strcmp(value, "1") != 0)
+			return false;
+		target.*item.m_bool = value[0U] == '1';
+		return true;
+
+	case CONF_TYPE::UINT:
+	case CONF_TYPE::USHORT: {
+			if (value[0U] == '-')
+				return false;
+
+			unsigned long n = ::strtoul(value, &end, 10);
+			if (end == value || *end != '\0' || n > ((item.m_type == CONF_TYPE::USHORT) ? 0xFFFFUL : 0xFFFFFFFFUL))
+				return false;
+
+			if (item.m_type == CONF_TYPE::USHORT)
+				target.*item.m_ushort = (unsigned short)n;
+			else
+				target.*item.m_uint = (unsigned int)n;
+		}
+		return true;
+
+	case CONF_TYPE::INT: {
+			long n = ::strtol(value, &end, 10);
+			if (end == value || *end != '\0' || n < -2147483647L || n > 2147483647L)
+				return false;
+			target.*item.m_int = int(n);
+		}
+		return true;
+
+	case CONF_TYPE::FLOAT: {
+			double n = ::strtod(value, &end);
+			if (end == value || *end != '\0')
+				return false;
+			target.*item.m_float = float(n);
+		}
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+template<class T> std::string CConf::format(const T& target, const CConfItem<T>& item)
+{
+	char text[50U];
+
+	switch (item.m_type) {
+	case CONF_TYPE::BOOL:
+		return (target.*item.m_bool) ? "1" : "0";
+	case CONF_TYPE::UINT:
+		::sprintf(text, "%u", target.*item.m_uint);
+		return text;
+	case CONF_TYPE::USHORT:
+		::sprintf(text, "%hu", target.*item.m_ushort);
+		return text;
+	case CONF_TYPE::INT:
+		::sprintf(text, "%d", target.*item.m_int);
+		return text;
+	case CONF_TYPE::FLOAT:
+		::sprintf(text, "%f", target.*item.m_float);
+		return text;
+	default:
+		return "\"" + target.*item.m_string + "\"";
+	}
+}
+
+template<class T> bool CConf::equal(const T& target1, const T& target2, const CConfItem<T>& item)
+{
+	switch (item.m_type) {
+	case CONF_TYPE::BOOL:
+		return target1.*item.m_bool == target2.*item.m_bool;
+	case CONF_TYPE::UINT:
+		return target1.*item.m_uint == target2.*item.m_uint;
+	case CONF_TYPE::USHORT:
+		return target1.*item.m_ushort == target2.*item.m_ushort;
+	case CONF_TYPE::INT:
+		return target1.*item.m_int == target2.*item.m_int;
+	case CONF_TYPE::FLOAT:
+		return target1.*item.m_float == target2.*item.m_float;
+	default:
+		return target1.*item.m_string == target2.*item.m_string;
+	}
+}
+
+template<class T> void CConf::copy(T& target, const T& source, const CConfItem<T>& item)
+{
+	switch (item.m_type) {
+	case CONF_TYPE::BOOL:
+		target.*item.m_bool = source.*item.m_bool;
+		break;
+	case CONF_TYPE::UINT:
+		target.*item.m_uint = source.*item.m_uint;
+		break;
+	case CONF_TYPE::USHORT:
+		target.*item.m_ushort = source.*item.m_ushort;
+		break;
+	case CONF_TYPE::INT:
+		target.*item.m_int = source.*item.m_int;
+		break;
+	case CONF_TYPE::FLOAT:
+		target.*item.m_float = source.*item.m_float;
+		break;
+	default:
+		target.*item.m_string = source.*item.m_string;
+		break;
+	}
+}
+
+void CConf::error(unsigned int line, const char* fmt, ...)
+{
+	assert(fmt != nullptr);
+
+	char text[BUFFER_SIZE + 200U];
+	int n = ::snprintf(text, sizeof(text), "%s:%u: ", m_file.c_str(), line);
+	if (n < 0 || n >= int(sizeof(text)))
+		n = 0;
+
+	va_list vl;
+	va_start(vl, fmt);
+	::vsnprintf(text + n, sizeof(text) - n, fmt, vl);
+	va_end(vl);
+
+	m_errors.push_back(text);
+}
+
+CRepeaterConf CConf::getRepeater() const
+{
+	CRepeaterConf conf;
+	conf.m_name        = "General";
+	conf.m_callsign    = m_callsign;
+	conf.m_suffix      = m_suffix;
+	conf.m_rptAddress  = m_rptAddress;
+	conf.m_rptPort     = m_rptPort;
+	conf.m_localPort   = m_myPort;
+	conf.m_networkPort = m_networkLocalPort;
+	conf.m_remotePort  = m_remoteCommandsEnabled ? m_remoteCommandsPort : 0U;
+	conf.m_hangTime    = m_networkHangTime;
+	conf.m_startup     = m_networkStartup;
+	conf.m_revert      = m_networkRevert;
+
+	return conf;
+}
+
+const std::vector<CRepeaterConf>& CConf::getRepeaters() const
+{
+	return m_repeaters;
+}
+
 std::string CConf::getCallsign() const
 {
 	return m_callsign;
@@ -352,6 +791,16 @@ bool CConf::getLogFileRotate() const
 	return m_logFileRotate;
 }
 
+bool CConf::getLogAsync() const
+{
+	return m_logAsync;
+}
+
+unsigned int CConf::getLogAsyncLength() const
+{
+	return m_logAsyncLength;
+}
+
 bool CConf::getAPRSEnabled() const
 {
 	return m_aprsEnabled;
@@ -451,3 +900,143 @@ unsigned short CConf::getRemoteCommandsPort() const
 {
 	return m_remoteCommandsPort;
 }
+
+bool CConf::getCaptureEnabled() const
+{
+	return m_captureEnabled;
+}
+
+std::string CConf::getCaptureFilePath() const
+{
+	return m_captureFilePath;
+}
+
+std::string CConf::getCaptureFileRoot() const
+{
+	return m_captureFileRoot;
+}
+
+unsigned int CConf::getCaptureMaxSize() const
+{
+	return m_captureMaxSize;
+}
+
+unsigned int CConf::getCaptureFiles() const
+{
+	return m_captureFiles;
+}
+
+bool CConf::getEventsEnabled() const
+{
+	return m_eventsEnabled;
+}
+
+std::string CConf::getEventsFile() const
+{
+	return m_eventsFile;
+}
+
+std::string CConf::getEventsSocket() const
+{
+	return m_eventsSocket;
+}
+
+bool CConf::getMetricsEnabled() const
+{
+	return m_metricsEnabled;
+}
+
+std::string CConf::getMetricsAddress() const
+{
+	return m_metricsAddress;
+}
+
+unsigned short CConf::getMetricsPort() const
+{
+	return m_metricsPort;
+}
+
+std::string CConf::getMetricsSocket() const
+{
+	return m_metricsSocket;
+}
+
+bool CConf::getControlEnabled() const
+{
+	return m_controlEnabled;
+}
+
+std::string CConf::getControlSocket() const
+{
+	return m_controlSocket;
+}
+
+unsigned int CConf::getControlStatsInterval() const
+{
+	return m_controlStatsInterval;
+}
+
+bool CConf::getFlightRecorderEnabled() const
+{
+	return m_flightRecorderEnabled;
+}
+
+std::string CConf::getFlightRecorderFilePath() const
+{
+	return m_flightRecorderFilePath;
+}
+
+std::string CConf::getFlightRecorderFileRoot() const
+{
+	return m_flightRecorderFileRoot;
+}
+
+unsigned int CConf::getFlightRecorderSeconds() const
+{
+	return m_flightRecorderSeconds;
+}
+
+unsigned int CConf::getWorkersCount() const
+{
+	return m_workersCount;
+}
+
+bool CConf::getWorkersPin() const
+{
+	return m_workersPin;
+}
+
+bool CConf::getIOThreadEnabled() const
+{
+	return m_ioThreadEnabled;
+}
+
+bool CConf::getRealTimeEnabled() const
+{
+	return m_realTimeEnabled;
+}
+
+std::string CConf::getRealTimePolicy() const
+{
+	return m_realTimePolicy;
+}
+
+unsigned int CConf::getRealTimePriority() const
+{
+	return m_realTimePriority;
+}
+
+int CConf::getRealTimeCPU() const
+{
+	return m_realTimeCPU;
+}
+
+bool CConf::getRealTimeLockMemory() const
+{
+	return m_realTimeLockMemory;
+}
+
+bool CConf::getRealTimePrefault() const
+{
+	return m_realTimePrefault;
+}
@@ -22,6 +22,25 @@
 #include <string>
 #include <vector>
 
+// A repeater served by the gateway. The first comes from the General,
+// Network and Remote Commands sections, any others from [Repeater n] sections.
+struct CRepeaterConf {
+	CRepeaterConf();
+
+	std::string    m_name;
+	std::string    m_callsign;
+	std::string    m_suffix;
+	std::string    m_rptAddress;
+	unsigned short m_rptPort;
+	unsigned short m_localPort;
+	unsigned short m_networkPort;
+	unsigned short m_remotePort;
+	unsigned int   m_hangTime;
+	std::string    m_startup;
+	bool           m_revert;
+	unsigned int   m_line;			// Of the section header, for the errors found after reading it
+};
+
 class CConf
 {
 public:
@@ -30,6 +49,16 @@ public:
 
 	bool read();
 
+	// The problems found by the last read, with their line numbers
+	const std::vector<std::string>& getErrors() const;
+
+	// The settings which differ from another configuration, split into those
+	// which can be applied while running and those which need a restart
+	void diff(const CConf& conf, std::vector<std::string>& reloadable, std::vector<std::string>& restart) const;
+
+	// Takes the settings which can be applied while running from another configuration
+	void update(const CConf& conf);
+
 	// The General section
 	std::string  getCallsign() const;
 	std::string  getSuffix() const;
@@ -39,6 +68,10 @@ public:
 	bool         getDebug() const;
 	bool         getDaemon() const;
 
+	// The first repeater, and those from the [Repeater n] sections
+	CRepeaterConf  getRepeater() const;
+	const std::vector<CRepeaterConf>& getRepeaters() const;
+
 	// The Info section
 	unsigned int getRxFrequency() const;
 	unsigned int getTxFrequency() const;
@@ -55,6 +88,8 @@ public:
 	std::string  getLogFilePath() const;
 	std::string  getLogFileRoot() const;
 	bool         getLogFileRotate() const;
+	bool         getLogAsync() const;
+	unsigned int getLogAsyncLength() const;
 
 	// The APRS section
 	bool         getAPRSEnabled() const;
@@ -84,6 +119,50 @@ public:
 	bool           getRemoteCommandsEnabled() const;
 	unsigned short getRemoteCommandsPort() const;
 
+	// The Capture section
+	bool           getCaptureEnabled() const;
+	std::string    getCaptureFilePath() const;
+	std::string    getCaptureFileRoot() const;
+	unsigned int   getCaptureMaxSize() const;
+	unsigned int   getCaptureFiles() const;
+
+	// The Events section
+	bool           getEventsEnabled() const;
+	std::string    getEventsFile() const;
+	std::string    getEventsSocket() const;
+
+	// The Metrics section
+	bool           getMetricsEnabled() const;
+	std::string    getMetricsAddress() const;
+	unsigned short getMetricsPort() const;
+	std::string    getMetricsSocket() const;
+
+	// The Control section
+	bool           getControlEnabled() const;
+	std::string    getControlSocket() const;
+	unsigned int   getControlStatsInterval() const;
+
+	// The Flight Recorder section
+	bool           getFlightRecorderEnabled() const;
+	std::string    getFlightRecorderFilePath() const;
+	std::string    getFlightRecorderFileRoot() const;
+	unsigned int   getFlightRecorderSeconds() const;
+
+	// The Workers section
+	unsigned int   getWorkersCount() const;
+	bool           getWorkersPin() const;
+
+	// The IO Thread section
+	bool           getIOThreadEnabled() const;
+
+	// The Real Time section
+	bool           getRealTimeEnabled() const;
+	std::string    getRealTimePolicy() const;
+	unsigned int   getRealTimePriority() const;
+	int            getRealTimeCPU() const;
+	bool           getRealTimeLockMemory() const;
+	bool           getRealTimePrefault() const;
+
 private:
 	std::string  m_file;
 	std::string  m_callsign;
@@ -108,6 +187,8 @@ private:
 	std::string  m_logFilePath;
 	std::string  m_logFileRoot;
 	bool         m_logFileRotate;
+	bool         m_logAsync;
+	unsigned int m_logAsyncLength;
 
 	bool         m_aprsEnabled;
 	std::string  m_aprsAddress;
@@ -132,6 +213,124 @@ private:
 
 	bool           m_remoteCommandsEnabled;
 	unsigned short m_remoteCommandsPort;
+
+	bool           m_captureEnabled;
+	std::string    m_captureFilePath;
+	std::string    m_captureFileRoot;
+	unsigned int   m_captureMaxSize;
+	unsigned int   m_captureFiles;
+
+	bool           m_eventsEnabled;
+	std::string    m_eventsFile;
+	std::string    m_eventsSocket;
+
+	bool           m_metricsEnabled;
+	std::string    m_metricsAddress;
+	unsigned short m_metricsPort;
+	std::string    m_metricsSocket;
+
+	bool           m_controlEnabled;
+	std::string    m_controlSocket;
+	unsigned int   m_controlStatsInterval;
+
+	bool           m_flightRecorderEnabled;
+	std::string    m_flightRecorderFilePath;
+	std::string    m_flightRecorderFileRoot;
+	unsigned int   m_flightRecorderSeconds;
+
+	unsigned int   m_workersCount;
+	bool           m_workersPin;
+
+	bool           m_ioThreadEnabled;
+
+	bool           m_realTimeEnabled;
+	std::string    m_realTimePolicy;
+	unsigned int   m_realTimePriority;
+	int            m_realTimeCPU;
+	bool           m_realTimeLockMemory;
+	bool           m_realTimePrefault;
+
+	std::vector<CRepeaterConf> m_repeaters;
+
+	std::vector<std::string> m_errors;
+
+	enum class CONF_TYPE {
+		STRING,
+		UPPER,
+		REFLECTOR,
+		POLICY,
+		BOOL,
+		UINT,
+		USHORT,
+		INT,
+		FLOAT
+	};
+
+	// Maps a section and key to a member of T, only the pointer for the type is set
+	template<class T> struct CConfItem {
+		CConfItem(const char* section, const char* key, bool reload, std::string T::* value, CONF_TYPE type = CONF_TYPE::STRING) :
+		m_section(section), m_key(key), m_type(type), m_reload(reload),
+		m_string(value), m_bool(nullptr), m_uint(nullptr), m_ushort(nullptr), m_int(nullptr), m_float(nullptr)
+		{
+		}
+
+		CConfItem(const char* section, const char* key, bool reload, bool T::* value) :
+		m_section(section), m_key(key), m_type(CONF_TYPE::BOOL), m_reload(reload),
+		m_string(nullptr), m_bool(value), m_uint(nullptr), m_ushort(nullptr), m_int(nullptr), m_float(nullptr)
+		{
+		}
+
+		CConfItem(const char* section, const char* key, bool reload, unsigned int T::* value) :
+		m_section(section), m_key(key), m_type(CONF_TYPE::UINT), m_reload(reload),
+		m_string(nullptr), m_bool(nullptr), m_uint(value), m_ushort(nullptr), m_int(nullptr), m_float(nullptr)
+		{
+		}
+
+		CConfItem(const char* section, const char* key, bool reload, unsigned short T::* value) :
+		m_section(section), m_key(key), m_type(CONF_TYPE::USHORT), m_reload(reload),
+		m_string(nullptr), m_bool(nullptr), m_uint(nullptr), m_ushort(value), m_int(nullptr), m_float(nullptr)
+		{
+		}
+
+		CConfItem(const char* section, const char* key, bool reload, int T::* value) :
+		m_section(section), m_key(key), m_type(CONF_TYPE::INT), m_reload(reload),
+		m_string(nullptr), m_bool(nullptr), m_uint(nullptr), m_ushort(nullptr), m_int(value), m_float(nullptr)
+		{
+		}
+
+		CConfItem(const char* section, const char* key, bool reload, float T::* value) :
+		m_section(section), m_key(key), m_type(CONF_TYPE::FLOAT), m_reload(reload),
+		m_string(nullptr), m_bool(nullptr), m_uint(nullptr), m_ushort(nullptr), m_int(nullptr), m_float(value)
+		{
+		}
+
+		const char*          m_section;
+		const char*          m_key;
+		CONF_TYPE            m_type;
+		bool                 m_reload;
+		std::string T::*     m_string;
+		bool T::*            m_bool;
+		unsigned int T::*    m_uint;
+		unsigned short T::*  m_ushort;
+		int T::*             m_int;
+		float T::*           m_float;
+	};
+
+	static const CConfItem<CConf>         ITEMS[];
+	static const unsigned int             ITEM_COUNT;
+	static const CConfItem<CRepeaterConf> REPEATER_ITEMS[];
+	static const unsigned int             REPEATER_ITEM_COUNT;
+
+	bool isSection(const char* section) const;
+	const CConfItem<CConf>* find(const char* section, const char* key) const;
+	const CConfItem<CRepeaterConf>* findRepeater(const char* key) const;
+	void checkRepeater();
+
+	template<class T> static bool set(T& target, const CConfItem<T>& item, const char* value);
+	template<class T> static bool equal(const T& target1, const T& target2, const CConfItem<T>& item);
+	template<class T> static void copy(T& target, const T& source, const CConfItem<T>& item);
+	template<class T> static std::string format(const T& target, const CConfItem<T>& item);
+	void error(unsigned int line, const char* fmt, ...);
 };
 
 #endif
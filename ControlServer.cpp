@@ -0,0 +1,325 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "ControlServer.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// A client that goes away must not raise SIGPIPE
+#if defined(MSG_NOSIGNAL)
+const int SEND_FLAGS = MSG_NOSIGNAL | MSG_DONTWAIT;
+#elif defined(MSG_DONTWAIT)
+const int SEND_FLAGS = MSG_DONTWAIT;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+const unsigned int QUEUE_LENGTH = 256U;
+const int POLL_TIME = 20;			// ms, the longest an event waits to be pushed
+
+static const struct {
+	const char*  m_name;
+	unsigned int m_type;
+} EVENT_NAMES[] = {
+	{"link",   EVENT_LINK},
+	{"stream", EVENT_STREAM},
+	{"echo",   EVENT_ECHO},
+	{"voice",  EVENT_VOICE},
+	{"stats",  EVENT_STATS},
+	{"all",    EVENT_ALL}
+};
+
+CControlServer::CControlServer(const std::string& socket) :
+CThread(),
+m_socket(socket),
+m_queue(QUEUE_LENGTH),
+m_killed(false),
+m_dropped(0U),
+m_fd(-1),
+m_clients(),
+m_count(0U)
+{
+}
+
+CControlServer::~CControlServer()
+{
+}
+
+bool CControlServer::open()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	LogError("Control, Unix sockets are not supported");
+	return false;
+#else
+	sockaddr_un addr;
+	if (m_socket.empty() || m_socket.size() >= sizeof(addr.sun_path)) {
+		LogError("Control, the socket path is invalid - %s", m_socket.c_str());
+		return false;
+	}
+
+	::memset(&addr, 0x00U, sizeof(sockaddr_un));
+	addr.sun_family = AF_UNIX;
+	::strcpy(addr.sun_path, m_socket.c_str());
+
+	m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_fd < 0) {
+		LogError("Control, cannot create the Unix socket, err: %d", errno);
+		return false;
+	}
+
+	// A socket left by an earlier run
+	::unlink(m_socket.c_str());
+
+	if (::bind(m_fd, (sockaddr*)&addr, sizeof(sockaddr_un)) == -1 || ::listen(m_fd, 5) == -1) {
+		LogError("Control, cannot listen on %s, err: %d", m_socket.c_str(), errno);
+		::close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+
+	LogMessage("Control, listening on %s", m_socket.c_str());
+
+	return run();
+#endif
+}
+
+void CControlServer::write(const CEventRecord& record)
+{
+	if (!m_queue.push(record))
+		m_dropped++;
+}
+
+void CControlServer::close()
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+	m_killed.store(true);
+
+	wait();
+
+	while (m_count > 0U)
+		remove(0U);
+
+	if (m_fd >= 0) {
+		::close(m_fd);
+		m_fd = -1;
+	}
+
+	::unlink(m_socket.c_str());
+
+	unsigned int dropped = m_dropped.load();
+	if (dropped > 0U)
+		LogWarning("Control, %u events were dropped", dropped);
+#endif
+}
+
+unsigned int CControlServer::getDropped() const
+{
+	return m_dropped.load();
+}
+
+void CControlServer::entry()
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+	while (!m_killed.load()) {
+		struct pollfd pfds[CONTROL_MAX_CLIENTS + 1U];
+
+		pfds[0U].fd      = m_fd;
+		pfds[0U].events  = POLLIN;
+		pfds[0U].revents = 0;
+
+		unsigned int count = m_count;
+		for (unsigned int i = 0U; i < count; i++) {
+			pfds[i + 1U].fd      = m_clients[i].m_fd;
+			pfds[i + 1U].events  = POLLIN;
+			pfds[i + 1U].revents = 0;
+		}
+
+		int ret = ::poll(pfds, count + 1U, POLL_TIME);
+		if (ret > 0) {
+			// Backwards so that removing a client doesn't move one not yet looked at
+			for (unsigned int i = count; i > 0U; i--) {
+				if ((pfds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0 && !receive(m_clients[i - 1U]))
+					remove(i - 1U);
+			}
+
+			if ((pfds[0U].revents & POLLIN) != 0)
+				accept();
+		}
+
+		drain();
+	}
+#endif
+}
+
+void CControlServer::accept()
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+	int fd = ::accept(m_fd, nullptr, nullptr);
+	if (fd < 0)
+		return;
+
+	if (m_count >= CONTROL_MAX_CLIENTS) {
+		LogWarning("Control, too many clients, refusing a connection");
+		::close(fd);
+		return;
+	}
+
+	::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	CControlClient& client = m_clients[m_count++];
+	client.m_fd     = fd;
+	client.m_mask   = 0U;
+	client.m_length = 0U;
+
+	LogMessage("Control, client connected, %u connected", m_count);
+#endif
+}
+
+bool CControlServer::receive(CControlClient& client)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	return false;
+#else
+	char buffer[CONTROL_LINE_LENGTH];
+	ssize_t n = ::recv(client.m_fd, buffer, CONTROL_LINE_LENGTH, MSG_DONTWAIT);
+	if (n == 0)
+		return false;
+	if (n < 0)
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+	for (ssize_t i = 0; i < n; i++) {
+		char c = buffer[i];
+		if (c == '\n' || c == '\r') {
+			client.m_line[client.m_length] = '\0';
+			if (client.m_length > 0U && !command(client, client.m_line))
+				return false;
+			client.m_length = 0U;
+		} else if (client.m_length < (CONTROL_LINE_LENGTH - 1U)) {
+			client.m_line[client.m_length++] = c;
+		} else {
+			// An overlong line is thrown away
+			client.m_length = 0U;
+			if (!send(client, "error:line too long\n", 20U))
+				return false;
+		}
+	}
+
+	return true;
+#endif
+}
+
+bool CControlServer::command(CControlClient& client, const char* line)
+{
+	assert(line != nullptr);
+
+	if (::strcmp(line, "unsubscribe") == 0) {
+		client.m_mask = 0U;
+		return send(client, "ok\n", 3U);
+	}
+
+	if (::strncmp(line, "subscribe", 9U) != 0 || (line[9U] != '\0' && line[9U] != ' '))
+		return send(client, "error:unknown command\n", 22U);
+
+	const char* p = line + 9U;
+	while (*p == ' ')
+		p++;
+
+	// With no list every type is wanted
+	if (*p == '\0') {
+		client.m_mask = EVENT_ALL;
+		return send(client, "ok\n", 3U);
+	}
+
+	unsigned int mask = 0U;
+	while (*p != '\0') {
+		size_t len = ::strcspn(p, ", ");
+
+		unsigned int type = 0U;
+		for (unsigned int i = 0U; i < (sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0U])); i++) {
+			if (::strlen(EVENT_NAMES[i].m_name) == len && ::strncmp(p, EVENT_NAMES[i].m_name, len) == 0)
+				type = EVENT_NAMES[i].m_type;
+		}
+
+		if (type == 0U)
+			return send(client, "error:unknown event type\n", 25U);
+
+		mask |= type;
+
+		p += len;
+		while (*p == ',' || *p == ' ')
+			p++;
+	}
+
+	client.m_mask = mask;
+
+	return send(client, "ok\n", 3U);
+}
+
+bool CControlServer::send(CControlClient& client, const char* text, unsigned int length)
+{
+	assert(text != nullptr);
+
+#if defined(_WIN32) || defined(_WIN64)
+	return false;
+#else
+	// A short write would leave half a line in the stream, so the client goes
+	ssize_t n = ::send(client.m_fd, text, length, SEND_FLAGS);
+	if (n != ssize_t(length)) {
+		LogWarning("Control, dropping a client which is not reading");
+		return false;
+	}
+
+	return true;
+#endif
+}
+
+void CControlServer::remove(unsigned int n)
+{
+	assert(n < m_count);
+
+#if !defined(_WIN32) && !defined(_WIN64)
+	::close(m_clients[n].m_fd);
+#endif
+
+	m_clients[n] = m_clients[--m_count];
+
+	LogMessage("Control, client disconnected, %u connected", m_count);
+}
+
+void CControlServer::drain()
+{
+	CEventRecord record;
+	while (m_queue.pop(record)) {
+		for (unsigned int i = m_count; i > 0U; i--) {
+			CControlClient& client = m_clients[i - 1U];
+			if ((client.m_mask & record.m_type) != 0U && !send(client, record.m_text, record.m_length))
+				remove(i - 1U);
+		}
+	}
+}
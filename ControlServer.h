@@ -0,0 +1,76 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	ControlServer_H
+#define	ControlServer_H
+
+#include "LockFreeQueue.h"
+#include "EventLog.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <string>
+
+const unsigned int CONTROL_MAX_CLIENTS = 16U;
+const unsigned int CONTROL_LINE_LENGTH = 100U;
+
+struct CControlClient {
+	int          m_fd;
+	unsigned int m_mask;
+	unsigned int m_length;
+	char         m_line[CONTROL_LINE_LENGTH];
+};
+
+// Pushes the events to any number of local clients on a Unix stream socket.
+// A client sends "subscribe" with an optional list of event types and then
+// receives the matching events as JSON lines. The main loop only queues the
+// records, the accepting, parsing and fan-out all happen on this thread, and
+// a client that cannot keep up is disconnected rather than waited for.
+class CControlServer : public CThread {
+public:
+	CControlServer(const std::string& socket);
+	virtual ~CControlServer();
+
+	bool open();
+
+	void write(const CEventRecord& record);
+
+	void close();
+
+	unsigned int getDropped() const;
+
+	virtual void entry();
+
+private:
+	std::string                  m_socket;
+	CLockFreeQueue<CEventRecord> m_queue;
+	std::atomic<bool>            m_killed;
+	std::atomic<unsigned int>    m_dropped;
+	int                          m_fd;
+	CControlClient               m_clients[CONTROL_MAX_CLIENTS];
+	unsigned int                 m_count;
+
+	void accept();
+	bool receive(CControlClient& client);
+	bool command(CControlClient& client, const char* line);
+	bool send(CControlClient& client, const char* text, unsigned int length);
+	void remove(unsigned int n);
+	void drain();
+};
+
+#endif
@@ -18,102 +18,329 @@
 
 #include "Echo.h"
 #include "M17Defines.h"
+#include "EventLog.h"
+#include "M17Utils.h"
+#include "Log.h"
 
 #include <cstdio>
 #include <cassert>
 #include <cstring>
 
-CEcho::CEcho(unsigned int timeout) :
-m_data(nullptr),
-m_length(timeout * 25U * M17_NETWORK_FRAME_LENGTH),
-m_used(0U),
+// One second of audio per chunk
+const unsigned int CHUNK_FRAMES = 25U;
+const unsigned int CHUNK_LENGTH = CHUNK_FRAMES * M17_NETWORK_FRAME_LENGTH;
+
+const unsigned int MAX_SESSIONS = 8U;
+
+const unsigned int PLAYBACK_DELAY = 2000U;	// From the end of a recording to its playback
+const unsigned int PLAYBACK_GAP   = 1000U;	// Between the end of one playback and the start of the next
+const unsigned int RECORD_TIMEOUT = 1000U;	// Without frames before a recording is ended
+
+CEchoSession::CEchoSession(const unsigned char* source, uint16_t id) :
+m_id(id),
+m_chunks(),
+m_frames(0U),
 m_sent(0U),
-m_status(ECHO_STATUS::NONE),
+m_status(ECHO_STATUS::RECORDING),
+m_lastFrame(0ULL),
+m_ready(0ULL)
+{
+	assert(source != nullptr);
+
+	::memcpy(m_source, source, 6U);
+}
+
+CEcho::CEcho(const std::string& name, unsigned int timeout) :
+m_maxFrames(timeout * 25U),
+m_sessions(),
+m_queue(),
+m_playing(nullptr),
+m_pool(),
+m_allocated(0U),
+m_reserved(0U),
+m_peakBytes(0U),
+m_now(0ULL),
+m_lastEnd(0ULL),
+m_rejected(0U),
 m_stopWatch(),
-m_timer(1000U, 2U)
+m_events(nullptr),
+m_sessionsMetric(CMetrics::counter("m17gateway_echo_sessions_total", "Echo recordings started", CMetrics::labelsFor(name))),
+m_rejectedMetric(CMetrics::counter("m17gateway_echo_rejected_total", "Echo recordings refused because of too many sessions", CMetrics::labelsFor(name))),
+m_playedMetric(CMetrics::counter("m17gateway_echo_frames_played_total", "Echo frames played back", CMetrics::labelsFor(name))),
+m_bytesMetric(CMetrics::gauge("m17gateway_echo_bytes", "Memory held by the echo recordings", CMetrics::labelsFor(name)))
 {
 	assert(timeout > 0U);
-
-	m_data = new unsigned char[m_length];
 }
 
 CEcho::~CEcho()
 {
-	delete[] m_data;
+	while (!m_sessions.empty())
+		remove(m_sessions.front());
+
+	m_reserved = 0U;
+	release();
 }
 
-bool CEcho::write(const unsigned char* data)
+void CEcho::setEvents(CEventLog* events)
 {
-	assert(data != nullptr);
+	m_events = events;
+}
 
-	if ((m_length - m_used) < M17_NETWORK_FRAME_LENGTH)
-		return false;
+void CEcho::prefault()
+{
+	unsigned int chunks = (m_maxFrames + CHUNK_FRAMES - 1U) / CHUNK_FRAMES;
+
+	m_sessions.reserve(MAX_SESSIONS);
+	m_pool.reserve(chunks);
 
-	::memcpy(m_data + m_used, data, M17_NETWORK_FRAME_LENGTH);
-	m_used += M17_NETWORK_FRAME_LENGTH;
+	while (m_allocated < chunks) {
+		unsigned char* chunk = new unsigned char[CHUNK_LENGTH];
+		::memset(chunk, 0x00U, CHUNK_LENGTH);
 
-	m_status = ECHO_STATUS::RECORDING;
+		m_pool.push_back(chunk);
+		m_allocated++;
+	}
+
+	m_reserved = chunks;
 
-	return true;
+	m_bytesMetric.set(getCurrentBytes());
 }
 
-void CEcho::end()
+bool CEcho::write(const unsigned char* data)
 {
-	m_sent = 0U;
+	assert(data != nullptr);
 
-	m_status = ECHO_STATUS::WAITING;
+	uint16_t id = (data[4U] << 8) + (data[5U] << 0);
 
-	m_timer.start();
-}
+	CEchoSession* session = find(data + 12U, id);
+	if (session == nullptr) {
+		if (m_sessions.size() >= MAX_SESSIONS) {
+			if (id != m_rejected) {
+				LogWarning("Echo, too many sessions, ignoring %s", CM17Utils::decodeCallsign(data + 12U).c_str());
+				m_rejected = id;
+				m_rejectedMetric.inc();
+			}
 
-void CEcho::clear()
-{
-	m_sent = 0U;
-	m_used = 0U;
+			return false;
+		}
+
+		session = new CEchoSession(data + 12U, id);
+		m_sessions.push_back(session);
+
+		m_sessionsMetric.inc();
 
-	m_status = ECHO_STATUS::NONE;
+		LogDebug("Echo, recording %s, stream id %04X", CM17Utils::decodeCallsign(data + 12U).c_str(), id);
 
-	m_timer.stop();
+		if (m_events != nullptr) {
+			char source[M17_CALLSIGN_LENGTH + 2U];
+			CM17Utils::decodeCallsign(data + 12U, source);
+			m_events->echo("recording", id, source, 0U, 0U);
+		}
+	}
+
+	if (session->m_status != ECHO_STATUS::RECORDING)
+		return false;
+
+	session->m_lastFrame = m_now;
+
+	bool ret = false;
+	if (session->m_frames < m_maxFrames) {
+		unsigned int index  = session->m_frames / CHUNK_FRAMES;
+		unsigned int offset = (session->m_frames % CHUNK_FRAMES) * M17_NETWORK_FRAME_LENGTH;
+
+		if (index >= session->m_chunks.size()) {
+			// Take a chunk from the pool if we can, otherwise grow
+			if (!m_pool.empty()) {
+				session->m_chunks.push_back(m_pool.back());
+				m_pool.pop_back();
+			} else {
+				session->m_chunks.push_back(new unsigned char[CHUNK_LENGTH]);
+				m_allocated++;
+				m_bytesMetric.set(getCurrentBytes());
+
+				unsigned int bytes = getCurrentBytes();
+				if (bytes > m_peakBytes)
+					m_peakBytes = bytes;
+			}
+		}
+
+		::memcpy(session->m_chunks.at(index) + offset, data, M17_NETWORK_FRAME_LENGTH);
+		session->m_frames++;
+
+		ret = true;
+	}
+
+	if ((data[34U] & 0x80U) == 0x80U)
+		endRecording(session);
+
+	return ret;
 }
 
 ECHO_STATE CEcho::read(unsigned char* data)
 {
 	assert(data != nullptr);
 
-	if (m_status != ECHO_STATUS::PLAYING)
+	if (m_playing == nullptr)
 		return ECHO_STATE::NONE;
 
-	if (m_used == 0U) {
-		m_status = ECHO_STATUS::NONE;
-		return ECHO_STATE::END;
-	}
-
-	unsigned int wanted = m_stopWatch.elapsed() / 40U;
-	if (m_sent >= wanted)
+	unsigned int wanted = m_stopWatch.elapsed() / M17_FRAME_TIME;
+	if (m_playing->m_sent >= wanted)
 		return ECHO_STATE::NONE;
 
-	unsigned int ptr = m_sent * M17_NETWORK_FRAME_LENGTH;
+	if (m_playing->m_sent >= m_playing->m_frames) {
+		if (m_events != nullptr) {
+			char source[M17_CALLSIGN_LENGTH + 2U];
+			CM17Utils::decodeCallsign(m_playing->m_source, source);
+			m_events->echo("played", m_playing->m_id, source, m_playing->m_sent, 0U);
+		}
+
+		remove(m_playing);
+		m_playing = nullptr;
+
+		m_lastEnd = m_now;
+
+		LogDebug("Echo, %u bytes used, peak %u bytes", getCurrentBytes(), m_peakBytes);
+
+		// Give the memory back once nothing is waiting to be played
+		if (m_sessions.empty())
+			release();
 
-	if (ptr >= m_used) {
-		m_used   = 0U;
-		m_status = ECHO_STATUS::NONE;
 		return ECHO_STATE::END;
 	}
 
-	::memcpy(data, m_data + ptr, M17_NETWORK_FRAME_LENGTH);
+	unsigned int index  = m_playing->m_sent / CHUNK_FRAMES;
+	unsigned int offset = (m_playing->m_sent % CHUNK_FRAMES) * M17_NETWORK_FRAME_LENGTH;
+
+	::memcpy(data, m_playing->m_chunks.at(index) + offset, M17_NETWORK_FRAME_LENGTH);
+
+	m_playing->m_sent++;
 
-	m_sent++;
+	m_playedMetric.inc();
 
 	return ECHO_STATE::DATA;
 }
 
 void CEcho::clock(unsigned int ms)
 {
-	m_timer.clock(ms);
-	if (m_timer.isRunning() && m_timer.hasExpired()) {
-		m_status = ECHO_STATUS::PLAYING;
-		m_sent   = 0U;
-		m_stopWatch.start();
-		m_timer.stop();
+	m_now += ms;
+
+	// Recordings whose end was lost
+	for (std::vector<CEchoSession*>::iterator it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+		CEchoSession* session = *it;
+		if (session->m_status == ECHO_STATUS::RECORDING && (m_now - session->m_lastFrame) >= RECORD_TIMEOUT) {
+			endRecording(session);
+			break;
+		}
+	}
+
+	if (m_playing != nullptr || m_queue.empty())
+		return;
+
+	// Only one playback at a time, with a gap between them on RF
+	CEchoSession* session = m_queue.front();
+	if (m_now < session->m_ready)
+		return;
+	if (m_lastEnd > 0ULL && (m_now - m_lastEnd) < PLAYBACK_GAP)
+		return;
+
+	m_queue.pop_front();
+
+	char source[M17_CALLSIGN_LENGTH + 2U];
+	CM17Utils::decodeCallsign(session->m_source, source);
+
+	LogMessage("Echo, playing back %u frames from %s after queueing for %llu ms", session->m_frames, source, m_now - session->m_ready);
+
+	if (m_events != nullptr)
+		m_events->echo("playing", session->m_id, source, session->m_frames, (unsigned int)(m_now - session->m_ready));
+
+	session->m_status = ECHO_STATUS::PLAYING;
+	session->m_sent   = 0U;
+
+	m_playing = session;
+	m_stopWatch.start();
+}
+
+bool CEcho::isBusy() const
+{
+	return !m_sessions.empty();
+}
+
+unsigned int CEcho::getSessionCount() const
+{
+	return (unsigned int)m_sessions.size();
+}
+
+unsigned int CEcho::getCurrentBytes() const
+{
+	return m_allocated * CHUNK_LENGTH;
+}
+
+unsigned int CEcho::getPeakBytes() const
+{
+	return m_peakBytes;
+}
+
+CEchoSession* CEcho::find(const unsigned char* source, uint16_t id) const
+{
+	for (std::vector<CEchoSession*>::const_iterator it = m_sessions.cbegin(); it != m_sessions.cend(); ++it) {
+		if ((*it)->m_id == id && ::memcmp((*it)->m_source, source, 6U) == 0)
+			return *it;
 	}
+
+	return nullptr;
+}
+
+void CEcho::endRecording(CEchoSession* session)
+{
+	assert(session != nullptr);
+
+	if (session->m_frames == 0U) {
+		remove(session);
+		return;
+	}
+
+	session->m_status = ECHO_STATUS::WAITING;
+	session->m_ready  = m_now + PLAYBACK_DELAY;
+
+	m_queue.push_back(session);
+}
+
+void CEcho::remove(CEchoSession* session)
+{
+	assert(session != nullptr);
+
+	// Keep the chunks for the next recording
+	for (std::vector<unsigned char*>::iterator it = session->m_chunks.begin(); it != session->m_chunks.end(); ++it)
+		m_pool.push_back(*it);
+
+	for (std::deque<CEchoSession*>::iterator it = m_queue.begin(); it != m_queue.end(); ++it) {
+		if (*it == session) {
+			m_queue.erase(it);
+			break;
+		}
+	}
+
+	for (std::vector<CEchoSession*>::iterator it = m_sessions.begin(); it != m_sessions.end(); ++it) {
+		if (*it == session) {
+			m_sessions.erase(it);
+			break;
+		}
+	}
+
+	delete session;
+}
+
+void CEcho::release()
+{
+	// Those touched at startup are kept
+	while (m_pool.size() > m_reserved) {
+		delete[] m_pool.back();
+		m_pool.pop_back();
+		m_allocated--;
+	}
+
+	m_bytesMetric.set(getCurrentBytes());
+
+	if (m_reserved == 0U)
+		std::vector<unsigned char*>().swap(m_pool);
 }
@@ -20,8 +20,16 @@
 #define	Echo_H
 
 #include "StopWatch.h"
+#include "Metrics.h"
 #include "Timer.h"
 
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+
+class CEventLog;
+
 enum class ECHO_STATE {
 	NONE,
 	DATA,
@@ -35,30 +43,67 @@ enum class ECHO_STATUS {
 	PLAYING
 };
 
+class CEchoSession {
+public:
+	CEchoSession(const unsigned char* source, uint16_t id);
+
+	unsigned char      m_source[6U];
+	uint16_t           m_id;
+	std::vector<unsigned char*> m_chunks;
+	unsigned int       m_frames;
+	unsigned int       m_sent;
+	ECHO_STATUS        m_status;
+	unsigned long long m_lastFrame;
+	unsigned long long m_ready;
+};
+
 class CEcho
 {
 public:
-	CEcho(unsigned int timeout);
+	CEcho(const std::string& name, unsigned int timeout);
 	~CEcho();
 
+	void setEvents(CEventLog* events);
+
+	// Allocates and touches the memory for the longest recording now, and keeps it
+	void prefault();
+
 	bool write(const unsigned char* data);
 
 	ECHO_STATE read(unsigned char* data);
 
-	void end();
+	void clock(unsigned int ms);
+
+	bool isBusy() const;
 
-	void clear();
+	unsigned int getSessionCount() const;
 
-	void clock(unsigned int ms);
+	unsigned int getCurrentBytes() const;
+	unsigned int getPeakBytes() const;
 
 private:
-	unsigned char* m_data;
-	unsigned int   m_length;
-	unsigned int   m_used;
-	unsigned int   m_sent;
-	ECHO_STATUS    m_status;
-	CStopWatch     m_stopWatch;
-	CTimer         m_timer;
+	unsigned int                m_maxFrames;
+	std::vector<CEchoSession*>  m_sessions;
+	std::deque<CEchoSession*>   m_queue;
+	CEchoSession*               m_playing;
+	std::vector<unsigned char*> m_pool;
+	unsigned int                m_allocated;
+	unsigned int                m_reserved;
+	unsigned int                m_peakBytes;
+	unsigned long long          m_now;
+	unsigned long long          m_lastEnd;
+	uint16_t                    m_rejected;
+	CStopWatch                  m_stopWatch;
+	CEventLog*                  m_events;
+	CMetricCounter&             m_sessionsMetric;
+	CMetricCounter&             m_rejectedMetric;
+	CMetricCounter&             m_playedMetric;
+	CMetricGauge&               m_bytesMetric;
+
+	CEchoSession* find(const unsigned char* source, uint16_t id) const;
+	void endRecording(CEchoSession* session);
+	void remove(CEchoSession* session);
+	void release();
 };
 
 #endif
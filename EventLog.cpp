@@ -0,0 +1,343 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "EventLog.h"
+#include "ControlServer.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <Windows.h>
+#else
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+const unsigned int QUEUE_LENGTH = 128U;
+
+static const char* DIRECTIONS[] = { "rf", "net" };
+
+static unsigned long long timestamp()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	FILETIME ft;
+	::GetSystemTimeAsFileTime(&ft);
+
+	unsigned long long t = (((unsigned long long)ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+
+	return (t - 116444736000000000ULL) / 10000ULL;
+#else
+	struct timeval now;
+	::gettimeofday(&now, nullptr);
+
+	return now.tv_sec * 1000ULL + now.tv_usec / 1000ULL;
+#endif
+}
+
+// Copies a string into a JSON string value, escaping as needed
+static const char* escape(const char* in, char* out, unsigned int length)
+{
+	assert(in != nullptr);
+	assert(out != nullptr);
+
+	unsigned int n = 0U;
+	for (; *in != '\0' && n < (length - 7U); in++) {
+		unsigned char c = *in;
+		if (c == '"' || c == '\\') {
+			out[n++] = '\\';
+			out[n++] = c;
+		} else if (c < 0x20U) {
+			n += ::sprintf(out + n, "\\u%04X", c);
+		} else {
+			out[n++] = c;
+		}
+	}
+
+	out[n] = '\0';
+
+	return out;
+}
+
+// The repeater field, which is left out when there is only one repeater
+static const char* repeaterField(const char* repeater, char* out)
+{
+	assert(repeater != nullptr);
+	assert(out != nullptr);
+
+	if (*repeater == '\0') {
+		*out = '\0';
+		return out;
+	}
+
+	char name[50U];
+	::sprintf(out, ",\"repeater\":\"%s\"", escape(repeater, name, 50U));
+
+	return out;
+}
+
+CEventLog::CEventLog(const std::string& file, const std::string& socket) :
+CThread(),
+m_file(file),
+m_socket(socket),
+m_queue(QUEUE_LENGTH),
+m_killed(false),
+m_dropped(0U),
+m_control(nullptr),
+m_started(false),
+m_fp(nullptr),
+m_fd(-1)
+{
+}
+
+CEventLog::~CEventLog()
+{
+}
+
+void CEventLog::setControl(CControlServer* control)
+{
+	m_control = control;
+}
+
+bool CEventLog::open()
+{
+	if (!m_socket.empty()) {
+#if defined(_WIN32) || defined(_WIN64)
+		LogError("Events, Unix sockets are not supported");
+		return false;
+#else
+		if (m_socket.size() >= sizeof(((sockaddr_un*)nullptr)->sun_path)) {
+			LogError("Events, the socket path is too long - %s", m_socket.c_str());
+			return false;
+		}
+
+		m_fd = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+		if (m_fd < 0) {
+			LogError("Events, cannot create the Unix socket, err: %d", errno);
+			return false;
+		}
+
+		LogMessage("Events, sending to %s", m_socket.c_str());
+#endif
+	} else if (!m_file.empty()) {
+		m_fp = ::fopen(m_file.c_str(), "at");
+		if (m_fp == nullptr) {
+			LogError("Events, unable to open %s", m_file.c_str());
+			return false;
+		}
+
+		LogMessage("Events, writing to %s", m_file.c_str());
+	} else if (m_control != nullptr) {
+		// Only feeding the control server, no thread is needed
+		return true;
+	} else {
+		LogError("Events, neither a file nor a socket has been configured");
+		return false;
+	}
+
+	m_started = run();
+
+	return m_started;
+}
+
+void CEventLog::linkState(const char* repeater, const char* state, const char* reflector)
+{
+	assert(state != nullptr);
+	assert(reflector != nullptr);
+
+	char rpt[80U], refl[50U];
+
+	CEventRecord record;
+	int length = ::snprintf(record.m_text, EVENT_TEXT_LENGTH, "{\"ts\":%llu,\"event\":\"link\"%s,\"state\":\"%s\",\"reflector\":\"%s\"}\n",
+		timestamp(), repeaterField(repeater, rpt), state, escape(reflector, refl, 50U));
+
+	write(EVENT_LINK, record, length);
+}
+
+void CEventLog::streamStart(const char* repeater, STREAM_DIRECTION direction, uint16_t id, const char* source, const char* dest)
+{
+	assert(source != nullptr);
+	assert(dest != nullptr);
+
+	char rpt[80U], src[50U], dst[50U];
+
+	CEventRecord record;
+	int length = ::snprintf(record.m_text, EVENT_TEXT_LENGTH, "{\"ts\":%llu,\"event\":\"stream_start\"%s,\"direction\":\"%s\",\"id\":%u,\"source\":\"%s\",\"dest\":\"%s\"}\n",
+		timestamp(), repeaterField(repeater, rpt), DIRECTIONS[int(direction)], id, escape(source, src, 50U), escape(dest, dst, 50U));
+
+	write(EVENT_STREAM, record, length);
+}
+
+void CEventLog::streamEnd(const char* repeater, STREAM_DIRECTION direction, uint16_t id, const char* source, const char* dest, unsigned int duration, unsigned int frames, unsigned int lost)
+{
+	assert(source != nullptr);
+	assert(dest != nullptr);
+
+	char rpt[80U], src[50U], dst[50U];
+
+	CEventRecord record;
+	int length = ::snprintf(record.m_text, EVENT_TEXT_LENGTH, "{\"ts\":%llu,\"event\":\"stream_end\"%s,\"direction\":\"%s\",\"id\":%u,\"source\":\"%s\",\"dest\":\"%s\",\"duration\":%u,\"frames\":%u,\"lost\":%u}\n",
+		timestamp(), repeaterField(repeater, rpt), DIRECTIONS[int(direction)], id, escape(source, src, 50U), escape(dest, dst, 50U), duration, frames, lost);
+
+	write(EVENT_STREAM, record, length);
+}
+
+void CEventLog::echo(const char* state, uint16_t id, const char* source, unsigned int frames, unsigned int queued)
+{
+	assert(state != nullptr);
+	assert(source != nullptr);
+
+	char src[50U];
+
+	CEventRecord record;
+	int length = ::snprintf(record.m_text, EVENT_TEXT_LENGTH, "{\"ts\":%llu,\"event\":\"echo\",\"state\":\"%s\",\"id\":%u,\"source\":\"%s\",\"frames\":%u,\"queued\":%u}\n",
+		timestamp(), state, id, escape(source, src, 50U), frames, queued);
+
+	write(EVENT_ECHO, record, length);
+}
+
+void CEventLog::voice(const char* state, const char* text)
+{
+	assert(state != nullptr);
+	assert(text != nullptr);
+
+	char txt[100U];
+
+	CEventRecord record;
+	int length = ::snprintf(record.m_text, EVENT_TEXT_LENGTH, "{\"ts\":%llu,\"event\":\"voice\",\"state\":\"%s\",\"text\":\"%s\"}\n",
+		timestamp(), state, escape(text, txt, 100U));
+
+	write(EVENT_VOICE, record, length);
+}
+
+void CEventLog::stats(const char* repeater, const char* state, const char* reflector, unsigned int seconds, const unsigned long long* network, const unsigned long long* local)
+{
+	assert(state != nullptr);
+	assert(reflector != nullptr);
+	assert(network != nullptr);
+	assert(local != nullptr);
+
+	if (m_control == nullptr)
+		return;
+
+	char rpt[80U], refl[50U];
+
+	CEventRecord record;
+	int length = ::snprintf(record.m_text, EVENT_TEXT_LENGTH, "{\"ts\":%llu,\"event\":\"stats\"%s,\"state\":\"%s\",\"reflector\":\"%s\",\"seconds\":%u,"
+		"\"net\":[%llu,%llu,%llu,%llu],\"rpt\":[%llu,%llu,%llu,%llu]}\n",
+		timestamp(), repeaterField(repeater, rpt), state, escape(reflector, refl, 50U), seconds, network[0U], network[1U], network[2U], network[3U], local[0U], local[1U], local[2U], local[3U]);
+
+	write(EVENT_STATS, record, length);
+}
+
+void CEventLog::close()
+{
+	m_killed.store(true);
+
+	if (m_started)
+		wait();
+
+	if (m_fp != nullptr) {
+		::fclose(m_fp);
+		m_fp = nullptr;
+	}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+	if (m_fd >= 0) {
+		::close(m_fd);
+		m_fd = -1;
+	}
+#endif
+
+	unsigned int dropped = m_dropped.load();
+	if (dropped > 0U)
+		LogWarning("Events, %u events were dropped", dropped);
+}
+
+unsigned int CEventLog::getDropped() const
+{
+	return m_dropped.load();
+}
+
+void CEventLog::write(unsigned int type, CEventRecord& record, int length)
+{
+	if (length <= 0)
+		return;
+
+	// A truncated record is still terminated
+	if (length >= int(EVENT_TEXT_LENGTH)) {
+		length = EVENT_TEXT_LENGTH - 1;
+		record.m_text[length - 1] = '\n';
+	}
+
+	record.m_type   = type;
+	record.m_length = (unsigned int)length;
+
+	if (m_control != nullptr)
+		m_control->write(record);
+
+	// The stats only go to the control server
+	if (!m_started || type == EVENT_STATS)
+		return;
+
+	if (!m_queue.push(record))
+		m_dropped++;
+}
+
+void CEventLog::entry()
+{
+	while (!m_killed.load()) {
+		if (!drain())
+			CThread::sleep(20U);
+	}
+
+	drain();
+}
+
+bool CEventLog::drain()
+{
+	bool written = false;
+
+	CEventRecord record;
+	while (m_queue.pop(record)) {
+		if (m_fp != nullptr) {
+			::fwrite(record.m_text, 1U, record.m_length, m_fp);
+		} else {
+#if !defined(_WIN32) && !defined(_WIN64)
+			sockaddr_un addr;
+			::memset(&addr, 0x00U, sizeof(sockaddr_un));
+			addr.sun_family = AF_UNIX;
+			::strcpy(addr.sun_path, m_socket.c_str());
+
+			// Nobody listening is not an error
+			::sendto(m_fd, record.m_text, record.m_length, MSG_DONTWAIT, (sockaddr*)&addr, sizeof(sockaddr_un));
+#endif
+		}
+
+		written = true;
+	}
+
+	if (written && m_fp != nullptr)
+		::fflush(m_fp);
+
+	return written;
+}
@@ -0,0 +1,100 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	EventLog_H
+#define	EventLog_H
+
+#include "LockFreeQueue.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+enum class STREAM_DIRECTION {
+	RF,
+	NET
+};
+
+const unsigned int EVENT_TEXT_LENGTH = 300U;
+
+// The event types, as bits so that a subscriber can choose several
+const unsigned int EVENT_LINK   = 0x01U;
+const unsigned int EVENT_STREAM = 0x02U;
+const unsigned int EVENT_ECHO   = 0x04U;
+const unsigned int EVENT_VOICE  = 0x08U;
+const unsigned int EVENT_STATS  = 0x10U;
+const unsigned int EVENT_ALL    = 0x1FU;
+
+struct CEventRecord {
+	unsigned int m_type;
+	unsigned int m_length;
+	char         m_text[EVENT_TEXT_LENGTH];
+};
+
+class CControlServer;
+
+// Writes typed events as newline delimited JSON to a file or to a Unix
+// datagram socket. The records are built in fixed buffers and handed to a
+// background thread, so nothing is allocated or written on the forwarding path.
+// The records are also handed to the control server when there is one.
+class CEventLog : public CThread {
+public:
+	CEventLog(const std::string& file, const std::string& socket);
+	virtual ~CEventLog();
+
+	void setControl(CControlServer* control);
+
+	bool open();
+
+	// The repeater is only named when the gateway serves more than one, and may be empty
+	void linkState(const char* repeater, const char* state, const char* reflector);
+
+	void streamStart(const char* repeater, STREAM_DIRECTION direction, uint16_t id, const char* source, const char* dest);
+	void streamEnd(const char* repeater, STREAM_DIRECTION direction, uint16_t id, const char* source, const char* dest, unsigned int duration, unsigned int frames, unsigned int lost);
+
+	void echo(const char* state, uint16_t id, const char* source, unsigned int frames, unsigned int queued);
+
+	void voice(const char* state, const char* text);
+
+	// Only for the control server, periodic stats don't belong in the log
+	void stats(const char* repeater, const char* state, const char* reflector, unsigned int seconds, const unsigned long long* network, const unsigned long long* local);
+
+	void close();
+
+	unsigned int getDropped() const;
+
+	virtual void entry();
+
+private:
+	std::string                  m_file;
+	std::string                  m_socket;
+	CLockFreeQueue<CEventRecord> m_queue;
+	std::atomic<bool>            m_killed;
+	std::atomic<unsigned int>    m_dropped;
+	CControlServer*              m_control;
+	bool                         m_started;
+	FILE*                        m_fp;
+	int                          m_fd;
+
+	void write(unsigned int type, CEventRecord& record, int length);
+	bool drain();
+};
+
+#endif
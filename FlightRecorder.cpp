@@ -0,0 +1,157 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "FlightRecorder.h"
+#include "StopWatch.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+// Frames in and out on both networks, at 25 frames a second
+const unsigned int RECORDS_PER_SECOND = 4U * 25U;
+
+// Between automatic dumps, so that a flapping link doesn't fill the disk
+const uint64_t DUMP_INTERVAL = 60ULL * 1000000000ULL;
+
+static const char* REASONS[] = { "signal", "linklost", "overflow" };
+
+CFlightRecorder::CFlightRecorder(const std::string& filePath, const std::string& fileRoot, unsigned int seconds) :
+m_filePath(filePath),
+m_fileRoot(fileRoot),
+m_records(nullptr),
+m_stamps(nullptr),
+m_mask(0ULL),
+m_head(0ULL),
+m_time(0ULL),
+m_lastDump(0ULL)
+{
+	assert(seconds > 0U);
+
+	// A power of two so that the index is a mask
+	uint64_t length = 1ULL;
+	while (length < (seconds * RECORDS_PER_SECOND))
+		length <<= 1;
+
+	m_records = new CFlightRecord[length];
+	m_stamps  = new std::atomic<uint64_t>[length];
+	m_mask    = length - 1ULL;
+
+	::memset(m_records, 0x00U, length * sizeof(CFlightRecord));
+	for (uint64_t i = 0ULL; i < length; i++)
+		m_stamps[i].store(0ULL, std::memory_order_relaxed);
+}
+
+CFlightRecorder::~CFlightRecorder()
+{
+	delete[] m_stamps;
+	delete[] m_records;
+}
+
+void CFlightRecorder::state(unsigned int oldState, unsigned int newState)
+{
+	uint64_t n = m_head.fetch_add(1ULL, std::memory_order_relaxed);
+	CFlightRecord& record = claim(n);
+
+	::memset(&record, 0x00U, sizeof(CFlightRecord));
+
+	record.m_timestamp = m_time.load(std::memory_order_relaxed);
+	record.m_type      = uint8_t(FLIGHT_TYPE::STATE);
+	record.m_value     = uint16_t((oldState << 8) | newState);
+
+	commit(n);
+}
+
+bool CFlightRecorder::dump(FLIGHT_REASON reason, bool force)
+{
+	uint64_t now = CStopWatch::nanoseconds();
+	if (!force && m_lastDump > 0ULL && (now - m_lastDump) < DUMP_INTERVAL)
+		return false;
+
+	m_lastDump = now;
+
+	uint64_t offset = CStopWatch::realtime() - now;
+
+	time_t t = time_t((now + offset) / 1000000000ULL);
+	// Other threads format times too
+	struct tm tm;
+#if defined(_WIN32) || defined(_WIN64)
+	::gmtime_s(&tm, &t);
+#else
+	::gmtime_r(&t, &tm);
+#endif
+
+	char filename[300U];
+#if defined(_WIN32) || defined(_WIN64)
+	::snprintf(filename, sizeof(filename), "%s\\%s-%04d%02d%02d-%02d%02d%02d-%s.flt", m_filePath.c_str(), m_fileRoot.c_str(),
+		tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, REASONS[int(reason)]);
+#else
+	::snprintf(filename, sizeof(filename), "%s/%s-%04d%02d%02d-%02d%02d%02d-%s.flt", m_filePath.c_str(), m_fileRoot.c_str(),
+		tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, REASONS[int(reason)]);
+#endif
+
+	FILE* fp = ::fopen(filename, "wb");
+	if (fp == nullptr) {
+		LogError("Flight recorder, unable to open %s", filename);
+		return false;
+	}
+
+	uint64_t head   = m_head.load();
+	uint64_t length = m_mask + 1ULL;
+	uint64_t count  = (head < length) ? head : length;
+	uint64_t start  = head - count;
+
+	// Only the complete records, those being written as they are copied are left out
+	std::vector<CFlightRecord> records;
+	records.reserve(size_t(count));
+	for (uint64_t n = start; n < head; n++) {
+		std::atomic<uint64_t>& stamp = m_stamps[n & m_mask];
+
+		if (stamp.load(std::memory_order_acquire) != (n + 1ULL))
+			continue;
+
+		CFlightRecord record;
+		::memcpy(&record, m_records + (n & m_mask), sizeof(CFlightRecord));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (stamp.load(std::memory_order_relaxed) != (n + 1ULL))
+			continue;
+
+		records.push_back(record);
+	}
+
+	CFlightHeader header;
+	::memset(&header, 0x00U, sizeof(CFlightHeader));
+	::memcpy(header.m_magic, FLIGHT_MAGIC, sizeof(header.m_magic));
+	header.m_recordLength = sizeof(CFlightRecord);
+	header.m_count        = uint32_t(records.size());
+	header.m_reason       = uint16_t(reason);
+	header.m_offset       = offset;
+
+	::fwrite(&header, sizeof(CFlightHeader), 1U, fp);
+	if (!records.empty())
+		::fwrite(records.data(), sizeof(CFlightRecord), records.size(), fp);
+
+	::fclose(fp);
+
+	LogMessage("Flight recorder, %u records written to %s", (unsigned int)records.size(), filename);
+
+	return true;
+}
@@ -0,0 +1,135 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	FlightRecorder_H
+#define	FlightRecorder_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+enum class FLIGHT_TYPE : uint8_t {
+	FRAME,
+	STATE
+};
+
+enum class FLIGHT_DIRECTION : uint8_t {
+	RF_IN,
+	RF_OUT,
+	NET_IN,
+	NET_OUT
+};
+
+enum class FLIGHT_REASON : uint16_t {
+	SIGNAL,
+	LINK_LOST,
+	OVERFLOW
+};
+
+// The file holds this header followed by the records, the oldest first, all
+// in the byte order of the machine that wrote them.
+const char FLIGHT_MAGIC[] = "M17FLT1";
+
+struct CFlightHeader {
+	char     m_magic[8U];
+	uint32_t m_recordLength;
+	uint32_t m_count;
+	uint16_t m_reason;
+	uint16_t m_reserved[3U];
+	uint64_t m_offset;			// Add to a timestamp to give the ns since 1970
+};
+
+// 32 bytes, for a frame the source and destination are the encoded callsigns,
+// for a state change the old and new states are in m_value.
+struct CFlightRecord {
+	uint64_t m_timestamp;		// ns, from CStopWatch::nanoseconds()
+	uint8_t  m_type;
+	uint8_t  m_direction;
+	uint16_t m_id;
+	uint16_t m_fn;
+	uint16_t m_value;
+	uint8_t  m_source[6U];
+	uint8_t  m_dest[6U];
+	uint8_t  m_reserved[4U];
+};
+
+// Keeps the last few seconds of frame headers and state changes in a fixed
+// ring, and writes them to a file on request. The main loop, the workers and
+// the IO thread all write to it, each taking a slot with a single atomic add.
+// A slot's stamp is only set once its record is complete, so that a dump
+// skips the records still being written.
+class CFlightRecorder {
+public:
+	CFlightRecorder(const std::string& filePath, const std::string& fileRoot, unsigned int seconds);
+	~CFlightRecorder();
+
+	// The time used for the records without their own timestamp, set once per pass of the main loop
+	void setTime(uint64_t timestamp)
+	{
+		m_time.store(timestamp, std::memory_order_relaxed);
+	}
+
+	void frame(FLIGHT_DIRECTION direction, const unsigned char* data, uint64_t timestamp = 0ULL)
+	{
+		uint64_t n = m_head.fetch_add(1ULL, std::memory_order_relaxed);
+		CFlightRecord& record = claim(n);
+
+		record.m_timestamp = (timestamp == 0ULL) ? m_time.load(std::memory_order_relaxed) : timestamp;
+		record.m_type      = uint8_t(FLIGHT_TYPE::FRAME);
+		record.m_direction = uint8_t(direction);
+		record.m_id        = (data[4U] << 8) + (data[5U] << 0);
+		record.m_fn        = (data[34U] << 8) + (data[35U] << 0);
+		record.m_value     = 0U;
+		::memcpy(record.m_dest,   data + 6U,  6U);
+		::memcpy(record.m_source, data + 12U, 6U);
+
+		commit(n);
+	}
+
+	void state(unsigned int oldState, unsigned int newState);
+
+	// Returns false if the file can't be written, or a dump was made too recently
+	bool dump(FLIGHT_REASON reason, bool force = false);
+
+private:
+	std::string            m_filePath;
+	std::string            m_fileRoot;
+	CFlightRecord*         m_records;
+	std::atomic<uint64_t>* m_stamps;
+	uint64_t               m_mask;
+	std::atomic<uint64_t>  m_head;
+	std::atomic<uint64_t>  m_time;
+	uint64_t               m_lastDump;
+
+	// The stamp of record n is n + 1 once it is complete, and 0 while it is being written
+	CFlightRecord& claim(uint64_t n)
+	{
+		m_stamps[n & m_mask].store(0ULL, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		return m_records[n & m_mask];
+	}
+
+	void commit(uint64_t n)
+	{
+		m_stamps[n & m_mask].store(n + 1ULL, std::memory_order_release);
+	}
+};
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "IOThread.h"
+#include "StopWatch.h"
+#include "Log.h"
+
+#include <cassert>
+
+// Work done in one pass of the loop, in microseconds
+static const unsigned long long LOOP_BUCKETS[] = { 10ULL, 25ULL, 50ULL, 100ULL, 250ULL, 500ULL, 1000ULL, 2500ULL, 5000ULL, 10000ULL, 25000ULL };
+
+CIOThread::CIOThread() :
+CThread(),
+m_realTime(nullptr),
+m_forwarders(),
+m_killed(false),
+m_latency(false),
+m_started(false),
+m_loopTime("IO thread loop"),
+m_loopMetric(CMetrics::histogram("m17gateway_io_loop_duration_seconds", "Time spent working in one pass of the IO thread loop", LOOP_BUCKETS, sizeof(LOOP_BUCKETS) / sizeof(LOOP_BUCKETS[0U]), 1.0E-6))
+{
+}
+
+CIOThread::~CIOThread()
+{
+}
+
+void CIOThread::add(CM17Forwarder* forwarder)
+{
+	assert(forwarder != nullptr);
+
+	m_forwarders.push_back(forwarder);
+}
+
+void CIOThread::setRealTime(const CRealTime* realTime)
+{
+	m_realTime = realTime;
+}
+
+bool CIOThread::start()
+{
+	m_started = run();
+	if (!m_started) {
+		LogError("IO thread, unable to start the thread");
+		return false;
+	}
+
+	return true;
+}
+
+void CIOThread::logLatencies()
+{
+	m_latency.store(true);
+}
+
+void CIOThread::stop()
+{
+	m_killed.store(true);
+
+	if (m_started)
+		wait();
+
+	m_started = false;
+}
+
+void CIOThread::entry()
+{
+	if (m_realTime != nullptr)
+		m_realTime->apply("IO thread");
+
+	LogMessage("IO thread, forwarding for %u repeater%s", (unsigned int)m_forwarders.size(), (m_forwarders.size() == 1U) ? "" : "s");
+
+	CStopWatch stopWatch;
+	stopWatch.start();
+
+	while (!m_killed.load()) {
+		unsigned long long loopStart = CStopWatch::nanoseconds();
+
+		unsigned int ms = stopWatch.elapsed();
+		if (ms > 0U)
+			stopWatch.start();
+
+		// The sockets are read by the clocks, so what arrived is forwarded in the same pass
+		for (std::vector<CM17Forwarder*>::const_iterator it = m_forwarders.cbegin(); it != m_forwarders.cend(); ++it)
+			(*it)->clock(ms);
+
+		bool busy = false;
+		for (std::vector<CM17Forwarder*>::const_iterator it = m_forwarders.cbegin(); it != m_forwarders.cend(); ++it) {
+			if ((*it)->process())
+				busy = true;
+		}
+
+		unsigned long long now = CStopWatch::nanoseconds();
+		m_loopTime.record(now - loopStart);
+		m_loopMetric.observe((now - loopStart) / 1000ULL);
+
+		if (m_latency.exchange(false)) {
+			std::vector<CLatencyHistogram*> latencies;
+			latencies.push_back(&m_loopTime);
+			for (std::vector<CM17Forwarder*>::const_iterator it = m_forwarders.cbegin(); it != m_forwarders.cend(); ++it)
+				(*it)->getLatencies(latencies);
+
+			for (std::vector<CLatencyHistogram*>::const_iterator it = latencies.cbegin(); it != latencies.cend(); ++it) {
+				std::string text;
+				(*it)->format(text);
+				text.pop_back();
+				LogMessage("Latency, %s", text.c_str());
+			}
+		}
+
+		// Only forwarding is done here, so a short sleep costs little and keeps the delay down
+		if (!busy)
+			CThread::sleep(1U);
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(IOThread_H)
+#define	IOThread_H
+
+#include "LatencyHistogram.h"
+#include "M17Forwarder.h"
+#include "RealTime.h"
+#include "Metrics.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <vector>
+
+// Runs the forwarders of every repeater on a thread of its own, so that the
+// frames keep moving whatever the repeaters, the log or APRS are doing. The
+// forwarders are still owned by their repeaters.
+class CIOThread : public CThread {
+public:
+	CIOThread();
+	virtual ~CIOThread();
+
+	// Only before the thread is started
+	void add(CM17Forwarder* forwarder);
+	void setRealTime(const CRealTime* realTime);
+
+	bool start();
+
+	// Logs the latencies of the thread and its forwarders from its own thread
+	void logLatencies();
+
+	void stop();
+
+	virtual void entry();
+
+private:
+	const CRealTime*            m_realTime;
+	std::vector<CM17Forwarder*> m_forwarders;
+	std::atomic<bool>           m_killed;
+	std::atomic<bool>           m_latency;
+	bool                        m_started;
+	CLatencyHistogram           m_loopTime;
+	CMetricHistogram&           m_loopMetric;
+};
+
+#endif
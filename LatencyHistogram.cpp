@@ -0,0 +1,149 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "LatencyHistogram.h"
+#include "StopWatch.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+const unsigned int SUB_BITS = 3U;		// log2(LATENCY_SUB_BUCKETS)
+
+CLatencyHistogram::CLatencyHistogram(const std::string& name) :
+m_name(name),
+m_buckets(),
+m_count(0ULL),
+m_sum(0ULL),
+m_min(0ULL),
+m_max(0ULL)
+{
+}
+
+CLatencyHistogram::~CLatencyHistogram()
+{
+}
+
+// Values below 16 have a bucket each, above that the top four bits pick the bucket
+unsigned int CLatencyHistogram::index(unsigned long long ns)
+{
+	if (ns < 2ULL * LATENCY_SUB_BUCKETS)
+		return (unsigned int)ns;
+
+#if defined(_MSC_VER)
+	unsigned long bit;
+	::_BitScanReverse64(&bit, ns);
+	unsigned int exponent = (unsigned int)bit;
+#else
+	unsigned int exponent = 63U - (unsigned int)__builtin_clzll(ns);
+#endif
+	unsigned int sub      = (unsigned int)(ns >> (exponent - SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1U);
+
+	return 2U * LATENCY_SUB_BUCKETS + (exponent - (SUB_BITS + 1U)) * LATENCY_SUB_BUCKETS + sub;
+}
+
+unsigned long long CLatencyHistogram::upper(unsigned int index)
+{
+	if (index < 2U * LATENCY_SUB_BUCKETS)
+		return index;
+
+	unsigned int exponent = (index - 2U * LATENCY_SUB_BUCKETS) / LATENCY_SUB_BUCKETS + SUB_BITS + 1U;
+	unsigned int sub      = (index - 2U * LATENCY_SUB_BUCKETS) % LATENCY_SUB_BUCKETS;
+
+	unsigned long long width = 1ULL << (exponent - SUB_BITS);
+
+	return (LATENCY_SUB_BUCKETS + sub) * width + width - 1ULL;
+}
+
+void CLatencyHistogram::record(unsigned long long ns)
+{
+	m_buckets[index(ns)]++;
+
+	if (m_count == 0ULL || ns < m_min)
+		m_min = ns;
+	if (ns > m_max)
+		m_max = ns;
+
+	m_count++;
+	m_sum += ns;
+}
+
+unsigned long long CLatencyHistogram::recordSince(unsigned long long start)
+{
+	unsigned long long now = CStopWatch::nanoseconds();
+
+	record(now - start);
+
+	return now;
+}
+
+unsigned long long CLatencyHistogram::getCount() const
+{
+	return m_count;
+}
+
+unsigned long long CLatencyHistogram::getPercentile(double fraction) const
+{
+	if (m_count == 0ULL)
+		return 0ULL;
+
+	unsigned long long wanted = (unsigned long long)(fraction * m_count + 0.5);
+	if (wanted == 0ULL)
+		wanted = 1ULL;
+
+	unsigned long long total = 0ULL;
+	for (unsigned int i = 0U; i < LATENCY_BUCKETS; i++) {
+		total += m_buckets[i];
+		if (total >= wanted) {
+			unsigned long long value = upper(i);
+			return (value > m_max) ? m_max : value;
+		}
+	}
+
+	return m_max;
+}
+
+void CLatencyHistogram::reset()
+{
+	::memset(m_buckets, 0x00U, sizeof(m_buckets));
+
+	m_count = 0ULL;
+	m_sum   = 0ULL;
+	m_min   = 0ULL;
+	m_max   = 0ULL;
+}
+
+void CLatencyHistogram::format(std::string& out) const
+{
+	char text[250U];
+
+	if (m_count == 0ULL) {
+		::snprintf(text, sizeof(text), "%s: no samples\n", m_name.c_str());
+	} else {
+		::snprintf(text, sizeof(text), "%s: count %llu, mean %.1fus, min %.1fus, p50 %.1fus, p90 %.1fus, p99 %.1fus, p99.9 %.1fus, max %.1fus\n", m_name.c_str(), m_count,
+			double(m_sum) / double(m_count) / 1000.0, double(m_min) / 1000.0,
+			double(getPercentile(0.5)) / 1000.0, double(getPercentile(0.9)) / 1000.0,
+			double(getPercentile(0.99)) / 1000.0, double(getPercentile(0.999)) / 1000.0,
+			double(m_max) / 1000.0);
+	}
+
+	out += text;
+}
@@ -0,0 +1,62 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	LatencyHistogram_H
+#define	LatencyHistogram_H
+
+#include <string>
+
+// Eight linear buckets per power of two, so any value is held to within 12.5%
+const unsigned int LATENCY_SUB_BUCKETS = 8U;
+const unsigned int LATENCY_BUCKETS     = 2U * LATENCY_SUB_BUCKETS + (64U - 4U) * LATENCY_SUB_BUCKETS;
+
+// A log-linear histogram of times in nanoseconds. It is written and read from
+// the main loop only, so a record is an index calculation and an increment.
+class CLatencyHistogram {
+public:
+	CLatencyHistogram(const std::string& name);
+	~CLatencyHistogram();
+
+	void record(unsigned long long ns);
+
+	// Records the time since the start and returns the time now, to chain the timing of several calls
+	unsigned long long recordSince(unsigned long long start);
+
+	unsigned long long getCount() const;
+
+	// The upper bound of the bucket holding the given fraction of the values
+	unsigned long long getPercentile(double fraction) const;
+
+	void reset();
+
+	// One line: the count, the mean and the percentiles in microseconds
+	void format(std::string& out) const;
+
+private:
+	std::string        m_name;
+	unsigned long long m_buckets[LATENCY_BUCKETS];
+	unsigned long long m_count;
+	unsigned long long m_sum;
+	unsigned long long m_min;
+	unsigned long long m_max;
+
+	static unsigned int       index(unsigned long long ns);
+	static unsigned long long upper(unsigned int index);
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef LockFreeQueue_H
+#define LockFreeQueue_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+
+// A bounded multi-producer, multi-consumer queue of fixed size items. Each
+// cell carries a sequence number which tells a producer or consumer whether
+// the cell is free for it, so neither side ever takes a lock or blocks. A full
+// queue makes push() fail rather than wait.
+template<class T> class CLockFreeQueue {
+public:
+	CLockFreeQueue(unsigned int length) :
+	m_cells(nullptr),
+	m_mask(0U),
+	m_enqueue(0U),
+	m_dequeue(0U)
+	{
+		assert(length > 0U);
+
+		// Round up to a power of two
+		unsigned int size = 2U;
+		while (size < length)
+			size <<= 1;
+
+		m_cells = new CCell[size];
+		m_mask  = size - 1U;
+
+		for (unsigned int i = 0U; i < size; i++)
+			m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+	}
+
+	~CLockFreeQueue()
+	{
+		delete[] m_cells;
+	}
+
+	bool push(const T& item)
+	{
+		size_t pos = m_enqueue.load(std::memory_order_relaxed);
+
+		for (;;) {
+			CCell& cell = m_cells[pos & m_mask];
+			size_t seq  = cell.m_sequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = ptrdiff_t(seq) - ptrdiff_t(pos);
+
+			if (diff == 0) {
+				if (m_enqueue.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed)) {
+					cell.m_data = item;
+					cell.m_sequence.store(pos + 1U, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = m_enqueue.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool pop(T& item)
+	{
+		size_t pos = m_dequeue.load(std::memory_order_relaxed);
+
+		for (;;) {
+			CCell& cell = m_cells[pos & m_mask];
+			size_t seq  = cell.m_sequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = ptrdiff_t(seq) - ptrdiff_t(pos + 1U);
+
+			if (diff == 0) {
+				if (m_dequeue.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed)) {
+					item = cell.m_data;
+					cell.m_sequence.store(pos + m_mask + 1U, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = m_dequeue.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool isEmpty() const
+	{
+		return m_enqueue.load(std::memory_order_acquire) == m_dequeue.load(std::memory_order_acquire);
+	}
+
+	unsigned int length() const
+	{
+		return (unsigned int)(m_mask + 1U);
+	}
+
+private:
+	struct CCell {
+		std::atomic<size_t> m_sequence;
+		T                   m_data;
+	};
+
+	CCell*              m_cells;
+	size_t              m_mask;
+	char                m_pad0[64U];
+	std::atomic<size_t> m_enqueue;
+	char                m_pad1[64U];
+	std::atomic<size_t> m_dequeue;
+	char                m_pad2[64U];
+};
+
+#endif
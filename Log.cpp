@@ -17,6 +17,8 @@
  */
 
 #include "Log.h"
+#include "LockFreeQueue.h"
+#include "Thread.h"
 
 #if defined(_WIN32) || defined(_WIN64)
 #include <Windows.h>
@@ -25,6 +27,7 @@
 #include <unistd.h>
 #endif
 
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <cstdarg>
@@ -32,6 +35,12 @@
 #include <cassert>
 #include <cstring>
 
+const unsigned int LOG_LINE_LENGTH   = 500U;
+const unsigned int LOG_PREFIX_LENGTH = 27U;		// "M: 2025-06-07 12:34:56.789 "
+
+// The queued records hold as much of a message as a line written directly does
+const unsigned int LOG_TEXT_LENGTH   = LOG_LINE_LENGTH - LOG_PREFIX_LENGTH;
+
 static unsigned int m_fileLevel = 2U;
 static std::string m_filePath;
 static std::string m_fileRoot;
@@ -42,23 +51,67 @@ static bool m_daemon = false;
 
 static unsigned int m_displayLevel = 2U;
 
-static struct tm m_tm;
+static int m_year  = 0;
+static int m_month = 0;
+static int m_day   = 0;
 
 static char LEVELS[] = " DMIWEF";
 
-static bool logOpenRotate()
+unsigned int LogMinimumLevel = 2U;
+
+struct CLogRecord {
+	unsigned int m_level;
+#if defined(_WIN32) || defined(_WIN64)
+	SYSTEMTIME   m_time;
+#else
+	timeval      m_time;
+#endif
+	char         m_text[LOG_TEXT_LENGTH];
+};
+
+class CLogThread : public CThread {
+public:
+	CLogThread(unsigned int length);
+	virtual ~CLogThread();
+
+	virtual void entry();
+
+	bool write(const CLogRecord& record);
+
+	void kill();
+
+	unsigned int getDropped() const;
+
+private:
+	CLockFreeQueue<CLogRecord> m_queue;
+	std::atomic<bool>          m_killed;
+	std::atomic<unsigned int>  m_dropped;
+	std::atomic<unsigned int>  m_totalDropped;
+
+	bool drain();
+};
+
+static CLogThread* m_thread = nullptr;
+
+// The timestamp prefix of the current second, only the level and the milliseconds change per line
+struct CLogPrefix {
+	time_t m_second;
+	int    m_year;
+	int    m_month;
+	int    m_day;
+	char   m_text[LOG_PREFIX_LENGTH + 1U];
+};
+
+static thread_local CLogPrefix m_prefix = { time_t(-1), 0, 0, 0, "" };
+
+static bool logOpenRotate(int year, int month, int day)
 {
 	bool status = false;
-	
+
 	if (m_fileLevel == 0U)
 		return true;
 
-	time_t now;
-	::time(&now);
-
-	struct tm* tm = ::gmtime(&now);
-
-	if (tm->tm_mday == m_tm.tm_mday && tm->tm_mon == m_tm.tm_mon && tm->tm_year == m_tm.tm_year) {
+	if (day == m_day && month == m_month && year == m_year) {
 		if (m_fpLog != nullptr)
 		    return true;
 	} else {
@@ -68,9 +121,9 @@ static bool logOpenRotate()
 
 	char filename[200U];
 #if defined(_WIN32) || defined(_WIN64)
-	::sprintf(filename, "%s\\%s-%04d-%02d-%02d.log", m_filePath.c_str(), m_fileRoot.c_str(), tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
+	::sprintf(filename, "%s\\%s-%04d-%02d-%02d.log", m_filePath.c_str(), m_fileRoot.c_str(), year, month, day);
 #else
-	::sprintf(filename, "%s/%s-%04d-%02d-%02d.log", m_filePath.c_str(), m_fileRoot.c_str(), tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
+	::sprintf(filename, "%s/%s-%04d-%02d-%02d.log", m_filePath.c_str(), m_fileRoot.c_str(), year, month, day);
 #endif
 
 	if ((m_fpLog = ::fopen(filename, "a+t")) != nullptr) {
@@ -81,8 +134,10 @@ static bool logOpenRotate()
 			dup2(fileno(m_fpLog), fileno(stderr));
 #endif
 	}
-	
-	m_tm = *tm;
+
+	m_year  = year;
+	m_month = month;
+	m_day   = day;
 
 	return status;
 }
@@ -116,14 +171,187 @@ static bool logOpenNoRotate()
 	return status;
 }
 
-bool LogOpen()
+static bool logOpen(int year, int month, int day)
 {
 	if (m_fileRotate)
-		return logOpenRotate();
+		return logOpenRotate(year, month, day);
 	else
 		return logOpenNoRotate();
 }
 
+bool LogOpen()
+{
+	time_t now;
+	::time(&now);
+
+	struct tm* tm = ::gmtime(&now);
+
+	return logOpen(tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
+}
+
+static void logTime(CLogRecord& record)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	::GetSystemTime(&record.m_time);
+#else
+	::gettimeofday(&record.m_time, nullptr);
+#endif
+}
+
+static unsigned int logPrefix(const CLogRecord& record, char* buffer)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	const SYSTEMTIME& st = record.m_time;
+
+	m_prefix.m_year  = st.wYear;
+	m_prefix.m_month = st.wMonth;
+	m_prefix.m_day   = st.wDay;
+
+	return ::sprintf(buffer, "%c: %04u-%02u-%02u %02u:%02u:%02u.%03u ", LEVELS[record.m_level], st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds);
+#else
+	if (record.m_time.tv_sec != m_prefix.m_second) {
+		struct tm tm;
+		::gmtime_r(&record.m_time.tv_sec, &tm);
+
+		m_prefix.m_second = record.m_time.tv_sec;
+		m_prefix.m_year   = tm.tm_year + 1900;
+		m_prefix.m_month  = tm.tm_mon + 1;
+		m_prefix.m_day    = tm.tm_mday;
+
+		char text[100U];
+		::sprintf(text, " : %04d-%02d-%02d %02d:%02d:%02d.000 ", m_prefix.m_year, m_prefix.m_month, m_prefix.m_day, tm.tm_hour, tm.tm_min, tm.tm_sec);
+		::memcpy(m_prefix.m_text, text, LOG_PREFIX_LENGTH);
+	}
+
+	::memcpy(buffer, m_prefix.m_text, LOG_PREFIX_LENGTH);
+
+	unsigned int ms = (unsigned int)(record.m_time.tv_usec / 1000);
+
+	buffer[0U]  = LEVELS[record.m_level];
+	buffer[23U] = '0' + ms / 100U;
+	buffer[24U] = '0' + (ms / 10U) % 10U;
+	buffer[25U] = '0' + ms % 10U;
+	buffer[LOG_PREFIX_LENGTH] = '\0';
+
+	return LOG_PREFIX_LENGTH;
+#endif
+}
+
+// Writes a formatted line to the log file and/or the display, the caller flushes. The
+// date used for the file rotation comes from the prefix of the line.
+static void logWrite(unsigned int level, const char* buffer)
+{
+	if (level >= m_fileLevel && m_fileLevel != 0U) {
+		bool ret = ::logOpen(m_prefix.m_year, m_prefix.m_month, m_prefix.m_day);
+		if (ret)
+			::fprintf(m_fpLog, "%s\n", buffer);
+	}
+
+	if (level >= m_displayLevel && m_displayLevel != 0U)
+		::fprintf(stdout, "%s\n", buffer);
+}
+
+static void logFlush()
+{
+	if (m_fpLog != nullptr)
+		::fflush(m_fpLog);
+
+	if (m_displayLevel != 0U)
+		::fflush(stdout);
+}
+
+CLogThread::CLogThread(unsigned int length) :
+CThread(),
+m_queue(length),
+m_killed(false),
+m_dropped(0U),
+m_totalDropped(0U)
+{
+}
+
+CLogThread::~CLogThread()
+{
+}
+
+bool CLogThread::write(const CLogRecord& record)
+{
+	if (m_queue.push(record))
+		return true;
+
+	m_dropped++;
+	m_totalDropped++;
+
+	return false;
+}
+
+void CLogThread::entry()
+{
+	while (!m_killed.load()) {
+		if (!drain())
+			CThread::sleep(10U);
+	}
+
+	drain();
+}
+
+bool CLogThread::drain()
+{
+	bool written = false;
+
+	CLogRecord record;
+	while (m_queue.pop(record)) {
+		char buffer[LOG_LINE_LENGTH + 1U];
+		unsigned int len = logPrefix(record, buffer);
+		::strcpy(buffer + len, record.m_text);
+
+		logWrite(record.m_level, buffer);
+
+		written = true;
+	}
+
+	unsigned int dropped = m_dropped.exchange(0U);
+	if (dropped > 0U) {
+		CLogRecord warning;
+		warning.m_level = 4U;
+		logTime(warning);
+
+		char buffer[100U];
+		unsigned int len = logPrefix(warning, buffer);
+		::sprintf(buffer + len, "%u log messages dropped, log queue full", dropped);
+
+		logWrite(warning.m_level, buffer);
+
+		written = true;
+	}
+
+	if (written)
+		logFlush();
+
+	return written;
+}
+
+void CLogThread::kill()
+{
+	m_killed.store(true);
+}
+
+unsigned int CLogThread::getDropped() const
+{
+	return m_totalDropped.load();
+}
+
+static void logMinimumLevel()
+{
+	// Nothing is logged below this, 7 means nothing other than fatal errors
+	unsigned int level = 7U;
+	if (m_fileLevel != 0U && m_fileLevel < level)
+		level = m_fileLevel;
+	if (m_displayLevel != 0U && m_displayLevel < level)
+		level = m_displayLevel;
+
+	LogMinimumLevel = level;
+}
+
 bool LogInitialise(bool daemon, const std::string& filePath, const std::string& fileRoot, unsigned int fileLevel, unsigned int displayLevel, bool rotate)
 {
 	m_filePath     = filePath;
@@ -136,11 +364,68 @@ bool LogInitialise(bool daemon, const std::string& filePath, const std::string&
 	if (m_daemon)
 		m_displayLevel = 0U;
 
+	logMinimumLevel();
+
 	return ::LogOpen();
 }
 
+void LogSetLevels(unsigned int fileLevel, unsigned int displayLevel)
+{
+	// A file that wasn't opened at startup is opened by the next line written
+	m_fileLevel    = fileLevel;
+	m_displayLevel = m_daemon ? 0U : displayLevel;
+
+	logMinimumLevel();
+}
+
+bool LogStartAsync(unsigned int length)
+{
+	assert(length > 0U);
+
+	if (m_thread != nullptr)
+		return true;
+
+	m_thread = new CLogThread(length);
+
+	bool ret = m_thread->run();
+	if (!ret) {
+		delete m_thread;
+		m_thread = nullptr;
+		return false;
+	}
+
+	return true;
+}
+
+static void logStopAsync()
+{
+	if (m_thread == nullptr)
+		return;
+
+	m_thread->kill();
+	m_thread->wait();
+
+	unsigned int dropped = m_thread->getDropped();
+
+	delete m_thread;
+	m_thread = nullptr;
+
+	if (dropped > 0U)
+		LogWarning("%u log messages were dropped in total", dropped);
+}
+
+unsigned int LogGetDropped()
+{
+	if (m_thread == nullptr)
+		return 0U;
+
+	return m_thread->getDropped();
+}
+
 void LogFinalise()
 {
+	logStopAsync();
+
 	if (m_fpLog != nullptr)
 		::fclose(m_fpLog);
 }
@@ -149,44 +434,47 @@ void Log(unsigned int level, const char* fmt, ...)
 {
 	assert(fmt != nullptr);
 
-	char buffer[501U];
-#if defined(_WIN32) || defined(_WIN64)
-	SYSTEMTIME st;
-	::GetSystemTime(&st);
-
-	::sprintf(buffer, "%c: %04u-%02u-%02u %02u:%02u:%02u.%03u ", LEVELS[level], st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond, st.wMilliseconds);
-#else
-	struct timeval now;
-	::gettimeofday(&now, nullptr);
-
-	struct tm* tm = ::gmtime(&now.tv_sec);
-
-	::sprintf(buffer, "%c: %04d-%02d-%02d %02d:%02d:%02d.%03lld ", LEVELS[level], tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec, now.tv_usec / 1000LL);
-#endif
+	// Return before any formatting or time lookups
+	if (level < LogMinimumLevel && level != 6U)
+		return;
 
 	va_list vl;
 	va_start(vl, fmt);
 
-	::vsnprintf(buffer + ::strlen(buffer), 500 - ::strlen(buffer), fmt, vl);
+	// The background thread does the formatting and the file handling
+	if (m_thread != nullptr && level != 6U) {
+		CLogRecord record;
+		record.m_level = level;
+		logTime(record);
 
-	va_end(vl);
+		::vsnprintf(record.m_text, LOG_TEXT_LENGTH, fmt, vl);
 
-	if (level >= m_fileLevel && m_fileLevel != 0U) {
-		bool ret = ::LogOpen();
-		if (!ret)
-			return;
+		va_end(vl);
 
-		::fprintf(m_fpLog, "%s\n", buffer);
-		::fflush(m_fpLog);
+		m_thread->write(record);
+		return;
 	}
 
-	if (level >= m_displayLevel && m_displayLevel != 0U) {
-		::fprintf(stdout, "%s\n", buffer);
-		::fflush(stdout);
-	}
+	if (level == 6U)		// Fatal
+		logStopAsync();
+
+	CLogRecord record;
+	record.m_level = level;
+	logTime(record);
+
+	char buffer[LOG_LINE_LENGTH + 1U];
+	unsigned int len = logPrefix(record, buffer);
+
+	::vsnprintf(buffer + len, LOG_LINE_LENGTH - len, fmt, vl);
+
+	va_end(vl);
+
+	logWrite(level, buffer);
+	logFlush();
 
 	if (level == 6U) {		// Fatal
-		::fclose(m_fpLog);
+		if (m_fpLog != nullptr)
+			::fclose(m_fpLog);
 		exit(1);
 	}
 }
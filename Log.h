@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2015,2016,2020 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2015,2016,2020,2025 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -21,16 +21,29 @@
 
 #include <string>
 
-#define	LogDebug(fmt, ...)	Log(1U, fmt, ##__VA_ARGS__)
-#define	LogMessage(fmt, ...)	Log(2U, fmt, ##__VA_ARGS__)
-#define	LogInfo(fmt, ...)	Log(3U, fmt, ##__VA_ARGS__)
-#define	LogWarning(fmt, ...)	Log(4U, fmt, ##__VA_ARGS__)
-#define	LogError(fmt, ...)	Log(5U, fmt, ##__VA_ARGS__)
+// The arguments are not evaluated when the level is filtered out
+#define	LogDebug(fmt, ...)	(LogIsEnabled(1U) ? Log(1U, fmt, ##__VA_ARGS__) : (void)0)
+#define	LogMessage(fmt, ...)	(LogIsEnabled(2U) ? Log(2U, fmt, ##__VA_ARGS__) : (void)0)
+#define	LogInfo(fmt, ...)	(LogIsEnabled(3U) ? Log(3U, fmt, ##__VA_ARGS__) : (void)0)
+#define	LogWarning(fmt, ...)	(LogIsEnabled(4U) ? Log(4U, fmt, ##__VA_ARGS__) : (void)0)
+#define	LogError(fmt, ...)	(LogIsEnabled(5U) ? Log(5U, fmt, ##__VA_ARGS__) : (void)0)
 #define	LogFatal(fmt, ...)	Log(6U, fmt, ##__VA_ARGS__)
 
+// The lowest level written to either the file or the display
+extern unsigned int LogMinimumLevel;
+
+inline bool LogIsEnabled(unsigned int level)
+{
+	return level >= LogMinimumLevel;
+}
+
 extern void Log(unsigned int level, const char* fmt, ...);
 
 extern bool LogInitialise(bool daemon, const std::string& filePath, const std::string& fileRoot, unsigned int fileLevel, unsigned int displayLevel, bool rotate);
+extern bool LogStartAsync(unsigned int length);
+extern void LogSetLevels(unsigned int fileLevel, unsigned int displayLevel);
+extern unsigned int LogGetDropped();
+
 extern void LogFinalise();
 
 #endif
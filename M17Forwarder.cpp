@@ -0,0 +1,343 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "M17Forwarder.h"
+#include "AllocCounter.h"
+#include "StopWatch.h"
+#include "M17Utils.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cstring>
+
+// Enough for several seconds of frames from both sides, the repeater drains it every pass
+const unsigned int QUEUE_LENGTH = 256U;
+
+CM17Forwarder::CM17Forwarder(const CRepeaterConf& conf, const std::string& name, bool debug, bool networkDebug) :
+m_prefix(name.empty() ? std::string() : name + ", "),
+m_rpt(nullptr),
+m_network(nullptr),
+m_recorder(nullptr),
+m_commands(QUEUE_LENGTH),
+m_events(QUEUE_LENGTH),
+m_linked(false),
+m_reflector(),
+m_encoded(),
+m_all(),
+m_status(M17NET_STATUS::NOTLINKED),
+m_statusPending(false),
+m_sequence(0U),
+m_n(0U),
+m_rfToNet(CMetrics::histogramName(name, "RF to network")),
+m_netToRf(CMetrics::histogramName(name, "Network to RF")),
+m_rptClock(CMetrics::histogramName(name, "Rpt network clock")),
+m_netClock(CMetrics::histogramName(name, "M17 network clock")),
+m_lost(CMetrics::counter("m17gateway_forwarder_lost_total", "Commands and events lost to a full queue between a repeater and its forwarder", CMetrics::labelsFor(name)))
+{
+	::memset(m_reflector, 0x00U, M17_CALLSIGN_LENGTH + 1U);
+	::memset(m_encoded, 0x00U, 6U);
+	CM17Utils::encodeCallsign("ALL", m_all);
+
+	std::string labels = CMetrics::labelsFor(name);
+
+	m_rpt     = new CRptNetwork(conf.m_localPort, conf.m_rptAddress, conf.m_rptPort, debug, labels);
+	m_network = new CM17Network(conf.m_callsign, conf.m_suffix, conf.m_networkPort, networkDebug, labels);
+}
+
+CM17Forwarder::~CM17Forwarder()
+{
+	delete m_rpt;
+	delete m_network;
+}
+
+void CM17Forwarder::setCapture(CPacketCapture* capture)
+{
+	if (capture == nullptr)
+		return;
+
+	m_rpt->setCapture(capture);
+	m_network->setCapture(capture);
+}
+
+void CM17Forwarder::setFlightRecorder(CFlightRecorder* recorder)
+{
+	m_recorder = recorder;
+}
+
+bool CM17Forwarder::open()
+{
+	return m_rpt->open();
+}
+
+bool CM17Forwarder::command(const CForwarderCommand& command)
+{
+	if (m_commands.push(command))
+		return true;
+
+	m_lost.inc();
+
+	return false;
+}
+
+bool CM17Forwarder::event(CForwarderEvent& event)
+{
+	return m_events.pop(event);
+}
+
+bool CM17Forwarder::process()
+{
+	applyCommands();
+
+	bool busy = false;
+
+	unsigned char buffer[100U];
+
+	if (m_linked) {
+		// From the reflector to the MMDVM
+		bool ret = m_network->read(buffer);
+		if (ret) {
+			busy = true;
+
+#if defined(M17_COUNT_ALLOCS)
+			unsigned long long allocs = CAllocCounter::get();
+#endif
+			forwardNet(buffer);
+#if defined(M17_COUNT_ALLOCS)
+			assert(CAllocCounter::get() == allocs);
+#endif
+		}
+	}
+
+	// From the MMDVM to the reflector, unless it's for the repeater itself
+	bool ret = m_rpt->read(buffer);
+	if (ret) {
+		busy = true;
+
+#if defined(M17_COUNT_ALLOCS)
+		unsigned long long allocs = CAllocCounter::get();
+#endif
+		forwardRF(buffer);
+#if defined(M17_COUNT_ALLOCS)
+		assert(CAllocCounter::get() == allocs);
+#endif
+	}
+
+	return busy;
+}
+
+void CM17Forwarder::forwardNet(unsigned char* buffer)
+{
+	assert(buffer != nullptr);
+
+	unsigned long long timestamp = m_network->getTimestamp();
+
+	CForwarderEvent event;
+	event.m_type      = FORWARDER_EVENT::NET;
+	event.m_forwarded = true;
+	::memcpy(event.m_data, buffer, M17_NETWORK_FRAME_LENGTH);
+
+	if (m_recorder != nullptr)
+		m_recorder->frame(FLIGHT_DIRECTION::NET_IN, buffer, timestamp);
+
+	if (m_n > 40U) {
+		// The source and the reflector go into the META field
+		CM17Utils::injectCallsigns(buffer, m_encoded);
+
+		if (m_n > 45U)
+			m_n = 0U;
+	}
+
+	m_n++;
+
+	// Replace the destination callsign with the broadcast callsign
+	::memcpy(buffer + 6U, m_all, 6U);
+
+	m_rpt->write(buffer);
+	m_netToRf.recordSince(timestamp);
+
+	if (m_recorder != nullptr)
+		m_recorder->frame(FLIGHT_DIRECTION::RF_OUT, buffer);
+
+	uint16_t fn = (buffer[34U] << 8) + (buffer[35U] << 0);
+	if ((fn & 0x8000U) == 0x8000U)
+		m_n = 0U;
+
+	post(event);
+}
+
+void CM17Forwarder::forwardRF(unsigned char* buffer)
+{
+	assert(buffer != nullptr);
+
+	unsigned long long timestamp = m_rpt->getTimestamp();
+
+	CForwarderEvent event;
+	event.m_type      = FORWARDER_EVENT::RF;
+	event.m_forwarded = false;
+	::memcpy(event.m_data, buffer, M17_NETWORK_FRAME_LENGTH);
+
+	if (m_recorder != nullptr)
+		m_recorder->frame(FLIGHT_DIRECTION::RF_IN, buffer, timestamp);
+
+	if (m_linked && !isCommand(buffer)) {
+		// Replace the destination callsign with the reflector name and module
+		::memcpy(buffer + 6U, m_encoded, 6U);
+		m_network->write(buffer);
+		m_rfToNet.recordSince(timestamp);
+
+		if (m_recorder != nullptr)
+			m_recorder->frame(FLIGHT_DIRECTION::NET_OUT, buffer);
+
+		event.m_forwarded = true;
+	}
+
+	post(event);
+}
+
+void CM17Forwarder::clock(unsigned int ms)
+{
+	unsigned long long clockStart = CStopWatch::nanoseconds();
+
+	m_rpt->clock(ms);
+	clockStart = m_rptClock.recordSince(clockStart);
+
+	m_network->clock(ms);
+	m_netClock.recordSince(clockStart);
+
+	if (m_network->getStatus() != m_status)
+		postStatus();
+	else if (m_statusPending)
+		sendStatus();
+}
+
+unsigned long long CM17Forwarder::getDropped() const
+{
+	return m_rpt->getDropped() + m_network->getDropped();
+}
+
+void CM17Forwarder::getStats(unsigned long long* network, unsigned long long* repeater) const
+{
+	assert(network != nullptr);
+	assert(repeater != nullptr);
+
+	m_network->getStats(network[0U], network[1U], network[2U], network[3U]);
+	m_rpt->getStats(repeater[0U], repeater[1U], repeater[2U], repeater[3U]);
+}
+
+void CM17Forwarder::getLatencies(std::vector<CLatencyHistogram*>& latencies)
+{
+	latencies.push_back(&m_rfToNet);
+	latencies.push_back(&m_netToRf);
+	latencies.push_back(&m_rptClock);
+	latencies.push_back(&m_netClock);
+}
+
+void CM17Forwarder::close()
+{
+	// Anything still queued, such as the unlink at shutdown
+	applyCommands();
+
+	m_rpt->close();
+
+	M17NET_STATUS status = m_network->getStatus();
+	if (status == M17NET_STATUS::LINKED || status == M17NET_STATUS::LINKING)
+		m_network->unlink();
+	m_network->close();
+}
+
+void CM17Forwarder::applyCommands()
+{
+	CForwarderCommand command;
+	while (m_commands.pop(command)) {
+		switch (command.m_type) {
+		case FORWARDER_COMMAND::ROUTE:
+			m_linked = command.m_linked;
+			::memcpy(m_reflector, command.m_reflector, M17_CALLSIGN_LENGTH + 1U);
+			CM17Utils::encodeCallsign(m_reflector, m_encoded);
+			break;
+
+		case FORWARDER_COMMAND::LINK:
+			m_network->link(command.m_reflector, command.m_addr, command.m_addrLen, command.m_module);
+			m_sequence = command.m_sequence;
+			postStatus();
+			break;
+
+		case FORWARDER_COMMAND::UNLINK:
+			m_network->unlink();
+			m_sequence = command.m_sequence;
+			postStatus();
+			break;
+
+		case FORWARDER_COMMAND::WRITE:
+			m_rpt->write(command.m_data);
+
+			if (m_recorder != nullptr)
+				m_recorder->frame(FLIGHT_DIRECTION::RF_OUT, command.m_data);
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+void CM17Forwarder::post(const CForwarderEvent& event)
+{
+	if (!m_events.push(event))
+		m_lost.inc();
+}
+
+// The state after a link or unlink is always sent, even if it hasn't changed
+void CM17Forwarder::postStatus()
+{
+	m_status        = m_network->getStatus();
+	m_statusPending = true;
+
+	sendStatus();
+}
+
+// A status is never dropped, if the queue is full it is sent again on the next clock
+void CM17Forwarder::sendStatus()
+{
+	CForwarderEvent event;
+	event.m_type     = FORWARDER_EVENT::STATUS;
+	event.m_status   = m_status;
+	event.m_sequence = m_sequence;
+
+	if (m_events.push(event))
+		m_statusPending = false;
+}
+
+// The same test as the repeater uses to pick out the frames meant for it
+bool CM17Forwarder::isCommand(const unsigned char* data) const
+{
+	assert(data != nullptr);
+
+	char dst[M17_CALLSIGN_LENGTH + 2U];
+	CM17Utils::decodeCallsign(data + 6U, dst);
+
+	if (::strcmp(dst, "ECHO") == 0 || ::strcmp(dst, "INFO") == 0 || ::strcmp(dst, "UNLINK") == 0)
+		return true;
+
+	if (::strlen(dst) != M17_CALLSIGN_LENGTH)
+		return false;
+
+	char module = dst[M17_CALLSIGN_LENGTH - 1U];
+
+	return ::strcmp(dst, m_reflector) != 0 && module >= 'A' && module <= 'Z';
+}
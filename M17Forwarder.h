@@ -0,0 +1,139 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(M17Forwarder_H)
+#define	M17Forwarder_H
+
+#include "LatencyHistogram.h"
+#include "FlightRecorder.h"
+#include "PacketCapture.h"
+#include "M17Network.h"
+#include "RptNetwork.h"
+#include "M17Defines.h"
+#include "SPSCQueue.h"
+#include "Metrics.h"
+#include "Conf.h"
+
+#include <string>
+
+enum class FORWARDER_COMMAND {
+	ROUTE,
+	LINK,
+	UNLINK,
+	WRITE
+};
+
+// From the repeater to its forwarder, only the fields of the type are used
+struct CForwarderCommand {
+	FORWARDER_COMMAND m_type;
+	unsigned int      m_sequence;
+	bool              m_linked;
+	char              m_reflector[M17_CALLSIGN_LENGTH + 1U];
+	sockaddr_storage  m_addr;
+	unsigned int      m_addrLen;
+	char              m_module;
+	unsigned char     m_data[M17_NETWORK_FRAME_LENGTH];
+};
+
+enum class FORWARDER_EVENT {
+	STATUS,
+	RF,
+	NET
+};
+
+// From the forwarder to its repeater. A status carries the sequence of the
+// last link or unlink applied, the frames are as they were received.
+struct CForwarderEvent {
+	FORWARDER_EVENT m_type;
+	M17NET_STATUS   m_status;
+	unsigned int    m_sequence;
+	bool            m_forwarded;
+	unsigned char   m_data[M17_NETWORK_FRAME_LENGTH];
+};
+
+// The forwarding path of one repeater: the two network sockets, and the frames
+// passed between them while the repeater is linked to a reflector. Everything
+// else is left to the repeater, which steers the forwarder with commands and
+// is told about every frame and change of link state with events. The two
+// queues are the only way in and out, so the forwarder can be run by another
+// thread from the repeater, and nothing on the forwarding path waits for the
+// repeater or a lock. Nothing on the forwarding path allocates either, the
+// callsigns are encoded when the route changes and the frames live in the
+// preallocated queue slots and fixed buffers.
+class CM17Forwarder {
+public:
+	CM17Forwarder(const CRepeaterConf& conf, const std::string& name, bool debug, bool networkDebug);
+	~CM17Forwarder();
+
+	// Only before the forwarder is running
+	void setCapture(CPacketCapture* capture);
+	void setFlightRecorder(CFlightRecorder* recorder);
+
+	bool open();
+
+	// From the repeater's thread
+	bool command(const CForwarderCommand& command);
+	bool event(CForwarderEvent& event);
+
+	// From the thread running the forwarder. A single pass, which forwards at
+	// most one frame from each side. True if a frame was read.
+	bool process();
+
+	void clock(unsigned int ms);
+
+	// These may be called from any thread
+	unsigned long long getDropped() const;
+	void getStats(unsigned long long* network, unsigned long long* repeater) const;
+
+	void getLatencies(std::vector<CLatencyHistogram*>& latencies);
+
+	// Only once the forwarder has stopped running
+	void close();
+
+private:
+	std::string                    m_prefix;
+	CRptNetwork*                   m_rpt;
+	CM17Network*                   m_network;
+	CFlightRecorder*               m_recorder;
+	CSPSCQueue<CForwarderCommand>  m_commands;
+	CSPSCQueue<CForwarderEvent>    m_events;
+	bool                           m_linked;
+	char                           m_reflector[M17_CALLSIGN_LENGTH + 1U];
+	unsigned char                  m_encoded[6U];
+	unsigned char                  m_all[6U];
+	M17NET_STATUS                  m_status;
+	bool                           m_statusPending;
+	unsigned int                   m_sequence;
+	unsigned int                   m_n;
+	CLatencyHistogram              m_rfToNet;
+	CLatencyHistogram              m_netToRf;
+	CLatencyHistogram              m_rptClock;
+	CLatencyHistogram              m_netClock;
+	CMetricCounter&                m_lost;
+
+	void forwardNet(unsigned char* buffer);
+	void forwardRF(unsigned char* buffer);
+
+	void applyCommands();
+	void post(const CForwarderEvent& event);
+	void postStatus();
+	void sendStatus();
+	bool isCommand(const unsigned char* data) const;
+};
+
+#endif
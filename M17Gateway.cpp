@@ -17,17 +17,19 @@
 */
 
 #include "M17Gateway.h"
-#include "RptNetwork.h"
+#include "LatencyHistogram.h"
+#include "FlightRecorder.h"
+#include "MetricsServer.h"
+#include "ControlServer.h"
+#include "PacketCapture.h"
 #include "Reflectors.h"
 #include "StopWatch.h"
-#include "M17Utils.h"
 #include "Version.h"
 #include "Thread.h"
-#include "M17LSF.h"
 #include "Timer.h"
-#include "Voice.h"
 #include "Utils.h"
-#include "Echo.h"
+#include "EventLog.h"
+#include "Metrics.h"
 #include "Log.h"
 #include "GitVersion.h"
 
@@ -52,21 +54,45 @@ const char* DEFAULT_INI_FILE = "/etc/M17Gateway.ini";
 #endif
 
 #include <algorithm>
+#include <csignal>
 #include <cstdio>
 #include <cstdlib>
 #include <cstdarg>
 #include <ctime>
 #include <cstring>
+#include <thread>
+
+// Work done in one pass of the main loop, in microseconds
+static const unsigned long long LOOP_BUCKETS[] = { 10ULL, 25ULL, 50ULL, 100ULL, 250ULL, 500ULL, 1000ULL, 2500ULL, 5000ULL, 10000ULL, 25000ULL };
 
 static bool m_killed = false;
 static int  m_signal = 0;
 
+static volatile sig_atomic_t m_latency = 0;
+static volatile sig_atomic_t m_flight  = 0;
+static volatile sig_atomic_t m_reload  = 0;
+
 #if !defined(_WIN32) && !defined(_WIN64)
 static void sigHandler(int signum)
 {
 	m_killed = true;
 	m_signal = signum;
 }
+
+static void sigLatency(int)
+{
+	m_latency = 1;
+}
+
+static void sigFlight(int)
+{
+	m_flight = 1;
+}
+
+static void sigReload(int)
+{
+	m_reload = 1;
+}
 #endif
 
 int main(int argc, char** argv)
@@ -90,36 +116,29 @@ int main(int argc, char** argv)
 #if !defined(_WIN32) && !defined(_WIN64)
 	::signal(SIGINT,  sigHandler);
 	::signal(SIGTERM, sigHandler);
-	::signal(SIGHUP,  sigHandler);
+	::signal(SIGHUP,  sigReload);
+	::signal(SIGUSR1, sigFlight);
+	::signal(SIGUSR2, sigLatency);
 #endif
 
-	int ret = 0;
-
-	do {
-		m_signal = 0;
-
-		CM17Gateway* gateway = new CM17Gateway(std::string(iniFile));
-		ret = gateway->run();
-
-		delete gateway;
-
-		switch (m_signal) {
-			case 0:
-				break;
-			case 2:
-				::LogInfo("M17Gateway-%s exited on receipt of SIGINT", VERSION);
-				break;
-			case 15:
-				::LogInfo("M17Gateway-%s exited on receipt of SIGTERM", VERSION);
-				break;
-			case 1:
-				::LogInfo("M17Gateway-%s is restarting on receipt of SIGHUP", VERSION);
-				break;
-			default:
-				::LogInfo("M17Gateway-%s exited on receipt of an unknown signal", VERSION);
-				break;
-		}
-	} while (m_signal == 1);
+	CM17Gateway* gateway = new CM17Gateway(std::string(iniFile));
+	int ret = gateway->run();
+
+	delete gateway;
+
+	switch (m_signal) {
+		case 0:
+			break;
+		case 2:
+			LogInfo("M17Gateway-%s exited on receipt of SIGINT", VERSION);
+			break;
+		case 15:
+			LogInfo("M17Gateway-%s exited on receipt of SIGTERM", VERSION);
+			break;
+		default:
+			LogInfo("M17Gateway-%s exited on receipt of an unknown signal", VERSION);
+			break;
+	}
 
 	::LogFinalise();
 
@@ -127,14 +146,12 @@ int main(int argc, char** argv)
 }
 
 CM17Gateway::CM17Gateway(const std::string& file) :
+m_file(file),
 m_conf(file),
-m_status(M17_STATUS::NOTLINKED),
-m_oldStatus(M17_STATUS::NOTLINKED),
-m_network(nullptr),
-m_reflector(),
-m_addrLen(0U),
-m_addr(),
-m_module(' '),
+m_repeaters(),
+m_workers(),
+m_io(nullptr),
+m_realTime(nullptr),
 m_writer(nullptr),
 m_gps(nullptr)
 {
@@ -219,6 +236,30 @@ int CM17Gateway::run()
 		return -1;
 	}
 
+	// Only reported now that there is somewhere to report them
+	const std::vector<std::string>& errors = m_conf.getErrors();
+	for (std::vector<std::string>::const_iterator it = errors.cbegin(); it != errors.cend(); ++it)
+		LogWarning("%s", it->c_str());
+
+	// The workers, the IO thread, the control server and the capture writer log from their own threads,
+	// which only the asynchronous log allows
+	bool threads = m_conf.getWorkersCount() > 0U || m_conf.getIOThreadEnabled() || m_conf.getControlEnabled() || m_conf.getCaptureEnabled();
+
+	bool async = false;
+	if ((m_conf.getLogAsync() || threads) && m_conf.getLogAsyncLength() > 0U)
+		async = ::LogStartAsync(m_conf.getLogAsyncLength());
+
+	if (threads && !async) {
+		if (m_conf.getLogAsyncLength() == 0U)
+			LogError("The workers, the IO thread, the control server and capture need an AsyncLength above 0 in [Log]");
+		else
+			LogError("Unable to start the log thread, which the workers, the IO thread, the control server and capture need");
+		return 1;
+	}
+
+	if (m_conf.getLogAsync() && !async)
+		::fprintf(stderr, "M17Gateway: unable to start the log thread, logging synchronously\n");
+
 #if !defined(_WIN32) && !defined(_WIN64)
 	if (m_daemon) {
 		::close(STDIN_FILENO);
@@ -229,485 +270,319 @@ int CM17Gateway::run()
 
 	createGPS();
 
-	CRptNetwork* localNetwork = new CRptNetwork(m_conf.getMyPort(), m_conf.getRptAddress(), m_conf.getRptPort(), m_conf.getDebug());
-	ret = localNetwork->open();
-	if (!ret)
-		return 1;
+	CPacketCapture* capture = nullptr;
+	if (m_conf.getCaptureEnabled()) {
+		capture = new CPacketCapture(m_conf.getCaptureFilePath(), m_conf.getCaptureFileRoot(), m_conf.getCaptureMaxSize(), m_conf.getCaptureFiles());
+		ret = capture->open();
+		if (!ret) {
+			delete capture;
+			capture = nullptr;
+		}
+	}
+
+	CControlServer* control = nullptr;
+	if (m_conf.getControlEnabled()) {
+		control = new CControlServer(m_conf.getControlSocket());
+		ret = control->open();
+		if (!ret) {
+			delete control;
+			control = nullptr;
+		}
+	}
 
-	m_network = new CM17Network(m_conf.getCallsign(), m_conf.getSuffix(), m_conf.getNetworkLocalPort(), m_conf.getNetworkDebug());
+	// The control server is fed by the event log even if the log itself is off
+	CEventLog* events = nullptr;
+	if (m_conf.getEventsEnabled() || control != nullptr) {
+		if (m_conf.getEventsEnabled())
+			events = new CEventLog(m_conf.getEventsFile(), m_conf.getEventsSocket());
+		else
+			events = new CEventLog("", "");
 
-	CUDPSocket* remoteSocket = nullptr;
-	if (m_conf.getRemoteCommandsEnabled()) {
-		remoteSocket = new CUDPSocket(m_conf.getRemoteCommandsPort());
-		ret = remoteSocket->open();
+		events->setControl(control);
+		ret = events->open();
 		if (!ret) {
-			delete remoteSocket;
-			remoteSocket = nullptr;
+			delete events;
+			events = nullptr;
 		}
 	}
 
+	CMetricsServer* metrics = nullptr;
+	if (m_conf.getMetricsEnabled()) {
+		metrics = new CMetricsServer(m_conf.getMetricsAddress(), m_conf.getMetricsPort(), m_conf.getMetricsSocket());
+		ret = metrics->open();
+		if (!ret) {
+			delete metrics;
+			metrics = nullptr;
+		}
+	}
+
+	CMetricHistogram& loopMetric = CMetrics::histogram("m17gateway_loop_duration_seconds", "Time spent working in one pass of the main loop", LOOP_BUCKETS, sizeof(LOOP_BUCKETS) / sizeof(LOOP_BUCKETS[0U]), 1.0E-6);
+
+	CFlightRecorder* recorder = nullptr;
+	if (m_conf.getFlightRecorderEnabled() && m_conf.getFlightRecorderSeconds() > 0U)
+		recorder = new CFlightRecorder(m_conf.getFlightRecorderFilePath(), m_conf.getFlightRecorderFileRoot(), m_conf.getFlightRecorderSeconds());
+
 	CReflectors reflectors(m_conf.getNetworkHosts1(), m_conf.getNetworkHosts2(), m_conf.getNetworkReloadTime());
 	reflectors.load();
 
-	bool triggerVoice = false;
-	CVoice* voice = nullptr;
+	// The voice audio is loaded once and shared by every repeater
+	CVoiceAssets* assets = nullptr;
 	if (m_conf.getVoiceEnabled()) {
-		voice = new CVoice(m_conf.getVoiceDirectory(), m_conf.getVoiceLanguage(), m_conf.getCallsign());
-		bool ok = voice->open();
+		assets = new CVoiceAssets(m_conf.getVoiceDirectory(), m_conf.getVoiceLanguage());
+		bool ok = assets->open();
 		if (!ok) {
-			delete voice;
-			voice = nullptr;
+			delete assets;
+			assets = nullptr;
 		}
 	}
 
-	CEcho echo(240U);
-
-	CTimer hangTimer(1000U, m_conf.getNetworkHangTime());
-
-	CStopWatch stopWatch;
-	stopWatch.start();
-
-	LogMessage("M17Gateway-%s is starting", VERSION);
-	LogMessage("Built %s %s (GitID #%.7s)", __TIME__, __DATE__, gitversion);
-
-	std::string startupReflector = m_conf.getNetworkStartup();
-	bool revert = m_conf.getNetworkRevert();
+	std::vector<CRepeaterConf> repeaters = m_conf.getRepeaters();
+	repeaters.insert(repeaters.begin(), m_conf.getRepeater());
 
-	if (voice != nullptr)
-		voice->unlinked();
+	// A lone repeater keeps the names used before there could be more than one
+	bool named = repeaters.size() > 1U;
 
-	if (!startupReflector.empty()) {
-		CM17Reflector* refl = reflectors.find(startupReflector);
-		if (refl != nullptr) {
-			char module = startupReflector.at(M17_CALLSIGN_LENGTH - 1U);
-			if (module >= 'A' && module <= 'Z') {
-				m_reflector = startupReflector;
-				m_addr      = refl->m_addr;
-				m_addrLen   = refl->m_addrLen;
-				m_module    = module;
+	for (std::vector<CRepeaterConf>::const_iterator it = repeaters.cbegin(); it != repeaters.cend(); ++it) {
+		std::string name = named ? it->m_callsign + " " + it->m_suffix : std::string();
 
-				LogMessage("Linking at startup to %s", m_reflector.c_str());
+		CM17Repeater* repeater = new CM17Repeater(*it, name, reflectors, events, m_conf.getDebug(), m_conf.getNetworkDebug());
+		ret = repeater->open();
+		if (!ret) {
+			LogError("Unable to open the repeater in the [%s] section", it->m_name.c_str());
+			delete repeater;
+			return 1;
+		}
 
-				m_status = m_oldStatus = M17_STATUS::LINKING;
-				m_network->link(m_reflector, m_addr, m_addrLen, m_module);
+		repeater->setVoice(assets);
+		repeater->setCapture(capture);
+		repeater->setFlightRecorder(recorder);
 
-				if (voice != nullptr)
-					voice->linkedTo(m_reflector);
-			}
-		} else {
-			startupReflector.clear();
-		}
+		m_repeaters.push_back(repeater);
 	}
 
-	if (voice != nullptr)
-		voice->start();
+	// APRS is only for the repeater in the General section
+	m_repeaters.front()->setGPS(m_gps);
 
-	unsigned int n = 0U;
+	CTimer statsTimer(1000U, m_conf.getControlStatsInterval());
+	if (control != nullptr && events != nullptr)
+		statsTimer.start();
 
-	while (!m_killed) {
-		M17NET_STATUS netStatus = m_network->getStatus();
-
-		switch (m_status) {
-		case M17_STATUS::LINKING:
-			switch (netStatus) {
-			case M17NET_STATUS::LINKING:
-				// Nothing to do
-				break;
-			case M17NET_STATUS::LINKED:
-				m_status = m_oldStatus = M17_STATUS::LINKED;
-				LogMessage("Linked to %s", m_reflector.c_str());
-				break;
-			case M17NET_STATUS::REJECTED:
-				m_status = m_oldStatus = M17_STATUS::NOTLINKED;
-				LogMessage("Linking rejected by %s", m_reflector.c_str());
-				if (voice != nullptr) {
-					voice->unlinked();
-					voice->start();
-				}
-				break;
-			default:
-				LogMessage("Linking failed with %s, trying again", m_reflector.c_str());
-				m_network->link(m_reflector, m_addr, m_addrLen, m_module);
-				break;
-			}
-			break;
+	CStopWatch stopWatch;
+	stopWatch.start();
 
-		case M17_STATUS::LINKED:
-			switch (netStatus) {
-			case M17NET_STATUS::LINKED:
-				// Nothing to do
-				break;
-			case M17NET_STATUS::FAILED:
-				LogMessage("Relinking to reflector %s", m_reflector.c_str());
-				m_network->link(m_reflector, m_addr, m_addrLen, m_module);
-				m_status = M17_STATUS::LINKING;
-				break;
-			default:
-				m_status = m_oldStatus = M17_STATUS::NOTLINKED;
-				LogMessage("Link failed with %s", m_reflector.c_str());
-				if (voice != nullptr) {
-					voice->unlinked();
-					voice->start();
-				}
-				break;
-			}
-			break;
+	LogMessage("M17Gateway-%s is starting", VERSION);
+	LogMessage("Built %s %s (GitID #%.7s)", __TIME__, __DATE__, gitversion);
 
-		case M17_STATUS::UNLINKING:
-			switch (netStatus) {
-			case M17NET_STATUS::UNLINKING:
-				// Nothing to do
-				break;
-			default:
-				m_status = m_oldStatus = M17_STATUS::NOTLINKED;
-				LogMessage("Unlinked from %s", m_reflector.c_str());
-				break;
-			}
-			break;
+	if (named)
+		LogMessage("Serving %u repeaters", (unsigned int)m_repeaters.size());
 
-		default:	// M17_STATUS::NOTLINKED or M17_STATUS::ECHO
-			break;
-		}
+	createRealTime();
 
-		unsigned char buffer[100U];
-
-		if (m_status == M17_STATUS::LINKED) {
-			// From the reflector to the MMDVM
-			bool ret = m_network->read(buffer);
-			if (ret) {
-				CM17LSF lsf;
-				lsf.setNetwork(buffer + 6U);
-
-				if (n > 40U) {
-					// Change the type to show that it's callsign data
-					lsf.setEncryptionType(M17_ENCRYPTION_TYPE_NONE);
-					lsf.setEncryptionSubType(M17_ENCRYPTION_SUB_TYPE_CALLSIGNS);
-
-					// Copy the encoded source and the reflector into the META field
-					unsigned char meta[M17_META_LENGTH_BYTES];
-					::memset(meta, 0x00U, M17_META_LENGTH_BYTES);
-					::memcpy(meta + 0U, buffer + 12U, 6U);
-					CM17Utils::encodeCallsign(m_reflector, meta + 6U);
-					lsf.setMeta(meta);
-
-					if (n > 45U)
-						n = 0U;
-				}
+	ret = createIOThread();
+	if (!ret)
+		return 1;
 
-				n++;
+	for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it)
+		(*it)->start();
 
-				// Replace the destination callsign with the broadcast callsign
-				lsf.setDest("ALL");
-				lsf.getNetwork(buffer + 6U);
+	// The time spent in the main loop and in the shared clocks, the rest belongs to the repeaters
+	CLatencyHistogram loopTime("Main loop");
+	CLatencyHistogram aprsClock("APRS clock");
+	CLatencyHistogram reflectorsClock("Reflectors clock");
 
-				localNetwork->write(buffer);
+	std::vector<CLatencyHistogram*> latencies;
+	latencies.push_back(&loopTime);
+	latencies.push_back(&aprsClock);
+	latencies.push_back(&reflectorsClock);
 
-				uint16_t fn = (buffer[34U] << 8) + (buffer[35U] << 0);
-				if ((fn & 0x8000U) == 0x8000U)
-					n = 0U;
+	createWorkers();
 
-				hangTimer.start();
-			}
-		} else if (m_status == M17_STATUS::ECHO) {
-			// From the echo unit to the MMDVM
-			ECHO_STATE est = echo.read(buffer);
-			switch (est) {
-				case ECHO_STATE::DATA:
-					if (n > 40U) {
-						CM17LSF lsf;
-						lsf.setNetwork(buffer + 6U);
-
-						// Change the type to show that it's callsign data
-						lsf.setEncryptionType(M17_ENCRYPTION_TYPE_NONE);
-						lsf.setEncryptionSubType(M17_ENCRYPTION_SUB_TYPE_CALLSIGNS);
-
-						// Copy the encoded source into the META field
-						unsigned char meta[M17_META_LENGTH_BYTES];
-						::memset(meta, 0x00U, M17_META_LENGTH_BYTES);
-						::memcpy(meta + 0U, buffer + 12U, 6U);
-						lsf.setMeta(meta);
-
-						lsf.getNetwork(buffer + 6U);
-
-						if (n > 45U)
-							n = 0U;
-					}
-
-					n++;
-
-					localNetwork->write(buffer);
-
-					hangTimer.start();
-					break;
-
-				case ECHO_STATE::END:
-					// End of the message, restore the original status
-					m_status = m_oldStatus;
-					n = 0U;
-					break;
-
-				default:
-					break;
-			}
-		}
+	// Without workers the repeaters run in the main loop, and share its histograms
+	if (m_workers.empty()) {
+		for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it)
+			(*it)->setLatencies(latencies);
 
-		// From the MMDVM to the reflector or control data
-		bool ret = localNetwork->read(buffer);
-		if (ret) {
-			CM17LSF lsf;
-			lsf.setNetwork(buffer + 6U);
+		for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it)
+			(*it)->getLatencies(latencies);
+	}
 
-			std::string src = lsf.getSource();
-			std::string dst = lsf.getDest();
+	// Without an IO thread or workers the forwarding is done by the main loop
+	if (m_realTime != nullptr && m_io == nullptr && m_workers.empty())
+		m_realTime->apply("Main loop");
 
-			if (m_gps != nullptr)
-				m_gps->process(lsf);
+	CMetricCounter& majorMetric = CMetrics::counter("m17gateway_page_faults_total", "Page faults of the whole process", "type=\"major\"");
+	CMetricCounter& minorMetric = CMetrics::counter("m17gateway_page_faults_total", "Page faults of the whole process", "type=\"minor\"");
 
-			if (dst == "ECHO") {
-				if (m_status != M17_STATUS::ECHO) {
-					m_oldStatus = m_status;
-					echo.clear();
-				}
+	// Counted once a second, the first count marks the end of the startup
+	CTimer faultTimer(1000U, 1U);
+	faultTimer.start();
 
-				echo.write(buffer);
-				m_status = M17_STATUS::ECHO;
-				hangTimer.start();
-
-				uint16_t fn = (buffer[34U] << 8) + (buffer[35U] << 0);
-				if ((fn & 0x8000U) == 0x8000U)
-					echo.end();
-			} else if (dst == "INFO") {
-				hangTimer.start();
-				triggerVoice = true;
-			} else if (dst == "UNLINK") {
-				if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING) {
-					LogMessage("Unlinking from reflector %s triggered by %s", m_reflector.c_str(), src.c_str());
-
-					m_status = m_oldStatus = M17_STATUS::UNLINKING;
-					m_network->unlink();
-
-					if (voice != nullptr)
-						voice->unlinked();
-				}
+	bool startup = true;
+	unsigned long long startMajor = 0ULL, startMinor = 0ULL;
+	unsigned long long lastMajor  = 0ULL, lastMinor  = 0ULL;
 
-				triggerVoice = true;
-				hangTimer.stop();
-			} else if (dst.size() == M17_CALLSIGN_LENGTH) {
-				std::string reflector = dst;
-				char module = reflector.at(M17_CALLSIGN_LENGTH - 1U);
-
-				if (reflector != m_reflector && module >= 'A' && module <= 'Z') {
-					if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING) {
-						LogMessage("Unlinking from reflector %s triggered by %s", m_reflector.c_str(), src.c_str());
-
-						m_network->unlink();
-					}
-
-					triggerVoice = true;
-
-					CM17Reflector* refl = reflectors.find(reflector);
-					if (refl != nullptr) {
-						m_reflector = reflector;
-						m_addr      = refl->m_addr;
-						m_addrLen   = refl->m_addrLen;
-						m_module    = module;
-
-						// Link to the new reflector
-						LogMessage("Linking to reflector %s triggered by %s", m_reflector.c_str(), src.c_str());
-
-						m_status = m_oldStatus = M17_STATUS::LINKING;
-						m_network->link(m_reflector, m_addr, m_addrLen, m_module);
-
-						if (voice != nullptr)
-							voice->linkedTo(m_reflector);
-
-						hangTimer.start();
-					} else {
-						if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING)
-							m_status = m_oldStatus = M17_STATUS::UNLINKING;
-
-						if (voice != nullptr)
-							voice->unlinked();
-
-						hangTimer.stop();
-					}
-				} else {
-					if (m_status == M17_STATUS::LINKED) {
-						// Replace the destination callsign with the reflector name and module
-						CM17Utils::encodeCallsign(m_reflector, buffer + 6U);
-						m_network->write(buffer);
-						hangTimer.start();
-					}
-				}
-			} else {
-				if (m_status == M17_STATUS::LINKED) {
-					// Replace the destination callsign with the reflector name and module
-					CM17Utils::encodeCallsign(m_reflector, buffer + 6U);
-					m_network->write(buffer);
-					hangTimer.start();
-				}
-			}
-		}
+	unsigned long long dropped = 0ULL;
 
-		if (voice != nullptr) {
-			if (triggerVoice) {
-				uint16_t fn = (buffer[34U] << 8) + (buffer[35U] << 0);
-				if ((fn & 0x8000U) == 0x8000U) {
-					voice->start();
-					triggerVoice = false;
-				}
-			}
+	while (!m_killed) {
+		unsigned long long loopStart = CStopWatch::nanoseconds();
 
-			ret = voice->read(buffer);
-			if (ret)
-				localNetwork->write(buffer);
-		}
+		if (recorder != nullptr)
+			recorder->setTime(loopStart);
 
-		if (remoteSocket != nullptr) {
-			sockaddr_storage addr;
-			unsigned int addrLen;
-			int res = remoteSocket->read(buffer, 200U, addr, addrLen);
-			if (res > 0) {
-				buffer[res] = '\0';
-				if (::memcmp(buffer + 0U, "Reflector", 9U) == 0) {
-					std::string reflector = ((strlen((char*)buffer + 0U) > 10) ? std::string((char*)(buffer + 10U)) : "");
-					std::replace(reflector.begin(), reflector.end(), '_', ' ');
-					reflector.resize(M17_CALLSIGN_LENGTH, ' ');
-
-					if (reflector != m_reflector) {
-						if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING) {
-							LogMessage("Unlinked from reflector %s by remote command", m_reflector.c_str());
-
-							m_network->unlink();
-
-							hangTimer.stop();
-						}
-
-						CM17Reflector* refl = reflectors.find(reflector);
-						if (refl != nullptr) {
-							char module = reflector.at(M17_CALLSIGN_LENGTH - 1U);
-							if (module >= 'A' && module <= 'Z') {
-								m_reflector = reflector;
-								m_addr      = refl->m_addr;
-								m_addrLen   = refl->m_addrLen;
-								m_module    = module;
-
-								// Link to the new reflector
-								LogMessage("Switched to reflector %s by remote command", m_reflector.c_str());
-
-								m_status = m_oldStatus = M17_STATUS::LINKING;
-								m_network->link(m_reflector, m_addr, m_addrLen, m_module);
-
-								if (voice != nullptr) {
-									voice->linkedTo(m_reflector);
-									voice->start();
-								}
-
-								hangTimer.start();
-							}
-						} else {
-							m_reflector.clear();
-							if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING) {
-								m_status = m_oldStatus = M17_STATUS::UNLINKING;
-
-								if (voice != nullptr) {
-									voice->unlinked();
-									voice->start();
-								}
-							}
-
-							hangTimer.stop();
-						}
-					}
-				} else if (::memcmp(buffer + 0U, "status", 6U) == 0) {
-					std::string state = std::string("m17:") + ((m_network == nullptr) ? "n/a" : ((m_network->getStatus() == M17NET_STATUS::LINKED) ? "conn" : "disc"));
-					remoteSocket->write((unsigned char*)state.c_str(), (unsigned int)state.length(), addr, addrLen);
-				} else if (::memcmp(buffer + 0U, "host", 4U) == 0) {
-					std::string ref(m_reflector);
-					std::replace(ref.begin(), ref.end(), ' ', '_');
-					std::string host = std::string("m17:\"") + (((m_network == nullptr) || (ref.length() == 0)) ? "NONE" : ref) + "\"";
-					remoteSocket->write((unsigned char*)host.c_str(), (unsigned int)host.length(), addr, addrLen);
-				} else {
-					CUtils::dump("Invalid remote command received", buffer, res);
-				}
-			}
+		// Each repeater handles at most one frame from each side per pass, so a busy one can't starve the others
+		if (m_workers.empty()) {
+			for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it)
+				(*it)->process();
 		}
 
 		unsigned int ms = stopWatch.elapsed();
 		stopWatch.start();
 
-		if (voice != nullptr)
-			voice->clock(ms);
+		unsigned long long clockStart = CStopWatch::nanoseconds();
 
 		if (m_writer != nullptr)
 			m_writer->clock(ms);
+		clockStart = aprsClock.recordSince(clockStart);
 
 		reflectors.clock(ms);
+		reflectorsClock.recordSince(clockStart);
 
-		localNetwork->clock(ms);
+		bool linkLost = false;
+		unsigned long long total = 0ULL;
+		for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it) {
+			if (m_workers.empty())
+				(*it)->clock(ms);
 
-		m_network->clock(ms);
+			if ((*it)->hasLostLink())
+				linkLost = true;
 
-		echo.clock(ms);
+			total += (*it)->getDropped();
+		}
 
-		hangTimer.clock(ms);
-		if (hangTimer.isRunning() && hangTimer.hasExpired()) {
-			if (revert && !startupReflector.empty() && m_reflector != startupReflector) {
-				if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING)
-					m_network->unlink();
+		loopMetric.observe((loopTime.recordSince(loopStart) - loopStart) / 1000ULL);
 
-				LogMessage("Relinked from %s to %s due to inactivity", m_reflector.c_str(), startupReflector.c_str());
+		if (recorder != nullptr) {
+			if (m_flight != 0) {
+				m_flight = 0;
+				recorder->dump(FLIGHT_REASON::SIGNAL, true);
+			} else if (linkLost) {
+				recorder->dump(FLIGHT_REASON::LINK_LOST);
+			} else if (total > dropped) {
+				recorder->dump(FLIGHT_REASON::OVERFLOW);
+			}
+		}
 
-				CM17Reflector* refl = reflectors.find(startupReflector);
-				m_reflector = startupReflector;
-				m_addr      = refl->m_addr;
-				m_addrLen   = refl->m_addrLen;
-				m_module    = startupReflector.at(M17_CALLSIGN_LENGTH - 1U);
+		dropped = total;
 
-				m_status = m_oldStatus = M17_STATUS::LINKING;
-				m_network->link(m_reflector, m_addr, m_addrLen, m_module);
+		if (m_reload != 0) {
+			m_reload = 0;
+			reload(reflectors, statsTimer);
+		}
 
-				if (voice != nullptr) {
-					voice->linkedTo(startupReflector);
-					voice->start();
-				}
+		if (m_latency != 0) {
+			m_latency = 0;
 
-				hangTimer.start();
-			} else if (revert && startupReflector.empty() && (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING)) {
-				LogMessage("Unlinking from %s due to inactivity", m_reflector.c_str());
+			for (std::vector<CLatencyHistogram*>::const_iterator it = latencies.cbegin(); it != latencies.cend(); ++it) {
+				std::string text;
+				(*it)->format(text);
+				text.pop_back();
+				LogMessage("Latency, %s", text.c_str());
+			}
+
+			for (std::vector<CWorker*>::const_iterator it = m_workers.cbegin(); it != m_workers.cend(); ++it)
+				(*it)->logLatencies();
+
+			if (m_io != nullptr)
+				m_io->logLatencies();
+		}
+
+		statsTimer.clock(ms);
+		if (statsTimer.hasExpired()) {
+			for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it)
+				(*it)->stats();
 
-				m_status = m_oldStatus = M17_STATUS::UNLINKING;
-				m_network->unlink();
+			statsTimer.start();
+		}
 
-				if (voice != nullptr) {
-					voice->unlinked();
-					voice->start();
+		faultTimer.clock(ms);
+		if (faultTimer.hasExpired()) {
+			unsigned long long major, minor;
+			if (CRealTime::getPageFaults(major, minor)) {
+				if (startup) {
+					if (m_realTime != nullptr)
+						LogMessage("Real time, %llu major and %llu minor page faults during startup", major, minor);
+
+					startMajor = major;
+					startMinor = minor;
+					startup    = false;
+				} else if (m_realTime != nullptr && major > lastMajor) {
+					LogWarning("Real time, %llu major page faults while running", major - lastMajor);
 				}
 
-				m_reflector.clear();
+				majorMetric.inc(major - lastMajor);
+				minorMetric.inc(minor - lastMinor);
 
-				hangTimer.stop();
+				lastMajor = major;
+				lastMinor = minor;
 			}
+
+			faultTimer.start();
 		}
 
 		if (ms < 5U)
 			CThread::sleep(5U);
 	}
 
-	delete voice;
+	if (m_realTime != nullptr && !startup)
+		LogMessage("Real time, %llu major and %llu minor page faults since startup", lastMajor - startMajor, lastMinor - startMinor);
+
+	for (std::vector<CWorker*>::const_iterator it = m_workers.cbegin(); it != m_workers.cend(); ++it) {
+		(*it)->stop();
+		delete *it;
+	}
+
+	m_workers.clear();
+
+	// The forwarders are closed by their repeaters, once nothing else is running them
+	if (m_io != nullptr) {
+		m_io->stop();
+		delete m_io;
+		m_io = nullptr;
+	}
+
+	for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it) {
+		(*it)->close();
+		delete *it;
+	}
+
+	m_repeaters.clear();
+
+	delete assets;
+
+	if (capture != nullptr) {
+		capture->close();
+		delete capture;
+	}
+
+	if (events != nullptr) {
+		events->close();
+		delete events;
+	}
 
-	localNetwork->close();
-	delete localNetwork;
+	if (metrics != nullptr) {
+		metrics->close();
+		delete metrics;
+	}
 
-	if (remoteSocket != nullptr) {
-		remoteSocket->close();
-		delete remoteSocket;
+	if (control != nullptr) {
+		control->close();
+		delete control;
 	}
 
-	if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING)
-		m_network->unlink();
-	m_network->close();
-	delete m_network;
+	delete recorder;
+
+	delete m_realTime;
+	m_realTime = nullptr;
 
 	if (m_gps != nullptr) {
 		m_writer->close();
@@ -718,6 +593,81 @@ int CM17Gateway::run()
 	return 0;
 }
 
+// Everything is touched and locked in memory before the forwarding threads start
+void CM17Gateway::createRealTime()
+{
+	if (!m_conf.getRealTimeEnabled())
+		return;
+
+	std::string policy = m_conf.getRealTimePolicy();
+	if (policy != "FIFO" && policy != "RR") {
+		LogWarning("Real time, unknown policy \"%s\", using FIFO", policy.c_str());
+		policy = "FIFO";
+	}
+
+	unsigned int priority = m_conf.getRealTimePriority();
+	if (priority < 1U || priority > 99U) {
+		LogWarning("Real time, the priority must be from 1 to 99, using 50");
+		priority = 50U;
+	}
+
+	if (m_conf.getRealTimePrefault()) {
+		for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it)
+			(*it)->prefault();
+	}
+
+	if (m_conf.getRealTimeLockMemory())
+		CRealTime::lockMemory();
+
+	m_realTime = new CRealTime(policy, priority, m_conf.getRealTimeCPU(), m_conf.getRealTimePrefault());
+}
+
+// Hands the forwarders of every repeater to a thread of their own
+bool CM17Gateway::createIOThread()
+{
+	if (!m_conf.getIOThreadEnabled())
+		return true;
+
+	m_io = new CIOThread;
+	m_io->setRealTime(m_realTime);
+
+	for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it)
+		m_io->add((*it)->detach());
+
+	// The repeaters can't take their forwarders back, so there is no going on without it
+	return m_io->start();
+}
+
+// Shares the repeaters among the workers, the main loop then only does the shared work
+void CM17Gateway::createWorkers()
+{
+	unsigned int count = m_conf.getWorkersCount();
+	if (count == 0U)
+		return;
+
+	if (count > m_repeaters.size())
+		count = (unsigned int)m_repeaters.size();
+
+	unsigned int cpus = std::thread::hardware_concurrency();
+	bool pin = m_conf.getWorkersPin() && cpus > 0U;
+
+	for (unsigned int i = 0U; i < count; i++) {
+		CWorker* worker = new CWorker(i + 1U, pin ? int(i % cpus) : -1);
+
+		// The forwarding is only theirs without an IO thread
+		if (m_io == nullptr)
+			worker->setRealTime(m_realTime);
+
+		m_workers.push_back(worker);
+	}
+
+	for (unsigned int i = 0U; i < m_repeaters.size(); i++)
+		m_workers.at(i % count)->add(m_repeaters.at(i));
+
+	for (std::vector<CWorker*>::const_iterator it = m_workers.cbegin(); it != m_workers.cend(); ++it)
+		(*it)->start();
+}
+
 void CM17Gateway::createGPS()
 {
 	if (!m_conf.getAPRSEnabled())
@@ -762,3 +712,118 @@ void CM17Gateway::createGPS()
 
 	m_gps = new CGPSHandler(callsign, rptSuffix, m_writer);
 }
+
+// Applies the settings that can change while running, and says which need a restart
+void CM17Gateway::reload(CReflectors& reflectors, CTimer& statsTimer)
+{
+	CConf conf(m_file);
+	if (!conf.read()) {
+		LogError("Reload, cannot read %s, keeping the current configuration", m_file.c_str());
+		return;
+	}
+
+	LogMessage("Reloading the configuration from %s", m_file.c_str());
+
+	const std::vector<std::string>& errors = conf.getErrors();
+	for (std::vector<std::string>::const_iterator it = errors.cbegin(); it != errors.cend(); ++it)
+		LogWarning("%s", it->c_str());
+
+	std::vector<std::string> reloadable, restart;
+	conf.diff(m_conf, reloadable, restart);
+
+	// The settings needing a restart are never taken, so each is only reported the first time it differs
+	std::set<std::string> warned;
+	std::vector<std::string> unreported;
+	for (std::vector<std::string>::const_iterator it = restart.cbegin(); it != restart.cend(); ++it) {
+		if (m_warned.count(*it) == 0U)
+			unreported.push_back(*it);
+		warned.insert(*it);
+	}
+	m_warned = warned;
+
+	if (reloadable.empty() && unreported.empty()) {
+		LogMessage("Reload complete, nothing has changed");
+		return;
+	}
+
+	unsigned int changes = 0U;
+
+	if (conf.getLogFileLevel() != m_conf.getLogFileLevel() || conf.getLogDisplayLevel() != m_conf.getLogDisplayLevel()) {
+		::LogSetLevels(conf.getLogFileLevel(), conf.getLogDisplayLevel());
+		LogMessage("Reload, the log levels are now %u for the file and %u for the display", conf.getLogFileLevel(), conf.getLogDisplayLevel());
+		changes++;
+	}
+
+	// Each repeater from its own section, the first from [General] and [Network]
+	std::vector<CRepeaterConf> current = m_conf.getRepeaters();
+	current.insert(current.begin(), m_conf.getRepeater());
+
+	std::vector<CRepeaterConf> repeaters = conf.getRepeaters();
+	repeaters.insert(repeaters.begin(), conf.getRepeater());
+
+	// A change to the number of repeaters needs a restart, until then only the existing ones are changed
+	for (unsigned int n = 0U; n < m_repeaters.size() && n < current.size() && n < repeaters.size(); n++) {
+		const CRepeaterConf& was = current.at(n);
+		const CRepeaterConf& now = repeaters.at(n);
+
+		if (now.m_hangTime != was.m_hangTime) {
+			m_repeaters.at(n)->setHangTime(now.m_hangTime);
+			LogMessage("Reload, the hang time of [%s] is now %us", now.m_name.c_str(), now.m_hangTime);
+			changes++;
+		}
+
+		if (now.m_startup != was.m_startup || now.m_revert != was.m_revert) {
+			m_repeaters.at(n)->setStartup(now.m_startup, now.m_revert);
+			changes++;
+		}
+	}
+
+	if (conf.getNetworkHosts1() != m_conf.getNetworkHosts1() || conf.getNetworkHosts2() != m_conf.getNetworkHosts2() || conf.getNetworkReloadTime() != m_conf.getNetworkReloadTime()) {
+		reflectors.setHostsFiles(conf.getNetworkHosts1(), conf.getNetworkHosts2(), conf.getNetworkReloadTime());
+		reflectors.load();
+		changes++;
+	}
+
+	if (conf.getControlStatsInterval() != m_conf.getControlStatsInterval()) {
+		statsTimer.setTimeout(conf.getControlStatsInterval());
+		changes++;
+	}
+
+	bool aprs = conf.getAPRSEnabled() != m_conf.getAPRSEnabled() || conf.getAPRSAddress() != m_conf.getAPRSAddress() ||
+		conf.getAPRSPort() != m_conf.getAPRSPort() || conf.getAPRSSuffix() != m_conf.getAPRSSuffix() ||
+		conf.getAPRSDescription() != m_conf.getAPRSDescription() || conf.getAPRSSymbol() != m_conf.getAPRSSymbol() ||
+		conf.getTxFrequency() != m_conf.getTxFrequency() || conf.getRxFrequency() != m_conf.getRxFrequency() ||
+		conf.getLatitude() != m_conf.getLatitude() || conf.getLongitude() != m_conf.getLongitude() || conf.getHeight() != m_conf.getHeight();
+
+	// These are bound into sockets, threads or files opened at startup
+	for (std::vector<std::string>::const_iterator it = unreported.cbegin(); it != unreported.cend(); ++it)
+		LogWarning("Reload, %s has changed, a restart is needed to apply it", it->c_str());
+
+	m_conf.update(conf);
+
+	// A worker may be using the GPS handler at any time
+	if (aprs && !m_workers.empty()) {
+		LogWarning("Reload, APRS has changed, a restart is needed to apply it when running workers");
+		aprs = false;
+	}
+
+	if (aprs) {
+		if (m_writer != nullptr) {
+			m_writer->close();
+			delete m_writer;
+			m_writer = nullptr;
+		}
+
+		delete m_gps;
+		m_gps = nullptr;
+
+		createGPS();
+
+		m_repeaters.front()->setGPS(m_gps);
+
+		LogMessage("Reload, APRS has been restarted");
+		changes++;
+	}
+
+	LogMessage("Reload complete, %u change%s applied", changes, (changes == 1U) ? "" : "s");
+}
@@ -19,13 +19,19 @@
 #if !defined(M17Gateway_H)
 #define	M17Gateway_H
 
-#include "M17Network.h"
+#include "M17Repeater.h"
+#include "IOThread.h"
+#include "RealTime.h"
+#include "Worker.h"
 #include "APRSWriter.h"
+#include "Reflectors.h"
 #include "GPSHandler.h"
 #include "Conf.h"
+#include "Timer.h"
 
 #include <cstdio>
 #include <string>
+#include <set>
 #include <vector>
 
 #if !defined(_WIN32) && !defined(_WIN64)
@@ -40,14 +46,6 @@
 #include <winsock.h>
 #endif
 
-enum class M17_STATUS {
-	NOTLINKED,
-	LINKED,
-	LINKING,
-	UNLINKING,
-	ECHO
-};
-
 class CM17Gateway
 {
 public:
@@ -57,18 +55,21 @@ public:
 	int run();
 
 private:
-	CConf            m_conf;
-	M17_STATUS       m_status;
-	M17_STATUS       m_oldStatus;
-	CM17Network*     m_network;
-	std::string      m_reflector;
-	unsigned int     m_addrLen;
-	sockaddr_storage m_addr;
-	char             m_module;
-	CAPRSWriter*     m_writer;
-	CGPSHandler*     m_gps;
+	std::string                m_file;
+	CConf                      m_conf;
+	std::set<std::string>      m_warned;
+	std::vector<CM17Repeater*> m_repeaters;
+	std::vector<CWorker*>      m_workers;
+	CIOThread*                 m_io;
+	CRealTime*                 m_realTime;
+	CAPRSWriter*               m_writer;
+	CGPSHandler*               m_gps;
 
+	void createRealTime();
+	bool createIOThread();
+	void createWorkers();
 	void createGPS();
+	void reload(CReflectors& reflectors, CTimer& statsTimer);
 };
 
 #endif
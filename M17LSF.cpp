@@ -24,14 +24,13 @@
 #include <cstring>
 
 CM17LSF::CM17LSF() :
-m_lsf(nullptr)
+m_lsf()
 {
-	m_lsf = new unsigned char[M17_LSF_LENGTH_BYTES];
+	::memset(m_lsf, 0x00U, M17_LSF_LENGTH_BYTES);
 }
 
 CM17LSF::~CM17LSF()
 {
-	delete[] m_lsf;
 }
 
 void CM17LSF::getNetwork(unsigned char* data) const
@@ -53,6 +52,13 @@ std::string CM17LSF::getSource() const
 	return CM17Utils::decodeCallsign(m_lsf + 6U);
 }
 
+void CM17LSF::getSource(char* callsign) const
+{
+	assert(callsign != nullptr);
+
+	CM17Utils::decodeCallsign(m_lsf + 6U, callsign);
+}
+
 void CM17LSF::setSource(const std::string& callsign)
 {
 	CM17Utils::encodeCallsign(callsign, m_lsf + 6U);
@@ -63,6 +69,13 @@ std::string CM17LSF::getDest() const
 	return CM17Utils::decodeCallsign(m_lsf + 0U);
 }
 
+void CM17LSF::getDest(char* callsign) const
+{
+	assert(callsign != nullptr);
+
+	CM17Utils::decodeCallsign(m_lsf + 0U, callsign);
+}
+
 void CM17LSF::setDest(const std::string& callsign)
 {
 	CM17Utils::encodeCallsign(callsign, m_lsf + 0U);
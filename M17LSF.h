@@ -19,6 +19,8 @@
 #if !defined(M17LSF_H)
 #define  M17LSF_H
 
+#include "M17Defines.h"
+
 #include <string>
 
 class CM17LSF {
@@ -30,9 +32,12 @@ public:
 	void setNetwork(const unsigned char* data);
 
 	std::string getSource() const;
+	// Decodes into a buffer of at least M17_CALLSIGN_LENGTH + 2 characters, without allocating
+	void getSource(char* callsign) const;
 	void setSource(const std::string& callsign);
 
 	std::string getDest() const;
+	void getDest(char* callsign) const;
 	void setDest(const std::string& callsign);
 
 	unsigned char getPacketStream() const;
@@ -54,7 +59,7 @@ public:
 	void setMeta(const unsigned char* data);
 
 private:
-	unsigned char* m_lsf;
+	unsigned char m_lsf[M17_LSF_LENGTH_BYTES];
 };
 
 #endif
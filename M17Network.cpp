@@ -19,6 +19,7 @@
 #include "M17Network.h"
 #include "M17Defines.h"
 #include "M17Utils.h"
+#include "StopWatch.h"
 #include "Utils.h"
 #include "Log.h"
 
@@ -28,8 +29,9 @@
 
 const unsigned int BUFFER_LENGTH = 200U;
 
-CM17Network::CM17Network(const std::string& callsign, const std::string& suffix, unsigned short port, bool debug) :
+CM17Network::CM17Network(const std::string& callsign, const std::string& suffix, unsigned short port, bool debug, const std::string& labels) :
 m_socket(port),
+m_localPort(port),
 m_name(),
 m_addr(),
 m_addrLen(0U),
@@ -39,7 +41,14 @@ m_state(M17NET_STATUS::NOTLINKED),
 m_encoded(nullptr),
 m_module(' '),
 m_timer(1000U, 3U),
-m_timeout(1000U, 60U)
+m_timeout(1000U, 60U),
+m_capture(nullptr),
+m_timestamp(0ULL),
+m_framesRx(CMetrics::counter("m17gateway_frames_received_total", "Stream frames received", CMetrics::join("network=\"reflector\"", labels))),
+m_framesTx(CMetrics::counter("m17gateway_frames_sent_total", "Stream frames sent", CMetrics::join("network=\"reflector\"", labels))),
+m_dropped(CMetrics::counter("m17gateway_frames_dropped_total", "Stream frames dropped because the buffer was full", CMetrics::join("network=\"reflector\"", labels))),
+m_invalid(CMetrics::counter("m17gateway_packets_invalid_total", "Packets from an unknown source or of an unknown type", CMetrics::join("network=\"reflector\"", labels))),
+m_failures(CMetrics::counter("m17gateway_reflector_link_failures_total", "Links to a reflector that failed or were lost", labels))
 {
 	assert(!callsign.empty());
 	assert(!suffix.empty());
@@ -109,6 +118,11 @@ bool CM17Network::write(const unsigned char* data)
 	if (m_debug)
 		CUtils::dump(1U, "Network Data Transmitted", data, M17_NETWORK_FRAME_LENGTH);
 
+	if (m_capture != nullptr)
+		m_capture->write(CAPTURE_DIRECTION::OUTBOUND, m_localPort, m_addr, data, M17_NETWORK_FRAME_LENGTH);
+
+	m_framesTx.inc();
+
 	return m_socket.write(data, M17_NETWORK_FRAME_LENGTH, m_addr, m_addrLen);
 }
 
@@ -137,6 +151,7 @@ void CM17Network::clock(unsigned int ms)
 		case M17NET_STATUS::LINKING:
 			LogMessage("Linking failed with reflector %s", m_name.c_str());
 			m_state = M17NET_STATUS::FAILED;
+			m_failures.inc();
 			break;
 		case M17NET_STATUS::UNLINKING:
 			m_state = M17NET_STATUS::NOTLINKED;
@@ -144,6 +159,7 @@ void CM17Network::clock(unsigned int ms)
 		case M17NET_STATUS::LINKED:
 			LogMessage("Link lost to reflector %s", m_name.c_str());
 			m_state = M17NET_STATUS::FAILED;
+			m_failures.inc();
 			break;
 		default:
 			LogWarning("Timeout in state %d", int(m_state));
@@ -164,17 +180,29 @@ void CM17Network::clock(unsigned int ms)
 	if (length <= 0)
 		return;
 
+	unsigned long long timestamp = CStopWatch::nanoseconds();
+
+	if (m_capture != nullptr)
+		m_capture->write(CAPTURE_DIRECTION::INBOUND, m_localPort, address, buffer, length);
+
 	if (m_state == M17NET_STATUS::NOTLINKED || m_state == M17NET_STATUS::REJECTED || m_state == M17NET_STATUS::FAILED)
 		return;
 
 	if (!CUDPSocket::match(m_addr, address)) {
 		LogMessage("Packet received from an invalid source");
+		m_invalid.inc();
 		return;
 	}
 
 	if (m_debug)
 		CUtils::dump(1U, "Network Data Received", buffer, length);
 
+	if (length < 4) {
+		CUtils::dump(2U, "Received a runt packet", buffer, length);
+		m_invalid.inc();
+		return;
+	}
+
 	if (::memcmp(buffer + 0U, "ACKN", 4U) == 0) {
 		m_timeout.start();
 		m_timer.stop();
@@ -209,16 +237,31 @@ void CM17Network::clock(unsigned int ms)
 
 	if (::memcmp(buffer + 0U, "M17 ", 4U) != 0) {
 		CUtils::dump(2U, "Received an unknown packet", buffer, length);
+		m_invalid.inc();
+		return;
+	}
+
+	// Everything downstream works on whole frames
+	if (length != int(M17_NETWORK_FRAME_LENGTH)) {
+		CUtils::dump(2U, "Received a frame of the wrong length", buffer, length);
+		m_invalid.inc();
 		return;
 	}
 
 	if (m_state == M17NET_STATUS::LINKED) {
 		m_timeout.start();
 
-		unsigned char c = length;
-		m_buffer.addData(&c, 1U);
+		m_framesRx.inc();
 
-		m_buffer.addData(buffer, length);
+		// The frames are all the same length, so the records in the buffer are too
+		if (!m_buffer.hasSpace(sizeof(timestamp) + M17_NETWORK_FRAME_LENGTH)) {
+			m_dropped.inc();
+			return;
+		}
+
+		m_buffer.addData((unsigned char*)&timestamp, sizeof(timestamp));
+
+		m_buffer.addData(buffer, M17_NETWORK_FRAME_LENGTH);
 	}
 }
 
@@ -229,10 +272,9 @@ bool CM17Network::read(unsigned char* data)
 	if (m_buffer.isEmpty())
 		return false;
 
-	unsigned char c = 0U;
-	m_buffer.getData(&c, 1U);
+	m_buffer.getData((unsigned char*)&m_timestamp, sizeof(m_timestamp));
 
-	m_buffer.getData(data, c);
+	m_buffer.getData(data, M17_NETWORK_FRAME_LENGTH);
 
 	return true;
 }
@@ -249,6 +291,29 @@ M17NET_STATUS CM17Network::getStatus() const
 	return m_state;
 }
 
+void CM17Network::setCapture(CPacketCapture* capture)
+{
+	m_capture = capture;
+}
+
+unsigned long long CM17Network::getTimestamp() const
+{
+	return m_timestamp;
+}
+
+unsigned long long CM17Network::getDropped() const
+{
+	return m_dropped.get();
+}
+
+void CM17Network::getStats(unsigned long long& received, unsigned long long& sent, unsigned long long& dropped, unsigned long long& invalid) const
+{
+	received = m_framesRx.get();
+	sent     = m_framesTx.get();
+	dropped  = m_dropped.get();
+	invalid  = m_invalid.get();
+}
+
 void CM17Network::sendConnect()
 {
 	unsigned char buffer[15U];
@@ -272,6 +337,9 @@ void CM17Network::sendConnect()
 	if (m_debug)
 		CUtils::dump(1U, "network Data Transmitted", buffer, 11U);
 
+	if (m_capture != nullptr)
+		m_capture->write(CAPTURE_DIRECTION::OUTBOUND, m_localPort, m_addr, buffer, 11U);
+
 	m_socket.write(buffer, 11U, m_addr, m_addrLen);
 }
 
@@ -294,6 +362,9 @@ void CM17Network::sendPong()
 	if (m_debug)
 		CUtils::dump(1U, "Network Data Transmitted", buffer, 10U);
 
+	if (m_capture != nullptr)
+		m_capture->write(CAPTURE_DIRECTION::OUTBOUND, m_localPort, m_addr, buffer, 10U);
+
 	m_socket.write(buffer, 10U, m_addr, m_addrLen);
 }
 
@@ -316,5 +387,8 @@ void CM17Network::sendDisconnect()
 	if (m_debug)
 		CUtils::dump(1U, "Network Data Transmitted", buffer, 10U);
 
+	if (m_capture != nullptr)
+		m_capture->write(CAPTURE_DIRECTION::OUTBOUND, m_localPort, m_addr, buffer, 10U);
+
 	m_socket.write(buffer, 10U, m_addr, m_addrLen);
 }
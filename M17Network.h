@@ -19,8 +19,10 @@
 #ifndef	M17Network_H
 #define	M17Network_H
 
+#include "PacketCapture.h"
 #include "M17Defines.h"
 #include "RingBuffer.h"
+#include "Metrics.h"
 #include "UDPSocket.h"
 #include "Timer.h"
 
@@ -37,7 +39,7 @@ enum class M17NET_STATUS {
 
 class CM17Network {
 public:
-	CM17Network(const std::string& callsign, const std::string& suffix, unsigned short port, bool debug);
+	CM17Network(const std::string& callsign, const std::string& suffix, unsigned short port, bool debug, const std::string& labels);
 	~CM17Network();
 
 	bool link(const std::string& name, const sockaddr_storage& addr, unsigned int addrLen, char module);
@@ -46,6 +48,7 @@ public:
 
 	bool write(const unsigned char* data);
 
+	// A whole frame of M17_NETWORK_FRAME_LENGTH bytes
 	bool read(unsigned char* data);
 
 	void close();
@@ -54,8 +57,18 @@ public:
 
 	M17NET_STATUS getStatus() const;
 
+	void setCapture(CPacketCapture* capture);
+
+	// The time that the last frame read was received, from CStopWatch::nanoseconds()
+	unsigned long long getTimestamp() const;
+
+	unsigned long long getDropped() const;
+
+	void getStats(unsigned long long& received, unsigned long long& sent, unsigned long long& dropped, unsigned long long& invalid) const;
+
 private:
 	CUDPSocket       m_socket;
+	unsigned short   m_localPort;
 	std::string      m_name;
 	sockaddr_storage m_addr;
 	unsigned int     m_addrLen;
@@ -66,6 +79,13 @@ private:
 	char             m_module;
 	CTimer           m_timer;
 	CTimer           m_timeout;
+	CPacketCapture*  m_capture;
+	unsigned long long m_timestamp;
+	CMetricCounter&  m_framesRx;
+	CMetricCounter&  m_framesTx;
+	CMetricCounter&  m_dropped;
+	CMetricCounter&  m_invalid;
+	CMetricCounter&  m_failures;
 
 	void sendConnect();
 	void sendDisconnect();
@@ -0,0 +1,940 @@
+/*
+ *   Copyright (C) 2016,2017,2018,2020,2021,2024,2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "M17Repeater.h"
+#include "StopWatch.h"
+#include "M17Utils.h"
+#include "M17LSF.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+static const char* STATUS_TEXT[] = { "notlinked", "linked", "linking", "unlinking", "echo" };
+
+const unsigned int REMOTE_LENGTH      = 1000U;
+const unsigned int REMOTE_MAX_RESULTS = 100U;
+
+const unsigned int PENDING_HANG_TIME = 0x01U;
+const unsigned int PENDING_STARTUP   = 0x02U;
+
+CM17Repeater::CM17Repeater(const CRepeaterConf& conf, const std::string& name, CReflectors& reflectors, CEventLog* events, bool debug, bool networkDebug) :
+m_name(name),
+m_prefix(name.empty() ? std::string() : name + ", "),
+m_callsign(conf.m_callsign),
+m_reflectors(reflectors),
+m_forwarder(nullptr),
+m_attached(true),
+m_netStatus(M17NET_STATUS::NOTLINKED),
+m_sequence(0U),
+m_routeLinked(false),
+m_routeReflector(),
+m_remotePort(conf.m_remotePort),
+m_remoteSocket(nullptr),
+m_remote(),
+m_voice(nullptr),
+m_echo(name, 240U),
+m_events(events),
+m_recorder(nullptr),
+m_gps(nullptr),
+m_rfStream(name, STREAM_DIRECTION::RF, events),
+m_netStream(name, STREAM_DIRECTION::NET, events),
+m_status(M17_STATUS::NOTLINKED),
+m_oldStatus(M17_STATUS::NOTLINKED),
+m_linkStatus(M17_STATUS::NOTLINKED),
+m_recordedStatus(M17_STATUS::NOTLINKED),
+m_linkElapsed(0U),
+m_linkLost(false),
+m_statsDue(false),
+m_mutex(),
+m_pending(0U),
+m_pendingHangTime(0U),
+m_pendingStartup(),
+m_pendingRevert(false),
+m_reflector(),
+m_addr(),
+m_addrLen(0U),
+m_module(' '),
+m_startup(conf.m_startup),
+m_revert(conf.m_revert),
+m_hangTimer(1000U, conf.m_hangTime),
+m_n(0U),
+m_triggerVoice(false),
+m_voiceClock(CMetrics::histogramName(name, "Voice clock")),
+m_echoClock(CMetrics::histogramName(name, "Echo clock")),
+m_latencies(),
+m_statusMetric(CMetrics::gauge("m17gateway_link_status", "0 not linked, 1 linked, 2 linking, 3 unlinking, 4 echo", CMetrics::labelsFor(name)))
+{
+	m_echo.setEvents(events);
+
+	std::string labels = CMetrics::labelsFor(name);
+
+	for (unsigned int i = 0U; i < 5U; i++)
+		m_stateMetrics[i] = &CMetrics::counter("m17gateway_link_state_milliseconds_total", "Time spent in each link state", CMetrics::join(labels, std::string("state=\"") + STATUS_TEXT[i] + "\""));
+
+	m_forwarder = new CM17Forwarder(conf, name, debug, networkDebug);
+}
+
+CM17Repeater::~CM17Repeater()
+{
+	delete m_voice;
+	delete m_forwarder;
+	delete m_remoteSocket;
+}
+
+void CM17Repeater::setVoice(const CVoiceAssets* assets)
+{
+	if (assets == nullptr)
+		return;
+
+	m_voice = new CVoice(*assets, m_callsign);
+	m_voice->setEvents(m_events);
+}
+
+void CM17Repeater::setCapture(CPacketCapture* capture)
+{
+	m_forwarder->setCapture(capture);
+}
+
+void CM17Repeater::setFlightRecorder(CFlightRecorder* recorder)
+{
+	m_recorder = recorder;
+
+	m_forwarder->setFlightRecorder(recorder);
+}
+
+void CM17Repeater::setGPS(CGPSHandler* gps)
+{
+	m_gps = gps;
+}
+
+void CM17Repeater::setLatencies(const std::vector<CLatencyHistogram*>& latencies)
+{
+	m_latencies = latencies;
+
+	getLatencies(m_latencies);
+}
+
+bool CM17Repeater::open()
+{
+	bool ret = m_forwarder->open();
+	if (!ret)
+		return false;
+
+	if (m_remotePort > 0U) {
+		m_remoteSocket = new CUDPSocket(m_remotePort);
+		ret = m_remoteSocket->open();
+		if (!ret) {
+			delete m_remoteSocket;
+			m_remoteSocket = nullptr;
+		}
+	}
+
+	return true;
+}
+
+void CM17Repeater::prefault()
+{
+	m_echo.prefault();
+
+	if (m_voice != nullptr)
+		m_voice->prefault();
+}
+
+void CM17Repeater::start()
+{
+	if (m_voice != nullptr)
+		m_voice->unlinked();
+
+	if (!m_startup.empty()) {
+		CM17Reflector refl;
+		if (m_reflectors.find(m_startup, refl)) {
+			char module = m_startup.at(M17_CALLSIGN_LENGTH - 1U);
+			if (module >= 'A' && module <= 'Z') {
+				m_reflector = m_startup;
+				m_addr      = refl.m_addr;
+				m_addrLen   = refl.m_addrLen;
+				m_module    = module;
+
+				LogMessage("%sLinking at startup to %s", m_prefix.c_str(), m_reflector.c_str());
+
+				m_status = m_oldStatus = M17_STATUS::LINKING;
+				link();
+
+				if (m_voice != nullptr)
+					m_voice->linkedTo(m_reflector);
+			}
+		} else {
+			m_startup.clear();
+		}
+	}
+
+	if (m_voice != nullptr)
+		m_voice->start();
+
+	m_recordedStatus = m_status;
+}
+
+CM17Forwarder* CM17Repeater::detach()
+{
+	m_attached = false;
+
+	return m_forwarder;
+}
+
+bool CM17Repeater::process()
+{
+	applyPending();
+
+	bool busy = false;
+
+	if (m_attached && m_forwarder->process())
+		busy = true;
+
+	CForwarderEvent event;
+	while (m_forwarder->event(event)) {
+		switch (event.m_type) {
+		case FORWARDER_EVENT::STATUS:
+			// One from before the last link or unlink no longer holds
+			if (event.m_sequence == m_sequence)
+				m_netStatus = event.m_status;
+			break;
+
+		case FORWARDER_EVENT::NET:
+			m_netStream.write(event.m_data);
+			m_hangTimer.start();
+			busy = true;
+			break;
+
+		case FORWARDER_EVENT::RF:
+			rfFrame(event.m_data, event.m_forwarded);
+			busy = true;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	switch (m_status) {
+	case M17_STATUS::LINKING:
+		switch (m_netStatus) {
+		case M17NET_STATUS::LINKING:
+			// Nothing to do
+			break;
+		case M17NET_STATUS::LINKED:
+			m_status = m_oldStatus = M17_STATUS::LINKED;
+			LogMessage("%sLinked to %s", m_prefix.c_str(), m_reflector.c_str());
+			break;
+		case M17NET_STATUS::REJECTED:
+			m_status = m_oldStatus = M17_STATUS::NOTLINKED;
+			LogMessage("%sLinking rejected by %s", m_prefix.c_str(), m_reflector.c_str());
+			if (m_voice != nullptr) {
+				m_voice->unlinked();
+				m_voice->start();
+			}
+			break;
+		default:
+			LogMessage("%sLinking failed with %s, trying again", m_prefix.c_str(), m_reflector.c_str());
+			link();
+			break;
+		}
+		break;
+
+	case M17_STATUS::LINKED:
+		switch (m_netStatus) {
+		case M17NET_STATUS::LINKED:
+			// Nothing to do
+			break;
+		case M17NET_STATUS::FAILED:
+			m_linkLost = true;
+			LogMessage("%sRelinking to reflector %s", m_prefix.c_str(), m_reflector.c_str());
+			link();
+			m_status = M17_STATUS::LINKING;
+			break;
+		default:
+			m_linkLost = true;
+			m_status = m_oldStatus = M17_STATUS::NOTLINKED;
+			LogMessage("%sLink failed with %s", m_prefix.c_str(), m_reflector.c_str());
+			if (m_voice != nullptr) {
+				m_voice->unlinked();
+				m_voice->start();
+			}
+			break;
+		}
+		break;
+
+	case M17_STATUS::UNLINKING:
+		switch (m_netStatus) {
+		case M17NET_STATUS::UNLINKING:
+			// Nothing to do
+			break;
+		default:
+			m_status = m_oldStatus = M17_STATUS::NOTLINKED;
+			LogMessage("%sUnlinked from %s", m_prefix.c_str(), m_reflector.c_str());
+			break;
+		}
+		break;
+
+	default:	// M17_STATUS::NOTLINKED or M17_STATUS::ECHO
+		break;
+	}
+
+	unsigned char buffer[100U];
+
+	if (m_status == M17_STATUS::ECHO) {
+		// From the echo unit to the MMDVM
+		ECHO_STATE est = m_echo.read(buffer);
+		switch (est) {
+			case ECHO_STATE::DATA:
+				if (m_n > 40U) {
+					// Only the source goes into the META field
+					CM17Utils::injectCallsigns(buffer, nullptr);
+
+					if (m_n > 45U)
+						m_n = 0U;
+				}
+
+				m_n++;
+
+				write(buffer);
+
+				m_hangTimer.start();
+				break;
+
+			case ECHO_STATE::END:
+				// End of the message
+				m_n = 0U;
+				break;
+
+			default:
+				break;
+		}
+
+		// Restore the original status once every echo session has been played
+		if (!m_echo.isBusy()) {
+			m_status = m_oldStatus;
+			m_n = 0U;
+		}
+	}
+
+	if (m_voice != nullptr) {
+		bool ret = m_voice->read(buffer);
+		if (ret)
+			write(buffer);
+	}
+
+	route();
+
+	remoteCommands();
+
+	return busy;
+}
+
+// A frame from the MMDVM, which the forwarder has already sent on to the reflector if it was for it
+void CM17Repeater::rfFrame(const unsigned char* data, bool forwarded)
+{
+	assert(data != nullptr);
+
+	m_rfStream.write(data);
+
+	CM17LSF lsf;
+	lsf.setNetwork(data + 6U);
+
+	char src[M17_CALLSIGN_LENGTH + 2U], dst[M17_CALLSIGN_LENGTH + 2U];
+	lsf.getSource(src);
+	lsf.getDest(dst);
+
+	if (m_gps != nullptr)
+		m_gps->process(lsf);
+
+	if (::strcmp(dst, "ECHO") == 0) {
+		if (m_status != M17_STATUS::ECHO)
+			m_oldStatus = m_status;
+
+		// Each source and stream id is recorded and played back as its own session
+		m_echo.write(data);
+		m_status = M17_STATUS::ECHO;
+		m_hangTimer.start();
+	} else if (::strcmp(dst, "INFO") == 0) {
+		m_hangTimer.start();
+		m_triggerVoice = true;
+	} else if (::strcmp(dst, "UNLINK") == 0) {
+		if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING) {
+			LogMessage("%sUnlinking from reflector %s triggered by %s", m_prefix.c_str(), m_reflector.c_str(), src);
+
+			m_status = m_oldStatus = M17_STATUS::UNLINKING;
+			unlink();
+
+			if (m_voice != nullptr)
+				m_voice->unlinked();
+		}
+
+		m_triggerVoice = true;
+		m_hangTimer.stop();
+	} else if (::strlen(dst) == M17_CALLSIGN_LENGTH) {
+		char module = dst[M17_CALLSIGN_LENGTH - 1U];
+
+		if (m_reflector != dst && module >= 'A' && module <= 'Z') {
+			// Only a change of reflector needs a string
+			std::string reflector(dst);
+
+			if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING) {
+				LogMessage("%sUnlinking from reflector %s triggered by %s", m_prefix.c_str(), m_reflector.c_str(), src);
+
+				unlink();
+			}
+
+			m_triggerVoice = true;
+
+			CM17Reflector refl;
+			if (m_reflectors.find(reflector, refl)) {
+				m_reflector = reflector;
+				m_addr      = refl.m_addr;
+				m_addrLen   = refl.m_addrLen;
+				m_module    = module;
+
+				// Link to the new reflector
+				LogMessage("%sLinking to reflector %s triggered by %s", m_prefix.c_str(), m_reflector.c_str(), src);
+
+				m_status = m_oldStatus = M17_STATUS::LINKING;
+				link();
+
+				if (m_voice != nullptr)
+					m_voice->linkedTo(m_reflector);
+
+				m_hangTimer.start();
+			} else {
+				if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING)
+					m_status = m_oldStatus = M17_STATUS::UNLINKING;
+
+				if (m_voice != nullptr)
+					m_voice->unlinked();
+
+				m_hangTimer.stop();
+			}
+		} else if (forwarded) {
+			m_hangTimer.start();
+		}
+	} else if (forwarded) {
+		m_hangTimer.start();
+	}
+
+	if (m_voice != nullptr && m_triggerVoice) {
+		uint16_t fn = (data[34U] << 8) + (data[35U] << 0);
+		if ((fn & 0x8000U) == 0x8000U) {
+			m_voice->start();
+			m_triggerVoice = false;
+		}
+	}
+}
+
+void CM17Repeater::link()
+{
+	CForwarderCommand command;
+	command.m_type     = FORWARDER_COMMAND::LINK;
+	command.m_sequence = m_sequence + 1U;
+	::memset(command.m_reflector, 0x00U, M17_CALLSIGN_LENGTH + 1U);
+	::strncpy(command.m_reflector, m_reflector.c_str(), M17_CALLSIGN_LENGTH);
+	command.m_addr     = m_addr;
+	command.m_addrLen  = m_addrLen;
+	command.m_module   = m_module;
+
+	// Without the link the status stays as it was, and the link is tried again
+	if (!m_forwarder->command(command)) {
+		LogWarning("%sUnable to pass the link to %s to the forwarder", m_prefix.c_str(), m_reflector.c_str());
+		return;
+	}
+
+	m_sequence  = command.m_sequence;
+	m_netStatus = M17NET_STATUS::LINKING;
+}
+
+void CM17Repeater::unlink()
+{
+	CForwarderCommand command;
+	command.m_type     = FORWARDER_COMMAND::UNLINK;
+	command.m_sequence = m_sequence + 1U;
+
+	if (!m_forwarder->command(command)) {
+		LogWarning("%sUnable to pass the unlink from %s to the forwarder", m_prefix.c_str(), m_reflector.c_str());
+		return;
+	}
+
+	m_sequence = command.m_sequence;
+	if (m_netStatus == M17NET_STATUS::LINKED || m_netStatus == M17NET_STATUS::LINKING)
+		m_netStatus = M17NET_STATUS::UNLINKING;
+}
+
+// Frames from the echo and the voice, to the MMDVM
+void CM17Repeater::write(const unsigned char* data)
+{
+	assert(data != nullptr);
+
+	CForwarderCommand command;
+	command.m_type = FORWARDER_COMMAND::WRITE;
+	::memcpy(command.m_data, data, M17_NETWORK_FRAME_LENGTH);
+
+	m_forwarder->command(command);
+}
+
+// Frames only pass between the MMDVM and the reflector while linked, tells the forwarder when that changes
+void CM17Repeater::route()
+{
+	bool linked = m_status == M17_STATUS::LINKED;
+	if (linked == m_routeLinked && m_reflector == m_routeReflector)
+		return;
+
+	CForwarderCommand command;
+	command.m_type   = FORWARDER_COMMAND::ROUTE;
+	command.m_linked = linked;
+	::memset(command.m_reflector, 0x00U, M17_CALLSIGN_LENGTH + 1U);
+	::strncpy(command.m_reflector, m_reflector.c_str(), M17_CALLSIGN_LENGTH);
+
+	// Tried again on the next pass if the queue is full
+	if (m_forwarder->command(command)) {
+		m_routeLinked    = linked;
+		m_routeReflector = m_reflector;
+	}
+}
+
+void CM17Repeater::remoteCommands()
+{
+	if (m_remoteSocket != nullptr) {
+		unsigned char command[REMOTE_LENGTH];
+		sockaddr_storage addr;
+		unsigned int addrLen;
+		int res = m_remoteSocket->read(command, REMOTE_LENGTH, addr, addrLen);
+		if (res > 0) {
+			unsigned int count = m_remote.parse(command, res);
+			bool binary = m_remote.isBinary();
+
+			for (unsigned int i = 0U; i < count; i++) {
+				REMOTE_COMMAND type = m_remote.getCommand(i);
+
+				switch (type) {
+				case REMOTE_COMMAND::REFLECTOR:
+				case REMOTE_COMMAND::LINK: {
+						std::string reflector = m_remote.getArgument(i);
+						std::replace(reflector.begin(), reflector.end(), '_', ' ');
+						reflector.resize(M17_CALLSIGN_LENGTH, ' ');
+
+						CM17Reflector refl;
+						bool found = m_reflectors.find(reflector, refl);
+						char module = reflector.at(M17_CALLSIGN_LENGTH - 1U);
+
+						// Unlike the old Reflector command, link leaves an unknown reflector alone
+						if (type == REMOTE_COMMAND::LINK && (!found || module < 'A' || module > 'Z')) {
+							m_remote.error(i, "unknown reflector " + m_remote.getArgument(i));
+							break;
+						}
+
+						if (reflector != m_reflector) {
+							if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING) {
+								LogMessage("%sUnlinked from reflector %s by remote command", m_prefix.c_str(), m_reflector.c_str());
+
+								unlink();
+
+								m_hangTimer.stop();
+							}
+
+							if (found) {
+								if (module >= 'A' && module <= 'Z') {
+									m_reflector = reflector;
+									m_addr      = refl.m_addr;
+									m_addrLen   = refl.m_addrLen;
+									m_module    = module;
+
+									// Link to the new reflector
+									LogMessage("%sSwitched to reflector %s by remote command", m_prefix.c_str(), m_reflector.c_str());
+
+									m_status = m_oldStatus = M17_STATUS::LINKING;
+									link();
+
+									if (m_voice != nullptr) {
+										m_voice->linkedTo(m_reflector);
+										m_voice->start();
+									}
+
+									m_hangTimer.start();
+								}
+							} else {
+								m_reflector.clear();
+								if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING) {
+									m_status = m_oldStatus = M17_STATUS::UNLINKING;
+
+									if (m_voice != nullptr) {
+										m_voice->unlinked();
+										m_voice->start();
+									}
+								}
+
+								m_hangTimer.stop();
+							}
+						}
+
+						// The Reflector command has never had a reply
+						m_remote.reply(i, (binary || type == REMOTE_COMMAND::REFLECTOR) ? "" : "link:ok");
+					}
+					break;
+
+				case REMOTE_COMMAND::UNLINK:
+					if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING) {
+						LogMessage("%sUnlinked from reflector %s by remote command", m_prefix.c_str(), m_reflector.c_str());
+
+						m_status = m_oldStatus = M17_STATUS::UNLINKING;
+						unlink();
+
+						if (m_voice != nullptr) {
+							m_voice->unlinked();
+							m_voice->start();
+						}
+					}
+
+					m_reflector.clear();
+					m_hangTimer.stop();
+
+					m_remote.reply(i, binary ? "" : "unlink:ok");
+					break;
+
+				case REMOTE_COMMAND::STATUS:
+					if (binary) {
+						std::string payload;
+						CRemoteCommand::put8(payload, uint8_t(m_status));
+						CRemoteCommand::putText(payload, m_reflector, M17_CALLSIGN_LENGTH);
+						m_remote.reply(i, payload);
+					} else {
+						m_remote.reply(i, std::string("m17:") + ((m_netStatus == M17NET_STATUS::LINKED) ? "conn" : "disc"));
+					}
+					break;
+
+				case REMOTE_COMMAND::HOST:
+					if (binary) {
+						std::string payload;
+						CRemoteCommand::putText(payload, m_reflector, M17_CALLSIGN_LENGTH);
+						m_remote.reply(i, payload);
+					} else {
+						std::string ref(m_reflector);
+						std::replace(ref.begin(), ref.end(), ' ', '_');
+						m_remote.reply(i, std::string("m17:\"") + (ref.empty() ? "NONE" : ref) + "\"");
+					}
+					break;
+
+				case REMOTE_COMMAND::ECHO:
+					if (binary) {
+						std::string payload;
+						CRemoteCommand::put8(payload, uint8_t(m_echo.getSessionCount()));
+						CRemoteCommand::put32(payload, m_echo.getCurrentBytes());
+						CRemoteCommand::put32(payload, m_echo.getPeakBytes());
+						m_remote.reply(i, payload);
+					} else {
+						char text[100U];
+						::sprintf(text, "echo:sessions=%u,bytes=%u,peak=%u", m_echo.getSessionCount(), m_echo.getCurrentBytes(), m_echo.getPeakBytes());
+						m_remote.reply(i, text);
+					}
+					break;
+
+				case REMOTE_COMMAND::STATS: {
+						unsigned long long netStats[4U], rptStats[4U];
+						m_forwarder->getStats(netStats, rptStats);
+
+						if (binary) {
+							std::string payload;
+							CRemoteCommand::put8(payload, uint8_t(m_linkStatus));
+							CRemoteCommand::put32(payload, m_linkElapsed / 1000U);
+							CRemoteCommand::putText(payload, m_reflector, M17_CALLSIGN_LENGTH);
+							for (unsigned int j = 0U; j < 4U; j++)
+								CRemoteCommand::put32(payload, uint32_t(netStats[j]));
+							for (unsigned int j = 0U; j < 4U; j++)
+								CRemoteCommand::put32(payload, uint32_t(rptStats[j]));
+							m_remote.reply(i, payload);
+						} else {
+							char text[400U];
+							::sprintf(text, "stats:state=%s,seconds=%u,reflector=%s,net_rx=%llu,net_tx=%llu,net_dropped=%llu,net_invalid=%llu,rpt_rx=%llu,rpt_tx=%llu,rpt_dropped=%llu,rpt_invalid=%llu",
+								STATUS_TEXT[int(m_linkStatus)], m_linkElapsed / 1000U, m_reflector.c_str(),
+								netStats[0U], netStats[1U], netStats[2U], netStats[3U], rptStats[0U], rptStats[1U], rptStats[2U], rptStats[3U]);
+							m_remote.reply(i, text);
+						}
+					}
+					break;
+
+				case REMOTE_COMMAND::STREAMS: {
+						const CStreamTracker* streams[] = { &m_rfStream, &m_netStream };
+
+						std::string payload = binary ? "" : "streams:";
+						if (binary)
+							CRemoteCommand::put8(payload, uint8_t(m_rfStream.isActive() + m_netStream.isActive()));
+
+						for (unsigned int j = 0U; j < 2U; j++) {
+							const CStreamTracker* stream = streams[j];
+							if (!stream->isActive())
+								continue;
+
+							if (binary) {
+								CRemoteCommand::put8(payload, uint8_t(j));
+								CRemoteCommand::put16(payload, stream->getId());
+								CRemoteCommand::putText(payload, stream->getSource(), M17_CALLSIGN_LENGTH);
+								CRemoteCommand::putText(payload, stream->getDest(), M17_CALLSIGN_LENGTH);
+								CRemoteCommand::put32(payload, stream->getDuration());
+								CRemoteCommand::put32(payload, stream->getFrames());
+								CRemoteCommand::put32(payload, stream->getLost());
+							} else {
+								char text[150U];
+								::sprintf(text, "%s%s,%04X,%s,%s,%u,%u,%u", (payload.size() > 8U) ? ";" : "", (j == 0U) ? "rf" : "net", stream->getId(),
+									stream->getSource(), stream->getDest(), stream->getDuration(), stream->getFrames(), stream->getLost());
+								payload += text;
+							}
+						}
+
+						m_remote.reply(i, payload);
+					}
+					break;
+
+				case REMOTE_COMMAND::SEARCH: {
+						std::vector<std::string> names;
+						m_reflectors.search(m_remote.getArgument(i), names, REMOTE_MAX_RESULTS);
+
+						std::string payload = binary ? "" : "search:";
+						if (binary)
+							CRemoteCommand::put8(payload, uint8_t(names.size()));
+
+						for (std::vector<std::string>::const_iterator it = names.cbegin(); it != names.cend(); ++it) {
+							if (binary) {
+								CRemoteCommand::putText(payload, *it, M17_CALLSIGN_LENGTH - 2U);
+							} else {
+								if (it != names.cbegin())
+									payload += ',';
+								payload += it->substr(0U, it->find_last_not_of(' ') + 1U);
+							}
+						}
+
+						m_remote.reply(i, payload);
+					}
+					break;
+
+				case REMOTE_COMMAND::METRICS: {
+						std::string text;
+						CMetrics::format(text);
+						if (!binary && !text.empty())
+							text.pop_back();
+						m_remote.reply(i, text);
+					}
+					break;
+
+				case REMOTE_COMMAND::LATENCY: {
+						std::string text;
+						for (std::vector<CLatencyHistogram*>::const_iterator it = m_latencies.cbegin(); it != m_latencies.cend(); ++it)
+							(*it)->format(text);
+						if (!binary && !text.empty())
+							text.pop_back();
+						m_remote.reply(i, text);
+					}
+					break;
+
+				default:
+					LogWarning("%sInvalid remote command received - %s", m_prefix.c_str(), m_remote.getName(i).c_str());
+					m_remote.error(i, "unknown command " + m_remote.getName(i));
+					break;
+				}
+			}
+
+			const std::string& reply = m_remote.getReply();
+			if (!reply.empty())
+				m_remoteSocket->write((const unsigned char*)reply.data(), (unsigned int)reply.size(), addr, addrLen);
+		}
+	}
+}
+
+void CM17Repeater::clock(unsigned int ms)
+{
+	unsigned long long clockStart = CStopWatch::nanoseconds();
+
+	if (m_voice != nullptr)
+		m_voice->clock(ms);
+	clockStart = m_voiceClock.recordSince(clockStart);
+
+	// The forwarder's own histograms cover its clock
+	if (m_attached)
+		m_forwarder->clock(ms);
+	clockStart = CStopWatch::nanoseconds();
+
+	m_echo.clock(ms);
+	m_echoClock.recordSince(clockStart);
+
+	m_rfStream.clock(ms);
+	m_netStream.clock(ms);
+
+	m_hangTimer.clock(ms);
+	if (m_hangTimer.isRunning() && m_hangTimer.hasExpired()) {
+		// The startup reflector may have gone from the hosts files since it was checked
+		CM17Reflector refl;
+		if (m_revert && !m_startup.empty() && m_reflector != m_startup && m_reflectors.find(m_startup, refl)) {
+			if (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING)
+				unlink();
+
+			LogMessage("%sRelinked from %s to %s due to inactivity", m_prefix.c_str(), m_reflector.c_str(), m_startup.c_str());
+
+			m_reflector = m_startup;
+			m_addr      = refl.m_addr;
+			m_addrLen   = refl.m_addrLen;
+			m_module    = m_startup.at(M17_CALLSIGN_LENGTH - 1U);
+
+			m_status = m_oldStatus = M17_STATUS::LINKING;
+			link();
+
+			if (m_voice != nullptr) {
+				m_voice->linkedTo(m_startup);
+				m_voice->start();
+			}
+
+			m_hangTimer.start();
+		} else if (m_revert && m_startup.empty() && (m_status == M17_STATUS::LINKED || m_status == M17_STATUS::LINKING)) {
+			LogMessage("%sUnlinking from %s due to inactivity", m_prefix.c_str(), m_reflector.c_str());
+
+			m_status = m_oldStatus = M17_STATUS::UNLINKING;
+			unlink();
+
+			if (m_voice != nullptr) {
+				m_voice->unlinked();
+				m_voice->start();
+			}
+
+			m_reflector.clear();
+
+			m_hangTimer.stop();
+		}
+	}
+
+	m_stateMetrics[int(m_status)]->inc(ms);
+	m_statusMetric.set(int(m_status));
+
+	if (m_recorder != nullptr && m_status != m_recordedStatus) {
+		m_recorder->state((unsigned int)m_recordedStatus, (unsigned int)m_status);
+		m_recordedStatus = m_status;
+	}
+
+	M17_STATUS status = (m_status == M17_STATUS::ECHO) ? m_oldStatus : m_status;
+	if (status != m_linkStatus) {
+		if (m_events != nullptr)
+			m_events->linkState(m_name.c_str(), STATUS_TEXT[int(status)], m_reflector.c_str());
+
+		m_linkStatus  = status;
+		m_linkElapsed = 0U;
+	} else {
+		m_linkElapsed += ms;
+	}
+
+	route();
+
+	if (m_statsDue.exchange(false))
+		sendStats();
+}
+
+void CM17Repeater::setHangTime(unsigned int hangTime)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_pendingHangTime = hangTime;
+	m_pending.fetch_or(PENDING_HANG_TIME);
+}
+
+// Only used when the hang timer next expires, the current link stays
+void CM17Repeater::setStartup(const std::string& reflector, bool revert)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_pendingStartup = reflector;
+	m_pendingRevert  = revert;
+	m_pending.fetch_or(PENDING_STARTUP);
+}
+
+void CM17Repeater::stats()
+{
+	m_statsDue.store(true);
+}
+
+bool CM17Repeater::hasLostLink()
+{
+	return m_linkLost.exchange(false);
+}
+
+unsigned long long CM17Repeater::getDropped() const
+{
+	return m_forwarder->getDropped();
+}
+
+const std::string& CM17Repeater::getName() const
+{
+	return m_name;
+}
+
+void CM17Repeater::getLatencies(std::vector<CLatencyHistogram*>& latencies)
+{
+	// Those of a detached forwarder belong to the thread running it
+	if (m_attached)
+		m_forwarder->getLatencies(latencies);
+
+	latencies.push_back(&m_voiceClock);
+	latencies.push_back(&m_echoClock);
+}
+
+// The settings changed by a reload, taken up by the thread running the repeater
+void CM17Repeater::applyPending()
+{
+	if (m_pending.load(std::memory_order_relaxed) == 0U)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	unsigned int pending = m_pending.exchange(0U);
+
+	if ((pending & PENDING_HANG_TIME) == PENDING_HANG_TIME)
+		m_hangTimer.setTimeout(m_pendingHangTime);
+
+	if ((pending & PENDING_STARTUP) == PENDING_STARTUP) {
+		m_startup = m_pendingStartup;
+
+		CM17Reflector refl;
+		if (!m_startup.empty() && !m_reflectors.find(m_startup, refl))
+			m_startup.clear();
+
+		m_revert = m_pendingRevert;
+
+		LogMessage("%sReload, the startup reflector is now \"%s\" with revert %s", m_prefix.c_str(), m_startup.c_str(), m_revert ? "on" : "off");
+	}
+}
+
+void CM17Repeater::sendStats()
+{
+	if (m_events == nullptr)
+		return;
+
+	unsigned long long netStats[4U], rptStats[4U];
+	m_forwarder->getStats(netStats, rptStats);
+
+	m_events->stats(m_name.c_str(), STATUS_TEXT[int(m_linkStatus)], m_reflector.c_str(), m_linkElapsed / 1000U, netStats, rptStats);
+}
+
+void CM17Repeater::close()
+{
+	if (m_remoteSocket != nullptr)
+		m_remoteSocket->close();
+
+	m_forwarder->close();
+}
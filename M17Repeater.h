@@ -0,0 +1,166 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(M17Repeater_H)
+#define	M17Repeater_H
+
+#include "LatencyHistogram.h"
+#include "FlightRecorder.h"
+#include "StreamTracker.h"
+#include "RemoteCommand.h"
+#include "PacketCapture.h"
+#include "M17Forwarder.h"
+#include "VoiceAssets.h"
+#include "GPSHandler.h"
+#include "Reflectors.h"
+#include "EventLog.h"
+#include "UDPSocket.h"
+#include "Metrics.h"
+#include "Timer.h"
+#include "Voice.h"
+#include "Conf.h"
+#include "Echo.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class M17_STATUS {
+	NOTLINKED,
+	LINKED,
+	LINKING,
+	UNLINKING,
+	ECHO
+};
+
+// One MMDVM host and its link to a reflector, with its own echo, voice and
+// remote command port. The reflector table and the voice audio are shared
+// with the other repeaters of the gateway, everything else is its own. The
+// frames are moved by its forwarder, which it runs itself unless another
+// thread has been given the forwarder.
+class CM17Repeater {
+public:
+	// The name is empty when the gateway only serves one repeater
+	CM17Repeater(const CRepeaterConf& conf, const std::string& name, CReflectors& reflectors, CEventLog* events, bool debug, bool networkDebug);
+	~CM17Repeater();
+
+	void setVoice(const CVoiceAssets* assets);
+	void setCapture(CPacketCapture* capture);
+	void setFlightRecorder(CFlightRecorder* recorder);
+	// Only before the repeater is started
+	void setGPS(CGPSHandler* gps);
+
+	// Histograms from the gateway, included in the reply to the latency command
+	void setLatencies(const std::vector<CLatencyHistogram*>& latencies);
+
+	bool open();
+
+	// Touches the echo and voice buffers so that they don't fault mid stream
+	void prefault();
+
+	// Links to the startup reflector and announces the link state
+	void start();
+
+	// Only before the repeater is started, the forwarder is then run by the
+	// caller and is still owned by the repeater
+	CM17Forwarder* detach();
+
+	// A single pass, which handles the frames passed on by the forwarder. True
+	// if there were any, so a worker knows whether to sleep.
+	bool process();
+
+	void clock(unsigned int ms);
+
+	// These may be called from any thread, they take effect at the next pass
+	void setHangTime(unsigned int hangTime);
+	void setStartup(const std::string& reflector, bool revert);
+
+	void stats();
+
+	// True once after the link to a reflector has been lost, from any thread
+	bool hasLostLink();
+
+	unsigned long long getDropped() const;
+
+	const std::string& getName() const;
+
+	void getLatencies(std::vector<CLatencyHistogram*>& latencies);
+
+	// Only once the forwarder has stopped running
+	void close();
+
+private:
+	std::string                     m_name;
+	std::string                     m_prefix;
+	std::string                     m_callsign;
+	CReflectors&                    m_reflectors;
+	CM17Forwarder*                  m_forwarder;
+	bool                            m_attached;
+	M17NET_STATUS                   m_netStatus;
+	unsigned int                    m_sequence;
+	bool                            m_routeLinked;
+	std::string                     m_routeReflector;
+	unsigned short                  m_remotePort;
+	CUDPSocket*                     m_remoteSocket;
+	CRemoteCommand                  m_remote;
+	CVoice*                         m_voice;
+	CEcho                           m_echo;
+	CEventLog*                      m_events;
+	CFlightRecorder*                m_recorder;
+	CGPSHandler*                    m_gps;
+	CStreamTracker                  m_rfStream;
+	CStreamTracker                  m_netStream;
+	M17_STATUS                      m_status;
+	M17_STATUS                      m_oldStatus;
+	M17_STATUS                      m_linkStatus;
+	M17_STATUS                      m_recordedStatus;
+	unsigned int                    m_linkElapsed;
+	std::atomic<bool>               m_linkLost;
+	std::atomic<bool>               m_statsDue;
+	std::mutex                      m_mutex;
+	std::atomic<unsigned int>       m_pending;
+	unsigned int                    m_pendingHangTime;
+	std::string                     m_pendingStartup;
+	bool                            m_pendingRevert;
+	std::string                     m_reflector;
+	sockaddr_storage                m_addr;
+	unsigned int                    m_addrLen;
+	char                            m_module;
+	std::string                     m_startup;
+	bool                            m_revert;
+	CTimer                          m_hangTimer;
+	unsigned int                    m_n;
+	bool                            m_triggerVoice;
+	CLatencyHistogram               m_voiceClock;
+	CLatencyHistogram               m_echoClock;
+	std::vector<CLatencyHistogram*> m_latencies;
+	CMetricGauge&                   m_statusMetric;
+	CMetricCounter*                 m_stateMetrics[5U];
+
+	void rfFrame(const unsigned char* data, bool forwarded);
+	void link();
+	void unlink();
+	void write(const unsigned char* data);
+	void route();
+	void remoteCommands();
+	void applyPending();
+	void sendStats();
+};
+
+#endif
@@ -18,9 +18,11 @@
 
 #include "M17Utils.h"
 #include "M17Defines.h"
+#include "M17LSF.h"
 
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 
 const std::string M17_CHARS = " ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-/.";
 
@@ -68,7 +70,17 @@ std::string CM17Utils::decodeCallsign(const unsigned char* encoded)
 {
 	assert(encoded != nullptr);
 
-	std::string callsign;
+	char callsign[M17_CALLSIGN_LENGTH + 2U];
+	decodeCallsign(encoded, callsign);
+
+	return std::string(callsign);
+}
+
+// The callsign buffer must hold at least M17_CALLSIGN_LENGTH + 2 characters, a "#" prefix adds one to the length
+void CM17Utils::decodeCallsign(const unsigned char* encoded, char* callsign)
+{
+	assert(encoded != nullptr);
+	assert(callsign != nullptr);
 
 	uint64_t enc = (uint64_t(encoded[0U]) << 40) +
 		           (uint64_t(encoded[1U]) << 32) +
@@ -77,21 +89,48 @@ std::string CM17Utils::decodeCallsign(const unsigned char* encoded)
 		           (uint64_t(encoded[4U]) << 8)  +
 		           (uint64_t(encoded[5U]) << 0);
 
-	if (enc == 281474976710655ULL)
-		return "ALL      ";
+	if (enc == 281474976710655ULL) {
+		::strcpy(callsign, "ALL      ");
+		return;
+	}
 
-	if (enc >= 268697600000000ULL)
-		return "Invalid";
+	if (enc >= 268697600000000ULL) {
+		::strcpy(callsign, "Invalid");
+		return;
+	}
+
+	unsigned int n = 0U;
 
 	if (enc >= 262144000000000ULL) {
-		callsign = "#";
+		callsign[n++] = '#';
 		enc -= 262144000000000ULL;
 	}
 
-	while (enc > 0ULL) {
-		callsign += " ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-/."[enc % 40ULL];
+	while (enc > 0ULL && n < (M17_CALLSIGN_LENGTH + 1U)) {
+		callsign[n++] = " ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-/."[enc % 40ULL];
 		enc /= 40ULL;
 	}
 
-	return callsign;
+	callsign[n] = '\0';
+}
+
+void CM17Utils::injectCallsigns(unsigned char* data, const unsigned char* reflector)
+{
+	assert(data != nullptr);
+
+	CM17LSF lsf;
+	lsf.setNetwork(data + 6U);
+
+	// Change the type to show that it's callsign data
+	lsf.setEncryptionType(M17_ENCRYPTION_TYPE_NONE);
+	lsf.setEncryptionSubType(M17_ENCRYPTION_SUB_TYPE_CALLSIGNS);
+
+	unsigned char meta[M17_META_LENGTH_BYTES];
+	::memset(meta, 0x00U, M17_META_LENGTH_BYTES);
+	::memcpy(meta + 0U, data + 12U, 6U);
+	if (reflector != nullptr)
+		::memcpy(meta + 6U, reflector, 6U);
+	lsf.setMeta(meta);
+
+	lsf.getNetwork(data + 6U);
 }
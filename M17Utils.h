@@ -28,6 +28,11 @@ public:
 
 	static void encodeCallsign(const std::string& callsign, unsigned char* encoded);
 	static std::string decodeCallsign(const unsigned char* encoded);
+	static void decodeCallsign(const unsigned char* encoded, char* callsign);
+
+	// Marks the LSF of a network frame as carrying callsigns, and puts the encoded source
+	// and, unless it is nullptr, the encoded reflector into its META field
+	static void injectCallsigns(unsigned char* data, const unsigned char* reflector);
 
 private:
 };
@@ -0,0 +1,62 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "ManualClock.h"
+
+#include <cassert>
+
+CManualClock::CManualClock(unsigned long long start) :
+m_now(start),
+m_driver(),
+m_real()
+{
+}
+
+CManualClock::~CManualClock()
+{
+}
+
+unsigned long long CManualClock::nanoseconds() const
+{
+	return m_now.load();
+}
+
+void CManualClock::sleep(unsigned int ms)
+{
+	if (std::this_thread::get_id() == m_driver)
+		advance(ms * 1000000ULL);
+	else
+		m_real.sleep(ms);
+}
+
+void CManualClock::set(unsigned long long ns)
+{
+	assert(ns >= m_now.load());
+
+	m_now.store(ns);
+}
+
+void CManualClock::advance(unsigned long long ns)
+{
+	m_now.fetch_add(ns);
+}
+
+void CManualClock::setDriver()
+{
+	m_driver = std::this_thread::get_id();
+}
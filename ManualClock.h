@@ -0,0 +1,57 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(ManualClock_H)
+#define	ManualClock_H
+
+#include "MonotonicClock.h"
+#include "Clock.h"
+
+#include <atomic>
+#include <thread>
+
+// A clock that only moves when it is told to, for running the gateway in
+// virtual time. It may be read from any thread. A sleep by the thread that
+// drives the clock moves it on at once, so that a loop which sleeps between
+// passes, such as the main loop, runs as fast as it can while the hang timer,
+// relinks and reloads happen at the right virtual times. The other threads
+// sleep for real, so that the background threads don't spin.
+class CManualClock : public CClock {
+public:
+	CManualClock(unsigned long long start = 0ULL);
+	virtual ~CManualClock();
+
+	virtual unsigned long long nanoseconds() const;
+
+	virtual void sleep(unsigned int ms);
+
+	// Never earlier than the current time
+	void set(unsigned long long ns);
+
+	void advance(unsigned long long ns);
+
+	// Only before the other threads are started, there is no driver until then
+	void setDriver();
+
+private:
+	std::atomic<unsigned long long> m_now;
+	std::thread::id                 m_driver;
+	CMonotonicClock                 m_real;
+};
+
+#endif
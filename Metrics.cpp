@@ -0,0 +1,291 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "Metrics.h"
+#include "StopWatch.h"
+
+#include <cassert>
+#include <cstdio>
+#include <mutex>
+
+struct CMetricFamily {
+	std::string            m_name;
+	std::string            m_help;
+	METRIC_TYPE            m_type;
+	std::vector<CMetric*>  m_metrics;
+};
+
+static const char* TYPES[] = { "counter", "gauge", "histogram" };
+
+// Only the registration and the export take the lock, never the updates
+static std::mutex& registryMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+// Never destroyed, the metrics are referenced for as long as the process runs
+static std::vector<CMetricFamily*>& registry()
+{
+	static std::vector<CMetricFamily*>* families = new std::vector<CMetricFamily*>;
+	return *families;
+}
+
+static CMetric* find(const std::string& name, const std::string& help, METRIC_TYPE type, const std::string& labels, CMetricFamily*& family)
+{
+	std::vector<CMetricFamily*>& families = registry();
+
+	family = nullptr;
+	for (std::vector<CMetricFamily*>::const_iterator it = families.cbegin(); it != families.cend(); ++it) {
+		if ((*it)->m_name == name) {
+			family = *it;
+			break;
+		}
+	}
+
+	if (family == nullptr) {
+		family = new CMetricFamily;
+		family->m_name = name;
+		family->m_help = help;
+		family->m_type = type;
+		families.push_back(family);
+		return nullptr;
+	}
+
+	assert(family->m_type == type);
+
+	for (std::vector<CMetric*>::const_iterator it = family->m_metrics.cbegin(); it != family->m_metrics.cend(); ++it) {
+		if ((*it)->m_labels == labels)
+			return *it;
+	}
+
+	return nullptr;
+}
+
+static void formatValue(std::string& out, const std::string& name, const char* suffix, const std::string& labels, const char* extra, const char* value)
+{
+	out += name;
+	out += suffix;
+
+	if (!labels.empty() || extra != nullptr) {
+		out += '{';
+		out += labels;
+		if (extra != nullptr) {
+			if (!labels.empty())
+				out += ',';
+			out += extra;
+		}
+		out += '}';
+	}
+
+	out += ' ';
+	out += value;
+	out += '\n';
+}
+
+CMetric::CMetric(const std::string& labels) :
+m_labels(labels)
+{
+}
+
+CMetric::~CMetric()
+{
+}
+
+CMetricCounter::CMetricCounter(const std::string& labels) :
+CMetric(labels),
+m_value(0ULL)
+{
+}
+
+void CMetricCounter::format(std::string& out, const std::string& name) const
+{
+	char value[30U];
+	::sprintf(value, "%llu", get());
+
+	formatValue(out, name, "", m_labels, nullptr, value);
+}
+
+CMetricGauge::CMetricGauge(const std::string& labels) :
+CMetric(labels),
+m_value(0LL)
+{
+}
+
+void CMetricGauge::format(std::string& out, const std::string& name) const
+{
+	char value[30U];
+	::sprintf(value, "%lld", get());
+
+	formatValue(out, name, "", m_labels, nullptr, value);
+}
+
+CMetricHistogram::CMetricHistogram(const std::string& labels, const unsigned long long* bounds, unsigned int count, double scale) :
+CMetric(labels),
+m_bounds(nullptr),
+m_count(count),
+m_scale(scale),
+m_buckets(nullptr),
+m_sum(0ULL),
+m_total(0ULL)
+{
+	assert(bounds != nullptr);
+	assert(count > 0U);
+
+	m_bounds  = new unsigned long long[count];
+	m_buckets = new std::atomic<unsigned long long>[count];
+
+	for (unsigned int i = 0U; i < count; i++) {
+		m_bounds[i] = bounds[i];
+		m_buckets[i].store(0ULL);
+	}
+}
+
+CMetricHistogram::~CMetricHistogram()
+{
+	delete[] m_bounds;
+	delete[] m_buckets;
+}
+
+void CMetricHistogram::observe(unsigned long long value)
+{
+	// Each bucket only counts its own values, they are made cumulative when exported
+	for (unsigned int i = 0U; i < m_count; i++) {
+		if (value <= m_bounds[i]) {
+			m_buckets[i].fetch_add(1ULL, std::memory_order_relaxed);
+			break;
+		}
+	}
+
+	m_sum.fetch_add(value, std::memory_order_relaxed);
+	m_total.fetch_add(1ULL, std::memory_order_relaxed);
+}
+
+void CMetricHistogram::format(std::string& out, const std::string& name) const
+{
+	char value[30U];
+	char le[50U];
+
+	unsigned long long total = 0ULL;
+	for (unsigned int i = 0U; i < m_count; i++) {
+		total += m_buckets[i].load(std::memory_order_relaxed);
+
+		::sprintf(le, "le=\"%g\"", double(m_bounds[i]) * m_scale);
+		::sprintf(value, "%llu", total);
+		formatValue(out, name, "_bucket", m_labels, le, value);
+	}
+
+	// Read last so that the +Inf bucket is never below the others
+	unsigned long long count = m_total.load(std::memory_order_relaxed);
+	if (count < total)
+		count = total;
+
+	::sprintf(value, "%llu", count);
+	formatValue(out, name, "_bucket", m_labels, "le=\"+Inf\"", value);
+
+	::sprintf(value, "%g", double(m_sum.load(std::memory_order_relaxed)) * m_scale);
+	formatValue(out, name, "_sum", m_labels, nullptr, value);
+
+	::sprintf(value, "%llu", count);
+	formatValue(out, name, "_count", m_labels, nullptr, value);
+}
+
+CMetricCounter& CMetrics::counter(const std::string& name, const std::string& help, const std::string& labels)
+{
+	std::lock_guard<std::mutex> lock(registryMutex());
+
+	CMetricFamily* family = nullptr;
+	CMetric* metric = find(name, help, METRIC_TYPE::COUNTER, labels, family);
+	if (metric == nullptr) {
+		metric = new CMetricCounter(labels);
+		family->m_metrics.push_back(metric);
+	}
+
+	return *static_cast<CMetricCounter*>(metric);
+}
+
+CMetricGauge& CMetrics::gauge(const std::string& name, const std::string& help, const std::string& labels)
+{
+	std::lock_guard<std::mutex> lock(registryMutex());
+
+	CMetricFamily* family = nullptr;
+	CMetric* metric = find(name, help, METRIC_TYPE::GAUGE, labels, family);
+	if (metric == nullptr) {
+		metric = new CMetricGauge(labels);
+		family->m_metrics.push_back(metric);
+	}
+
+	return *static_cast<CMetricGauge*>(metric);
+}
+
+CMetricHistogram& CMetrics::histogram(const std::string& name, const std::string& help, const unsigned long long* bounds, unsigned int count, double scale, const std::string& labels)
+{
+	std::lock_guard<std::mutex> lock(registryMutex());
+
+	CMetricFamily* family = nullptr;
+	CMetric* metric = find(name, help, METRIC_TYPE::HISTOGRAM, labels, family);
+	if (metric == nullptr) {
+		metric = new CMetricHistogram(labels, bounds, count, scale);
+		family->m_metrics.push_back(metric);
+	}
+
+	return *static_cast<CMetricHistogram*>(metric);
+}
+
+void CMetrics::format(std::string& out)
+{
+	std::lock_guard<std::mutex> lock(registryMutex());
+
+	std::vector<CMetricFamily*>& families = registry();
+	for (std::vector<CMetricFamily*>::const_iterator it = families.cbegin(); it != families.cend(); ++it) {
+		const CMetricFamily* family = *it;
+
+		out += "# HELP " + family->m_name + " " + family->m_help + "\n";
+		out += "# TYPE " + family->m_name + " " + TYPES[int(family->m_type)] + "\n";
+
+		for (std::vector<CMetric*>::const_iterator it2 = family->m_metrics.cbegin(); it2 != family->m_metrics.cend(); ++it2)
+			(*it2)->format(out, family->m_name);
+	}
+}
+
+std::string CMetrics::join(const std::string& labels1, const std::string& labels2)
+{
+	if (labels1.empty())
+		return labels2;
+	if (labels2.empty())
+		return labels1;
+
+	return labels1 + "," + labels2;
+}
+
+std::string CMetrics::labelsFor(const std::string& repeater)
+{
+	return repeater.empty() ? std::string() : "repeater=\"" + repeater + "\"";
+}
+
+std::string CMetrics::histogramName(const std::string& repeater, const char* text)
+{
+	assert(text != nullptr);
+
+	return repeater.empty() ? std::string(text) : repeater + " " + text;
+}
+
+unsigned long long CMetrics::now()
+{
+	return CStopWatch::nanoseconds() / 1000ULL;
+}
@@ -0,0 +1,130 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	Metrics_H
+#define	Metrics_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+enum class METRIC_TYPE {
+	COUNTER,
+	GAUGE,
+	HISTOGRAM
+};
+
+class CMetric {
+public:
+	CMetric(const std::string& labels);
+	virtual ~CMetric();
+
+	virtual void format(std::string& out, const std::string& name) const = 0;
+
+	std::string m_labels;
+};
+
+// The updates are relaxed atomics and never block, they may be made from any thread
+class CMetricCounter : public CMetric {
+public:
+	CMetricCounter(const std::string& labels);
+
+	void inc(unsigned long long n = 1ULL)
+	{
+		m_value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	unsigned long long get() const
+	{
+		return m_value.load(std::memory_order_relaxed);
+	}
+
+	virtual void format(std::string& out, const std::string& name) const;
+
+private:
+	std::atomic<unsigned long long> m_value;
+};
+
+class CMetricGauge : public CMetric {
+public:
+	CMetricGauge(const std::string& labels);
+
+	void set(long long value)
+	{
+		m_value.store(value, std::memory_order_relaxed);
+	}
+
+	void add(long long n)
+	{
+		m_value.fetch_add(n, std::memory_order_relaxed);
+	}
+
+	long long get() const
+	{
+		return m_value.load(std::memory_order_relaxed);
+	}
+
+	virtual void format(std::string& out, const std::string& name) const;
+
+private:
+	std::atomic<long long> m_value;
+};
+
+// The values and the bucket bounds are integers, they are multiplied by the scale when exported
+class CMetricHistogram : public CMetric {
+public:
+	CMetricHistogram(const std::string& labels, const unsigned long long* bounds, unsigned int count, double scale);
+	virtual ~CMetricHistogram();
+
+	void observe(unsigned long long value);
+
+	virtual void format(std::string& out, const std::string& name) const;
+
+private:
+	unsigned long long*              m_bounds;
+	unsigned int                     m_count;
+	double                           m_scale;
+	std::atomic<unsigned long long>* m_buckets;
+	std::atomic<unsigned long long>  m_sum;
+	std::atomic<unsigned long long>  m_total;
+};
+
+// A process wide registry. Asking for the same name and labels twice returns
+// the same metric, so several instances of a class share their metrics.
+class CMetrics {
+public:
+	static CMetricCounter&   counter(const std::string& name, const std::string& help, const std::string& labels = "");
+	static CMetricGauge&     gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+	static CMetricHistogram& histogram(const std::string& name, const std::string& help, const unsigned long long* bounds, unsigned int count, double scale, const std::string& labels = "");
+
+	// In the Prometheus text exposition format
+	static void format(std::string& out);
+
+	static unsigned long long now();
+
+	// Combines two label lists, either of which may be empty
+	static std::string join(const std::string& labels1, const std::string& labels2);
+
+	// Only the metrics of a named repeater carry a label
+	static std::string labelsFor(const std::string& repeater);
+
+	// The histograms of a named repeater are told apart by the name
+	static std::string histogramName(const std::string& repeater, const char* text);
+};
+
+#endif
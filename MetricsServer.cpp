@@ -0,0 +1,236 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "MetricsServer.h"
+#include "UDPSocket.h"
+#include "Metrics.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cstring>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#if defined(_WIN32) || defined(_WIN64)
+#define	INVALID_FD	INVALID_SOCKET
+#define	closeFD(fd)	::closesocket(fd)
+#define	pollFD		WSAPoll
+#else
+#define	INVALID_FD	-1
+#define	closeFD(fd)	::close(fd)
+#define	pollFD		::poll
+#endif
+
+// A scraper that goes away must not raise SIGPIPE
+#if defined(MSG_NOSIGNAL)
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+const int POLL_TIME = 200;			// ms, how quickly the thread sees a close
+const unsigned int REQUEST_LENGTH = 1024U;
+
+CMetricsServer::CMetricsServer(const std::string& address, unsigned short port, const std::string& socket) :
+CThread(),
+m_address(address),
+m_port(port),
+m_socket(socket),
+m_fd(INVALID_FD),
+m_killed(false)
+{
+}
+
+CMetricsServer::~CMetricsServer()
+{
+}
+
+bool CMetricsServer::open()
+{
+	bool ret = m_socket.empty() ? openTCP() : openUnix();
+	if (!ret)
+		return false;
+
+	return run();
+}
+
+bool CMetricsServer::openTCP()
+{
+	sockaddr_storage addr;
+	unsigned int addrLen;
+	if (CUDPSocket::lookup(m_address, m_port, addr, addrLen) != 0) {
+		LogError("Metrics, the address is invalid - %s", m_address.c_str());
+		return false;
+	}
+
+	m_fd = ::socket(addr.ss_family, SOCK_STREAM, 0);
+	if (m_fd == INVALID_FD) {
+		LogError("Metrics, cannot create the TCP socket");
+		return false;
+	}
+
+	int reuse = 1;
+	::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, (char*)&reuse, sizeof(reuse));
+
+	if (::bind(m_fd, (sockaddr*)&addr, addrLen) == -1 || ::listen(m_fd, 5) == -1) {
+		LogError("Metrics, cannot listen on %s:%hu", m_address.c_str(), m_port);
+		closeFD(m_fd);
+		m_fd = INVALID_FD;
+		return false;
+	}
+
+	LogMessage("Metrics, listening on %s:%hu", m_address.c_str(), m_port);
+
+	return true;
+}
+
+bool CMetricsServer::openUnix()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	LogError("Metrics, Unix sockets are not supported");
+	return false;
+#else
+	sockaddr_un addr;
+	if (m_socket.size() >= sizeof(addr.sun_path)) {
+		LogError("Metrics, the socket path is too long - %s", m_socket.c_str());
+		return false;
+	}
+
+	::memset(&addr, 0x00U, sizeof(sockaddr_un));
+	addr.sun_family = AF_UNIX;
+	::strcpy(addr.sun_path, m_socket.c_str());
+
+	m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_fd == INVALID_FD) {
+		LogError("Metrics, cannot create the Unix socket, err: %d", errno);
+		return false;
+	}
+
+	// A socket left by an earlier run
+	::unlink(m_socket.c_str());
+
+	if (::bind(m_fd, (sockaddr*)&addr, sizeof(sockaddr_un)) == -1 || ::listen(m_fd, 5) == -1) {
+		LogError("Metrics, cannot listen on %s, err: %d", m_socket.c_str(), errno);
+		closeFD(m_fd);
+		m_fd = INVALID_FD;
+		return false;
+	}
+
+	LogMessage("Metrics, listening on %s", m_socket.c_str());
+
+	return true;
+#endif
+}
+
+void CMetricsServer::close()
+{
+	m_killed.store(true);
+
+	wait();
+
+	if (m_fd != INVALID_FD) {
+		closeFD(m_fd);
+		m_fd = INVALID_FD;
+	}
+
+#if !defined(_WIN32) && !defined(_WIN64)
+	if (!m_socket.empty())
+		::unlink(m_socket.c_str());
+#endif
+}
+
+void CMetricsServer::entry()
+{
+	while (!m_killed.load()) {
+		struct pollfd pfd;
+		pfd.fd      = m_fd;
+		pfd.events  = POLLIN;
+		pfd.revents = 0;
+
+		int ret = pollFD(&pfd, 1, POLL_TIME);
+		if (ret <= 0)
+			continue;
+
+#if defined(_WIN32) || defined(_WIN64)
+		SOCKET fd = ::accept(m_fd, nullptr, nullptr);
+#else
+		int fd = ::accept(m_fd, nullptr, nullptr);
+#endif
+		if (fd == INVALID_FD)
+			continue;
+
+		serve(fd);
+
+		closeFD(fd);
+	}
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+void CMetricsServer::serve(SOCKET fd)
+#else
+void CMetricsServer::serve(int fd)
+#endif
+{
+	// Read the request headers, a scraper that stalls is dropped
+	char request[REQUEST_LENGTH + 1U];
+	unsigned int length = 0U;
+	while (length < REQUEST_LENGTH) {
+		struct pollfd pfd;
+		pfd.fd      = fd;
+		pfd.events  = POLLIN;
+		pfd.revents = 0;
+
+		if (pollFD(&pfd, 1, 1000) <= 0)
+			return;
+
+		int n = ::recv(fd, request + length, REQUEST_LENGTH - length, 0);
+		if (n <= 0)
+			return;
+
+		length += n;
+		request[length] = '\0';
+
+		if (::strstr(request, "\r\n\r\n") != nullptr || ::strstr(request, "\n\n") != nullptr)
+			break;
+	}
+
+	std::string body;
+	CMetrics::format(body);
+
+	char header[200U];
+	::sprintf(header, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %u\r\nConnection: close\r\n\r\n", (unsigned int)body.size());
+
+	std::string response = header + body;
+
+	const char* p = response.c_str();
+	size_t left = response.size();
+	while (left > 0U) {
+		int n = ::send(fd, p, (int)left, SEND_FLAGS);
+		if (n <= 0)
+			return;
+
+		p    += n;
+		left -= n;
+	}
+}
@@ -0,0 +1,64 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	MetricsServer_H
+#define	MetricsServer_H
+
+#include "Thread.h"
+
+#include <atomic>
+#include <string>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <ws2tcpip.h>
+#endif
+
+// Serves the metrics registry over HTTP from its own thread, on a TCP port
+// or a Unix stream socket, so a scrape never touches the main loop.
+class CMetricsServer : public CThread {
+public:
+	CMetricsServer(const std::string& address, unsigned short port, const std::string& socket);
+	virtual ~CMetricsServer();
+
+	bool open();
+
+	void close();
+
+	virtual void entry();
+
+private:
+	std::string       m_address;
+	unsigned short    m_port;
+	std::string       m_socket;
+#if defined(_WIN32) || defined(_WIN64)
+	SOCKET            m_fd;
+#else
+	int               m_fd;
+#endif
+	std::atomic<bool> m_killed;
+
+	bool openTCP();
+	bool openUnix();
+#if defined(_WIN32) || defined(_WIN64)
+	void serve(SOCKET fd);
+#else
+	void serve(int fd);
+#endif
+};
+
+#endif
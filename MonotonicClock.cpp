@@ -0,0 +1,71 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "MonotonicClock.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+CMonotonicClock::CMonotonicClock()
+{
+}
+
+CMonotonicClock::~CMonotonicClock()
+{
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+unsigned long long CMonotonicClock::nanoseconds() const
+{
+	LARGE_INTEGER frequency, now;
+	::QueryPerformanceFrequency(&frequency);
+	::QueryPerformanceCounter(&now);
+
+	return (unsigned long long)((now.QuadPart * 1000000000.0) / frequency.QuadPart);
+}
+
+void CMonotonicClock::sleep(unsigned int ms)
+{
+	::Sleep(ms);
+}
+
+#else
+
+unsigned long long CMonotonicClock::nanoseconds() const
+{
+	struct timespec now;
+	::clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void CMonotonicClock::sleep(unsigned int ms)
+{
+	struct timespec ts;
+
+	ts.tv_sec  = ms / 1000U;
+	ts.tv_nsec = (ms % 1000U) * 1000000U;
+
+	::nanosleep(&ts, nullptr);
+}
+
+#endif
@@ -0,0 +1,35 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(MonotonicClock_H)
+#define	MonotonicClock_H
+
+#include "Clock.h"
+
+// The system's monotonic clock, which isn't stepped when the wall clock is
+class CMonotonicClock : public CClock {
+public:
+	CMonotonicClock();
+	virtual ~CMonotonicClock();
+
+	virtual unsigned long long nanoseconds() const;
+
+	virtual void sleep(unsigned int ms);
+};
+
+#endif
@@ -0,0 +1,396 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "PacketCapture.h"
+#include "StopWatch.h"
+#include "Log.h"
+
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+#include <ctime>
+
+const unsigned int QUEUE_LENGTH = 256U;
+
+const uint32_t PCAPNG_SHB = 0x0A0D0D0AU;
+const uint32_t PCAPNG_IDB = 0x00000001U;
+const uint32_t PCAPNG_EPB = 0x00000006U;
+
+const uint16_t LINKTYPE_RAW = 101U;
+
+const uint32_t EPB_FLAGS_INBOUND  = 0x00000001U;
+const uint32_t EPB_FLAGS_OUTBOUND = 0x00000002U;
+
+const unsigned int IPV4_HEADER_LENGTH = 20U;
+const unsigned int IPV6_HEADER_LENGTH = 40U;
+const unsigned int UDP_HEADER_LENGTH  = 8U;
+
+static void put16(unsigned char* p, uint16_t n)
+{
+	::memcpy(p, &n, sizeof(uint16_t));
+}
+
+static void put32(unsigned char* p, uint32_t n)
+{
+	::memcpy(p, &n, sizeof(uint32_t));
+}
+
+static bool exists(const char* filename)
+{
+	FILE* fp = ::fopen(filename, "rb");
+	if (fp == nullptr)
+		return false;
+
+	::fclose(fp);
+	return true;
+}
+
+CPacketCapture::CPacketCapture(const std::string& filePath, const std::string& fileRoot, unsigned int maxSize, unsigned int maxFiles) :
+CThread(),
+m_filePath(filePath),
+m_fileRoot(fileRoot),
+m_maxSize(maxSize * 1000000ULL),
+m_maxFiles(maxFiles),
+m_queue(QUEUE_LENGTH),
+m_killed(false),
+m_dropped(0U),
+m_thread(true),
+m_offset(0ULL),
+m_fp(nullptr),
+m_size(0ULL),
+m_files()
+{
+	assert(!fileRoot.empty());
+}
+
+CPacketCapture::~CPacketCapture()
+{
+}
+
+bool CPacketCapture::open(bool thread)
+{
+	m_thread = thread;
+
+	// Timestamps are monotonic, but are offset to the wall clock at start up
+	m_offset = CStopWatch::realtime() - CStopWatch::nanoseconds();
+
+	bool ret = openFile();
+	if (!ret)
+		return false;
+
+	if (!m_thread)
+		return true;
+
+	return run();
+}
+
+void CPacketCapture::write(CAPTURE_DIRECTION direction, unsigned short localPort, const sockaddr_storage& peer, const unsigned char* data, unsigned int length)
+{
+	assert(data != nullptr);
+
+	if (length > CAPTURE_DATA_LENGTH)
+		length = CAPTURE_DATA_LENGTH;
+
+	CCaptureRecord record;
+	record.m_direction = direction;
+	record.m_localPort = localPort;
+	record.m_peer      = peer;
+	record.m_timestamp = CStopWatch::nanoseconds();
+	record.m_length    = length;
+	::memcpy(record.m_data, data, length);
+
+	if (!m_thread)
+		store(record);
+	else if (!m_queue.push(record))
+		m_dropped++;
+}
+
+void CPacketCapture::close()
+{
+	m_killed.store(true);
+
+	if (m_thread)
+		wait();
+	else
+		closeFile();
+
+	unsigned int dropped = m_dropped.load();
+	if (dropped > 0U)
+		LogWarning("Capture, %u packets were dropped", dropped);
+}
+
+unsigned int CPacketCapture::getDropped() const
+{
+	return m_dropped.load();
+}
+
+void CPacketCapture::entry()
+{
+	unsigned int ticks = 0U;
+
+	while (!m_killed.load()) {
+		bool written = drain();
+
+		// Flush about once a second, the data is already in the stdio buffer
+		if (written || ticks > 0U) {
+			ticks++;
+			if (ticks >= 100U) {
+				if (m_fp != nullptr)
+					::fflush(m_fp);
+				ticks = 0U;
+			}
+		}
+
+		CThread::sleep(10U);
+	}
+
+	drain();
+
+	closeFile();
+}
+
+bool CPacketCapture::drain()
+{
+	bool written = false;
+
+	CCaptureRecord record;
+	while (m_queue.pop(record)) {
+		store(record);
+		written = true;
+	}
+
+	return written;
+}
+
+void CPacketCapture::store(const CCaptureRecord& record)
+{
+	// Once a file can't be opened the capture stops, rather than trying again for every packet
+	if (m_fp == nullptr)
+		return;
+
+	if (m_maxSize > 0ULL && m_size >= m_maxSize) {
+		closeFile();
+
+		if (!openFile()) {
+			LogError("Capture, stopped until the gateway is restarted");
+			return;
+		}
+	}
+
+	writeRecord(record);
+}
+
+bool CPacketCapture::openFile()
+{
+	time_t now;
+	::time(&now);
+
+	// Other threads format times too
+	struct tm tm;
+#if defined(_WIN32) || defined(_WIN64)
+	::gmtime_s(&tm, &now);
+#else
+	::gmtime_r(&now, &tm);
+#endif
+
+	char base[200U];
+#if defined(_WIN32) || defined(_WIN64)
+	::sprintf(base, "%s\\%s-%04d-%02d-%02d-%02d%02d%02d", m_filePath.c_str(), m_fileRoot.c_str(), tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+#else
+	::sprintf(base, "%s/%s-%04d-%02d-%02d-%02d%02d%02d", m_filePath.c_str(), m_fileRoot.c_str(), tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+#endif
+
+	// A second file in the same second, from a rotation or a restart, gets a
+	// sequence number rather than truncating the first. The names still sort
+	// in the order that they were written.
+	char filename[220U];
+	::sprintf(filename, "%s.pcapng", base);
+	for (unsigned int n = 1U; exists(filename); n++)
+		::sprintf(filename, "%s_%02u.pcapng", base, n);
+
+	m_fp = ::fopen(filename, "wb");
+	if (m_fp == nullptr) {
+		LogError("Capture, unable to open %s", filename);
+		return false;
+	}
+
+	::setvbuf(m_fp, nullptr, _IOFBF, 65536U);
+
+	m_files.push_back(filename);
+
+	// Remove the oldest files beyond the limit
+	while (m_maxFiles > 0U && m_files.size() > m_maxFiles) {
+		::remove(m_files.front().c_str());
+		m_files.pop_front();
+	}
+
+	// Section Header Block
+	unsigned char shb[28U];
+	put32(shb + 0U, PCAPNG_SHB);
+	put32(shb + 4U, 28U);
+	put32(shb + 8U, 0x1A2B3C4DU);
+	put16(shb + 12U, 1U);
+	put16(shb + 14U, 0U);
+	put32(shb + 16U, 0xFFFFFFFFU);		// Section length not specified
+	put32(shb + 20U, 0xFFFFFFFFU);
+	put32(shb + 24U, 28U);
+
+	// Interface Description Block with nanosecond timestamps
+	unsigned char idb[32U];
+	put32(idb + 0U, PCAPNG_IDB);
+	put32(idb + 4U, 32U);
+	put16(idb + 8U, LINKTYPE_RAW);
+	put16(idb + 10U, 0U);
+	put32(idb + 12U, 0U);
+	put16(idb + 16U, 9U);			// if_tsresol
+	put16(idb + 18U, 1U);
+	idb[20U] = 9U;
+	idb[21U] = idb[22U] = idb[23U] = 0x00U;
+	put32(idb + 24U, 0U);			// opt_endofopt
+	put32(idb + 28U, 32U);
+
+	::fwrite(shb, 1U, sizeof(shb), m_fp);
+	::fwrite(idb, 1U, sizeof(idb), m_fp);
+
+	m_size = sizeof(shb) + sizeof(idb);
+
+	LogMessage("Capture, writing to %s", filename);
+
+	return true;
+}
+
+void CPacketCapture::closeFile()
+{
+	if (m_fp != nullptr) {
+		::fclose(m_fp);
+		m_fp = nullptr;
+	}
+}
+
+void CPacketCapture::writeRecord(const CCaptureRecord& record)
+{
+	// The local end is shown as the loopback address
+	unsigned char packet[IPV6_HEADER_LENGTH + UDP_HEADER_LENGTH + CAPTURE_DATA_LENGTH];
+	::memset(packet, 0x00U, IPV6_HEADER_LENGTH + UDP_HEADER_LENGTH);
+
+	uint16_t localPort = htons(record.m_localPort);
+	uint16_t peerPort  = 0U;
+	uint16_t udpLength = htons(uint16_t(UDP_HEADER_LENGTH + record.m_length));
+
+	unsigned int headerLength = 0U;
+
+	if (record.m_peer.ss_family == AF_INET6) {
+		const sockaddr_in6* peer = (const sockaddr_in6*)&record.m_peer;
+		peerPort = peer->sin6_port;
+
+		unsigned char local[16U];
+		::memset(local, 0x00U, 16U);
+		local[15U] = 0x01U;
+
+		packet[0U] = 0x60U;
+		::memcpy(packet + 4U, &udpLength, 2U);
+		packet[6U] = 17U;			// UDP
+		packet[7U] = 64U;
+
+		if (record.m_direction == CAPTURE_DIRECTION::INBOUND) {
+			::memcpy(packet + 8U, &peer->sin6_addr, 16U);
+			::memcpy(packet + 24U, local, 16U);
+		} else {
+			::memcpy(packet + 8U, local, 16U);
+			::memcpy(packet + 24U, &peer->sin6_addr, 16U);
+		}
+
+		headerLength = IPV6_HEADER_LENGTH;
+	} else {
+		const sockaddr_in* peer = (const sockaddr_in*)&record.m_peer;
+		peerPort = peer->sin_port;
+
+		uint32_t local = htonl(INADDR_LOOPBACK);
+		uint16_t totalLength = htons(uint16_t(IPV4_HEADER_LENGTH + UDP_HEADER_LENGTH + record.m_length));
+
+		packet[0U] = 0x45U;
+		::memcpy(packet + 2U, &totalLength, 2U);
+		packet[8U] = 64U;
+		packet[9U] = 17U;			// UDP
+
+		if (record.m_direction == CAPTURE_DIRECTION::INBOUND) {
+			::memcpy(packet + 12U, &peer->sin_addr, 4U);
+			::memcpy(packet + 16U, &local, 4U);
+		} else {
+			::memcpy(packet + 12U, &local, 4U);
+			::memcpy(packet + 16U, &peer->sin_addr, 4U);
+		}
+
+		uint32_t sum = 0U;
+		for (unsigned int i = 0U; i < IPV4_HEADER_LENGTH; i += 2U)
+			sum += (packet[i] << 8) | packet[i + 1U];
+		while ((sum >> 16) != 0U)
+			sum = (sum & 0xFFFFU) + (sum >> 16);
+		sum = ~sum;
+		packet[10U] = (sum >> 8) & 0xFFU;
+		packet[11U] = (sum >> 0) & 0xFFU;
+
+		headerLength = IPV4_HEADER_LENGTH;
+	}
+
+	// The UDP checksum is left as zero
+	unsigned char* udp = packet + headerLength;
+	if (record.m_direction == CAPTURE_DIRECTION::INBOUND) {
+		::memcpy(udp + 0U, &peerPort, 2U);
+		::memcpy(udp + 2U, &localPort, 2U);
+	} else {
+		::memcpy(udp + 0U, &localPort, 2U);
+		::memcpy(udp + 2U, &peerPort, 2U);
+	}
+	::memcpy(udp + 4U, &udpLength, 2U);
+
+	::memcpy(udp + UDP_HEADER_LENGTH, record.m_data, record.m_length);
+
+	unsigned int packetLength = headerLength + UDP_HEADER_LENGTH + record.m_length;
+	unsigned int paddedLength = (packetLength + 3U) & ~3U;
+
+	// Enhanced Packet Block with the epb_flags option
+	unsigned int blockLength = 28U + paddedLength + 8U + 4U + 4U;
+
+	unsigned long long timestamp = record.m_timestamp + m_offset;
+
+	unsigned char header[28U];
+	put32(header + 0U, PCAPNG_EPB);
+	put32(header + 4U, blockLength);
+	put32(header + 8U, 0U);
+	put32(header + 12U, uint32_t(timestamp >> 32));
+	put32(header + 16U, uint32_t(timestamp >> 0));
+	put32(header + 20U, packetLength);
+	put32(header + 24U, packetLength);
+
+	unsigned char trailer[3U + 16U];
+	::memset(trailer, 0x00U, sizeof(trailer));
+
+	unsigned char* options = trailer + (paddedLength - packetLength);
+	put16(options + 0U, 2U);		// epb_flags
+	put16(options + 2U, 4U);
+	put32(options + 4U, (record.m_direction == CAPTURE_DIRECTION::INBOUND) ? EPB_FLAGS_INBOUND : EPB_FLAGS_OUTBOUND);
+	put32(options + 8U, 0U);		// opt_endofopt
+	put32(options + 12U, blockLength);
+
+	::fwrite(header, 1U, sizeof(header), m_fp);
+	::fwrite(packet, 1U, packetLength, m_fp);
+	::fwrite(trailer, 1U, (paddedLength - packetLength) + 16U, m_fp);
+
+	m_size += blockLength;
+}
@@ -0,0 +1,88 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	PacketCapture_H
+#define	PacketCapture_H
+
+#include "LockFreeQueue.h"
+#include "UDPSocket.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <deque>
+
+enum class CAPTURE_DIRECTION {
+	INBOUND,
+	OUTBOUND
+};
+
+const unsigned int CAPTURE_DATA_LENGTH = 200U;
+
+struct CCaptureRecord {
+	CAPTURE_DIRECTION  m_direction;
+	unsigned short     m_localPort;
+	sockaddr_storage   m_peer;
+	unsigned long long m_timestamp;
+	unsigned int       m_length;
+	unsigned char      m_data[CAPTURE_DATA_LENGTH];
+};
+
+// Writes the raw datagrams to a pcapng file from a background thread. Each
+// packet is wrapped in a synthesised IP and UDP header carrying the peer
+// address and the local port, and its direction is held in the packet flags.
+class CPacketCapture : public CThread {
+public:
+	CPacketCapture(const std::string& filePath, const std::string& fileRoot, unsigned int maxSize, unsigned int maxFiles);
+	virtual ~CPacketCapture();
+
+	// Without a thread the records are written by the caller, which is only
+	// for tools that can afford the file I/O, such as the replay
+	bool open(bool thread = true);
+
+	void write(CAPTURE_DIRECTION direction, unsigned short localPort, const sockaddr_storage& peer, const unsigned char* data, unsigned int length);
+
+	void close();
+
+	unsigned int getDropped() const;
+
+	virtual void entry();
+
+private:
+	std::string                    m_filePath;
+	std::string                    m_fileRoot;
+	unsigned long long             m_maxSize;
+	unsigned int                   m_maxFiles;
+	CLockFreeQueue<CCaptureRecord> m_queue;
+	std::atomic<bool>              m_killed;
+	std::atomic<unsigned int>      m_dropped;
+	bool                           m_thread;
+	unsigned long long             m_offset;
+	FILE*                          m_fp;
+	unsigned long long             m_size;
+	std::deque<std::string>        m_files;
+
+	bool openFile();
+	void closeFile();
+	bool drain();
+	void store(const CCaptureRecord& record);
+	void writeRecord(const CCaptureRecord& record);
+};
+
+#endif
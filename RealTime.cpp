@@ -0,0 +1,148 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "RealTime.h"
+#include "Log.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <Windows.h>
+#else
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Touched once so that the deepest calls on the forwarding path don't fault in new stack pages
+const unsigned int STACK_PREFAULT = 256U * 1024U;
+
+CRealTime::CRealTime(const std::string& policy, unsigned int priority, int cpu, bool prefault) :
+m_policy(policy),
+m_priority(priority),
+m_cpu(cpu),
+m_prefault(prefault)
+{
+}
+
+CRealTime::~CRealTime()
+{
+}
+
+void CRealTime::apply(const std::string& name, bool affinity) const
+{
+#if defined(_WIN32) || defined(_WIN64)
+	if (!::SetThreadPriority(::GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+		LogWarning("%s, unable to raise the priority", name.c_str());
+#else
+	int policy = (m_policy == "RR") ? SCHED_RR : SCHED_FIFO;
+
+	sched_param param;
+	param.sched_priority = int(m_priority);
+
+	int err = ::pthread_setschedparam(::pthread_self(), policy, &param);
+	if (err != 0)
+		LogWarning("%s, unable to use SCHED_%s at priority %u, err: %d", name.c_str(), m_policy.c_str(), m_priority, err);
+	else
+		LogMessage("%s, running SCHED_%s at priority %u", name.c_str(), m_policy.c_str(), m_priority);
+#endif
+
+	if (affinity && m_cpu >= 0 && setAffinity(name, m_cpu))
+		LogMessage("%s, running on CPU %d", name.c_str(), m_cpu);
+
+	if (m_prefault)
+		prefaultStack();
+}
+
+bool CRealTime::setAffinity(const std::string& name, int cpu)
+{
+	if (cpu < 0)
+		return false;
+
+#if defined(_WIN32) || defined(_WIN64)
+	if (::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR(1) << cpu) == 0) {
+		LogWarning("%s, unable to pin to CPU %d", name.c_str(), cpu);
+		return false;
+	}
+
+	return true;
+#elif defined(__linux__)
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+
+	int err = ::pthread_setaffinity_np(::pthread_self(), sizeof(cpu_set_t), &cpus);
+	if (err != 0) {
+		LogWarning("%s, unable to pin to CPU %d, err: %d", name.c_str(), cpu, err);
+		return false;
+	}
+
+	return true;
+#else
+	LogWarning("%s, pinning to a CPU is not supported", name.c_str());
+	return false;
+#endif
+}
+
+bool CRealTime::lockMemory()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	LogWarning("Locking the memory is not supported");
+	return false;
+#else
+	if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+		LogWarning("Unable to lock the memory, err: %d", errno);
+		return false;
+	}
+
+	LogMessage("The memory is locked");
+
+	return true;
+#endif
+}
+
+bool CRealTime::getPageFaults(unsigned long long& major, unsigned long long& minor)
+{
+#if defined(_WIN32) || defined(_WIN64)
+	major = minor = 0ULL;
+	return false;
+#else
+	struct rusage usage;
+	if (::getrusage(RUSAGE_SELF, &usage) != 0) {
+		major = minor = 0ULL;
+		return false;
+	}
+
+	major = (unsigned long long)usage.ru_majflt;
+	minor = (unsigned long long)usage.ru_minflt;
+
+	return true;
+#endif
+}
+
+void CRealTime::prefaultStack() const
+{
+	volatile unsigned char stack[STACK_PREFAULT];
+	for (unsigned int i = 0U; i < STACK_PREFAULT; i += 1024U)
+		stack[i] = 0x00U;
+
+	// Read back, so the writes can't be seen as unused
+	(void)stack[0U];
+}
@@ -0,0 +1,52 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(RealTime_H)
+#define	RealTime_H
+
+#include <string>
+
+// The real time settings for the threads on the forwarding path, applied by
+// each of those threads to itself, and the process wide memory locking and
+// page fault counts that go with them.
+class CRealTime {
+public:
+	// The policy is FIFO or RR, a CPU of -1 leaves the thread to run anywhere
+	CRealTime(const std::string& policy, unsigned int priority, int cpu, bool prefault);
+	~CRealTime();
+
+	// From the thread itself, which keeps its own CPU when affinity is false
+	void apply(const std::string& name, bool affinity = true) const;
+
+	static bool setAffinity(const std::string& name, int cpu);
+
+	static bool lockMemory();
+
+	// Since the start of the process, false if they can't be had here
+	static bool getPageFaults(unsigned long long& major, unsigned long long& minor);
+
+private:
+	std::string  m_policy;
+	unsigned int m_priority;
+	int          m_cpu;
+	bool         m_prefault;
+
+	void prefaultStack() const;
+};
+
+#endif
@@ -27,11 +27,23 @@
 #include <cstring>
 #include <cctype>
 
+static bool contains(const std::vector<CM17Reflector>& reflectors, const std::string& name)
+{
+	for (std::vector<CM17Reflector>::const_iterator it = reflectors.cbegin(); it != reflectors.cend(); ++it) {
+		if (name == it->m_name)
+			return true;
+	}
+
+	return false;
+}
+
 CReflectors::CReflectors(const std::string& hostsFile1, const std::string& hostsFile2, unsigned int reloadTime) :
 m_hostsFile1(hostsFile1),
 m_hostsFile2(hostsFile2),
-m_reflectors(),
-m_timer(1000U, reloadTime * 60U)
+m_reflectors(new std::vector<CM17Reflector>),
+m_timer(1000U, reloadTime * 60U),
+m_countMetric(CMetrics::gauge("m17gateway_reflectors", "Reflectors in the hosts files")),
+m_loadsMetric(CMetrics::counter("m17gateway_reflector_loads_total", "Loads of the hosts files"))
 {
 	if (reloadTime > 0U)
 		m_timer.start();
@@ -39,19 +51,24 @@ m_timer(1000U, reloadTime * 60U)
 
 CReflectors::~CReflectors()
 {
-	for (std::vector<CM17Reflector*>::iterator it = m_reflectors.begin(); it != m_reflectors.end(); ++it)
-		delete *it;
+}
 
-	m_reflectors.clear();
+void CReflectors::setHostsFiles(const std::string& hostsFile1, const std::string& hostsFile2, unsigned int reloadTime)
+{
+	m_hostsFile1 = hostsFile1;
+	m_hostsFile2 = hostsFile2;
+
+	m_timer.setTimeout(reloadTime * 60U);
+	if (reloadTime > 0U)
+		m_timer.start();
+	else
+		m_timer.stop();
 }
 
 bool CReflectors::load()
 {
-	// Clear out the old reflector list
-	for (std::vector<CM17Reflector*>::iterator it = m_reflectors.begin(); it != m_reflectors.end(); ++it)
-		delete *it;
-
-	m_reflectors.clear();
+	// Built aside, the old table stays in use until the new one is complete
+	std::vector<CM17Reflector>* reflectors = new std::vector<CM17Reflector>;
 
 	FILE* fp = ::fopen(m_hostsFile1.c_str(), "rt");
 	if (fp != nullptr) {
@@ -75,11 +92,11 @@ bool CReflectors::load()
 				sockaddr_storage addr;
 				unsigned int addrLen;
 				if (CUDPSocket::lookup(host, port, addr, addrLen) == 0) {
-					CM17Reflector* refl = new CM17Reflector;
-					refl->m_name    = name;
-					refl->m_addr    = addr;
-					refl->m_addrLen = addrLen;
-					m_reflectors.push_back(refl);
+					CM17Reflector refl;
+					refl.m_name    = name;
+					refl.m_addr    = addr;
+					refl.m_addrLen = addrLen;
+					reflectors->push_back(refl);
 				} else {
 					LogWarning("Unable to resolve the address of %s", host.c_str());
 				}
@@ -105,18 +122,18 @@ bool CReflectors::load()
 				std::string name = std::string(p1);
 				name.resize(M17_CALLSIGN_LENGTH - 2U, ' ');
 
-				if (find(name) == nullptr) {
+				if (!contains(*reflectors, name)) {
 					std::string host  = std::string(p2);
 					unsigned int port = (unsigned int)::atoi(p3);
 
 					sockaddr_storage addr;
 					unsigned int addrLen;
 					if (CUDPSocket::lookup(host, port, addr, addrLen) == 0) {
-						CM17Reflector* refl = new CM17Reflector;
-						refl->m_name    = name;
-						refl->m_addr    = addr;
-						refl->m_addrLen = addrLen;
-						m_reflectors.push_back(refl);
+						CM17Reflector refl;
+						refl.m_name    = name;
+						refl.m_addr    = addr;
+						refl.m_addrLen = addrLen;
+						reflectors->push_back(refl);
 					} else {
 						LogWarning("Unable to resolve the address of %s", host.c_str());
 					}
@@ -127,26 +144,52 @@ bool CReflectors::load()
 		::fclose(fp);
 	}
 
-	size_t size = m_reflectors.size();
+	size_t size = reflectors->size();
+
+	std::atomic_store(&m_reflectors, std::shared_ptr<const std::vector<CM17Reflector>>(reflectors));
+
 	LogInfo("Loaded %u M17 reflectors", size);
 
+	m_countMetric.set((long long)size);
+	m_loadsMetric.inc();
+
 	if (size == 0U)
 		return false;
 
 	return true;
 }
 
-CM17Reflector* CReflectors::find(const std::string& name)
+bool CReflectors::find(const std::string& name, CM17Reflector& reflector) const
 {
 	std::string nm = name;
 	nm.resize(7U);
 
-	for (std::vector<CM17Reflector*>::iterator it = m_reflectors.begin(); it != m_reflectors.end(); ++it) {
-		if (nm == (*it)->m_name)
-			return *it;
+	std::shared_ptr<const std::vector<CM17Reflector>> reflectors = snapshot();
+
+	for (std::vector<CM17Reflector>::const_iterator it = reflectors->cbegin(); it != reflectors->cend(); ++it) {
+		if (nm == it->m_name) {
+			reflector = *it;
+			return true;
+		}
 	}
 
-	return nullptr;
+	return false;
+}
+
+void CReflectors::search(const std::string& text, std::vector<std::string>& names, unsigned int max) const
+{
+	std::string wanted = text;
+	std::transform(wanted.begin(), wanted.end(), wanted.begin(), ::toupper);
+
+	std::shared_ptr<const std::vector<CM17Reflector>> reflectors = snapshot();
+
+	for (std::vector<CM17Reflector>::const_iterator it = reflectors->cbegin(); it != reflectors->cend() && names.size() < max; ++it) {
+		std::string name = it->m_name;
+		std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+
+		if (name.find(wanted) != std::string::npos)
+			names.push_back(it->m_name);
+	}
 }
 
 void CReflectors::clock(unsigned int ms)
@@ -158,3 +201,8 @@ void CReflectors::clock(unsigned int ms)
 		m_timer.start();
 	}
 }
+
+std::shared_ptr<const std::vector<CM17Reflector>> CReflectors::snapshot() const
+{
+	return std::atomic_load(&m_reflectors);
+}
@@ -20,8 +20,10 @@
 #define	Reflectors_H
 
 #include "UDPSocket.h"
+#include "Metrics.h"
 #include "Timer.h"
 
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -39,22 +41,36 @@ public:
 	unsigned int     m_addrLen;
 };
 
+// The table is loaded by the main loop and published as a new snapshot, so
+// the repeaters can look up reflectors from their own threads without a lock.
+// A snapshot is only freed when the last thread using it has let it go.
 class CReflectors {
 public:
 	CReflectors(const std::string& hostsFile1, const std::string& hostsFile2, unsigned int reloadTime);
 	~CReflectors();
 
+	// Takes effect at the next load
+	void setHostsFiles(const std::string& hostsFile1, const std::string& hostsFile2, unsigned int reloadTime);
+
 	bool load();
 
-	CM17Reflector* find(const std::string& name);
+	// The reflector is copied out, as the table it came from may be replaced at any time
+	bool find(const std::string& name, CM17Reflector& reflector) const;
+
+	// The names containing the text, ignoring case
+	void search(const std::string& text, std::vector<std::string>& names, unsigned int max) const;
 
 	void clock(unsigned int ms);
 
 private:
-	std::string  m_hostsFile1;
-	std::string  m_hostsFile2;
-	std::vector<CM17Reflector*> m_reflectors;
-	CTimer       m_timer;
+	std::string     m_hostsFile1;
+	std::string     m_hostsFile2;
+	std::shared_ptr<const std::vector<CM17Reflector>> m_reflectors;
+	CTimer          m_timer;
+	CMetricGauge&   m_countMetric;
+	CMetricCounter& m_loadsMetric;
+
+	std::shared_ptr<const std::vector<CM17Reflector>> snapshot() const;
 };
 
 #endif
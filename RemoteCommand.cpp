@@ -0,0 +1,231 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "RemoteCommand.h"
+
+#include <cassert>
+#include <cstring>
+
+const uint8_t REPLY_VERSION = 1U;
+
+struct CCommandName {
+	const char*    m_name;
+	REMOTE_COMMAND m_command;
+};
+
+static const CCommandName COMMANDS[] = {
+	{"Reflector", REMOTE_COMMAND::REFLECTOR},
+	{"link",      REMOTE_COMMAND::LINK},
+	{"unlink",    REMOTE_COMMAND::UNLINK},
+	{"status",    REMOTE_COMMAND::STATUS},
+	{"host",      REMOTE_COMMAND::HOST},
+	{"echo",      REMOTE_COMMAND::ECHO},
+	{"stats",     REMOTE_COMMAND::STATS},
+	{"streams",   REMOTE_COMMAND::STREAMS},
+	{"search",    REMOTE_COMMAND::SEARCH},
+	{"metrics",   REMOTE_COMMAND::METRICS},
+	{"latency",   REMOTE_COMMAND::LATENCY}
+};
+
+CRemoteCommand::CRemoteCommand() :
+m_count(0U),
+m_commands(),
+m_names(),
+m_arguments(),
+m_binary(false),
+m_reply()
+{
+}
+
+CRemoteCommand::~CRemoteCommand()
+{
+}
+
+unsigned int CRemoteCommand::parse(const unsigned char* data, unsigned int length)
+{
+	assert(data != nullptr);
+
+	m_count  = 0U;
+	m_binary = false;
+	m_reply.clear();
+
+	const char* p   = (const char*)data;
+	const char* end = p + length;
+
+	if (p < end && *p == '#') {
+		m_binary = true;
+		p++;
+	}
+
+	while (p < end && m_count < REMOTE_MAX_COMMANDS) {
+		// One command, which may contain NULs from a badly formed datagram
+		const char* start = p;
+		while (p < end && *p != ';' && *p != '\n' && *p != '\r' && *p != '\0')
+			p++;
+
+		std::string command(start, p - start);
+
+		// Skip the separators
+		while (p < end && (*p == ';' || *p == '\n' || *p == '\r' || *p == '\0'))
+			p++;
+
+		size_t first = command.find_first_not_of(" \t");
+		if (first == std::string::npos)
+			continue;
+		command.erase(0U, first);
+
+		std::string name;
+		std::string argument;
+
+		size_t space = command.find_first_of(" \t");
+		if (space == std::string::npos) {
+			name = command;
+		} else {
+			name = command.substr(0U, space);
+
+			size_t arg = command.find_first_not_of(" \t", space);
+			if (arg != std::string::npos) {
+				argument = command.substr(arg);
+				argument.erase(argument.find_last_not_of(" \t") + 1U);
+			}
+		}
+
+		REMOTE_COMMAND type = REMOTE_COMMAND::UNKNOWN;
+		for (unsigned int i = 0U; i < (sizeof(COMMANDS) / sizeof(COMMANDS[0U])); i++) {
+			if (name == COMMANDS[i].m_name) {
+				type = COMMANDS[i].m_command;
+				break;
+			}
+		}
+
+		m_commands[m_count]  = type;
+		m_names[m_count]     = name;
+		m_arguments[m_count] = argument;
+		m_count++;
+	}
+
+	if (m_binary) {
+		m_reply = "M17R";
+		put8(m_reply, REPLY_VERSION);
+		put8(m_reply, uint8_t(m_count));
+	}
+
+	return m_count;
+}
+
+unsigned int CRemoteCommand::getCount() const
+{
+	return m_count;
+}
+
+REMOTE_COMMAND CRemoteCommand::getCommand(unsigned int n) const
+{
+	assert(n < m_count);
+
+	return m_commands[n];
+}
+
+const std::string& CRemoteCommand::getName(unsigned int n) const
+{
+	assert(n < m_count);
+
+	return m_names[n];
+}
+
+const std::string& CRemoteCommand::getArgument(unsigned int n) const
+{
+	assert(n < m_count);
+
+	return m_arguments[n];
+}
+
+bool CRemoteCommand::isBinary() const
+{
+	return m_binary;
+}
+
+void CRemoteCommand::reply(unsigned int n, const std::string& text)
+{
+	add(n, true, text.c_str(), (unsigned int)text.size());
+}
+
+void CRemoteCommand::reply(unsigned int n, const unsigned char* data, unsigned int length)
+{
+	assert(data != nullptr || length == 0U);
+
+	add(n, true, (const char*)data, length);
+}
+
+void CRemoteCommand::error(unsigned int n, const std::string& text)
+{
+	if (m_binary)
+		add(n, false, text.c_str(), (unsigned int)text.size());
+	else
+		add(n, false, ("error:" + text).c_str(), (unsigned int)text.size() + 6U);
+}
+
+const std::string& CRemoteCommand::getReply() const
+{
+	return m_reply;
+}
+
+void CRemoteCommand::add(unsigned int n, bool success, const char* data, unsigned int length)
+{
+	assert(n < m_count);
+
+	if (m_binary) {
+		if (length > 0xFFFFU)
+			length = 0xFFFFU;
+
+		put8(m_reply, uint8_t(m_commands[n]));
+		put8(m_reply, success ? 0U : 1U);
+		put16(m_reply, uint16_t(length));
+		m_reply.append(data, length);
+	} else if (length > 0U) {
+		if (!m_reply.empty())
+			m_reply += '\n';
+		m_reply.append(data, length);
+	}
+}
+
+void CRemoteCommand::put8(std::string& out, uint8_t value)
+{
+	out += char(value);
+}
+
+void CRemoteCommand::put16(std::string& out, uint16_t value)
+{
+	out += char(value >> 8);
+	out += char(value >> 0);
+}
+
+void CRemoteCommand::put32(std::string& out, uint32_t value)
+{
+	out += char(value >> 24);
+	out += char(value >> 16);
+	out += char(value >> 8);
+	out += char(value >> 0);
+}
+
+void CRemoteCommand::putText(std::string& out, const std::string& text, unsigned int length)
+{
+	std::string field = text;
+	field.resize(length, ' ');
+
+	out += field;
+}
@@ -0,0 +1,87 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	RemoteCommand_H
+#define	RemoteCommand_H
+
+#include <cstdint>
+#include <string>
+
+enum class REMOTE_COMMAND : uint8_t {
+	UNKNOWN,
+	REFLECTOR,
+	LINK,
+	UNLINK,
+	STATUS,
+	HOST,
+	ECHO,
+	STATS,
+	STREAMS,
+	SEARCH,
+	METRICS,
+	LATENCY
+};
+
+const unsigned int REMOTE_MAX_COMMANDS = 16U;
+
+// A datagram holds one or more commands separated by semicolons or new lines.
+// The text replies are returned one per line, in the order of the commands.
+//
+// If the datagram starts with '#' the replies are binary: "M17R", a version
+// byte and a count byte, then for each command its code, a status byte (0 for
+// success), a 16-bit big endian length and the payload.
+class CRemoteCommand {
+public:
+	CRemoteCommand();
+	~CRemoteCommand();
+
+	// Returns the number of commands found
+	unsigned int parse(const unsigned char* data, unsigned int length);
+
+	unsigned int       getCount() const;
+	REMOTE_COMMAND     getCommand(unsigned int n) const;
+	const std::string& getName(unsigned int n) const;
+	const std::string& getArgument(unsigned int n) const;
+
+	bool isBinary() const;
+
+	// A reply with no text adds nothing in text mode, for the commands that never had one
+	void reply(unsigned int n, const std::string& text);
+	void reply(unsigned int n, const unsigned char* data, unsigned int length);
+	void error(unsigned int n, const std::string& text);
+
+	const std::string& getReply() const;
+
+	// For building the binary payloads
+	static void put8(std::string& out, uint8_t value);
+	static void put16(std::string& out, uint16_t value);
+	static void put32(std::string& out, uint32_t value);
+	static void putText(std::string& out, const std::string& text, unsigned int length);
+
+private:
+	unsigned int   m_count;
+	REMOTE_COMMAND m_commands[REMOTE_MAX_COMMANDS];
+	std::string    m_names[REMOTE_MAX_COMMANDS];
+	std::string    m_arguments[REMOTE_MAX_COMMANDS];
+	bool           m_binary;
+	std::string    m_reply;
+
+	void add(unsigned int n, bool success, const char* data, unsigned int length);
+};
+
+#endif
@@ -19,6 +19,7 @@
 #include "RptNetwork.h"
 #include "M17Defines.h"
 #include "M17Utils.h"
+#include "StopWatch.h"
 #include "Utils.h"
 #include "Log.h"
 
@@ -28,13 +29,20 @@
 
 const unsigned int BUFFER_LENGTH = 200U;
 
-CRptNetwork::CRptNetwork(unsigned short localPort, const std::string& gwyAddress, unsigned short gwyPort, bool debug) :
+CRptNetwork::CRptNetwork(unsigned short localPort, const std::string& gwyAddress, unsigned short gwyPort, bool debug, const std::string& labels) :
 m_socket(localPort),
+m_localPort(localPort),
 m_addr(),
 m_addrLen(0U),
 m_debug(debug),
 m_buffer(1000U, "Rpt Network"),
-m_timer(1000U, 5U)
+m_timer(1000U, 5U),
+m_capture(nullptr),
+m_timestamp(0ULL),
+m_framesRx(CMetrics::counter("m17gateway_frames_received_total", "Stream frames received", CMetrics::join("network=\"repeater\"", labels))),
+m_framesTx(CMetrics::counter("m17gateway_frames_sent_total", "Stream frames sent", CMetrics::join("network=\"repeater\"", labels))),
+m_dropped(CMetrics::counter("m17gateway_frames_dropped_total", "Stream frames dropped because the buffer was full", CMetrics::join("network=\"repeater\"", labels))),
+m_invalid(CMetrics::counter("m17gateway_packets_invalid_total", "Packets from an unknown source or of an unknown type", CMetrics::join("network=\"repeater\"", labels)))
 {
 	if (CUDPSocket::lookup(gwyAddress, gwyPort, m_addr, m_addrLen) != 0) {
 		m_addrLen = 0U;
@@ -75,6 +83,11 @@ bool CRptNetwork::write(const unsigned char* data)
 	if (m_debug)
 		CUtils::dump(1U, "Rpt Network Data Transmitted", data, M17_NETWORK_FRAME_LENGTH);
 
+	if (m_capture != nullptr)
+		m_capture->write(CAPTURE_DIRECTION::OUTBOUND, m_localPort, m_addr, data, M17_NETWORK_FRAME_LENGTH);
+
+	m_framesTx.inc();
+
 	return m_socket.write(data, M17_NETWORK_FRAME_LENGTH, m_addr, m_addrLen);
 }
 
@@ -94,26 +107,53 @@ void CRptNetwork::clock(unsigned int ms)
 	if (length <= 0)
 		return;
 
+	unsigned long long timestamp = CStopWatch::nanoseconds();
+
+	if (m_capture != nullptr)
+		m_capture->write(CAPTURE_DIRECTION::INBOUND, m_localPort, address, buffer, length);
+
 	if (!CUDPSocket::match(m_addr, address)) {
 		LogMessage("Rpt, packet received from an invalid source");
+		m_invalid.inc();
 		return;
 	}
 
 	if (m_debug)
 		CUtils::dump(1U, "Rpt Network Data Received", buffer, length);
 
+	if (length < 4) {
+		CUtils::dump(2U, "Rpt, received a runt packet", buffer, length);
+		m_invalid.inc();
+		return;
+	}
+
 	if (::memcmp(buffer + 0U, "PING", 4U) == 0)
 		return;
 
 	if (::memcmp(buffer + 0U, "M17 ", 4U) != 0) {
 		CUtils::dump(2U, "Rpt, received unknown packet", buffer, length);
+		m_invalid.inc();
+		return;
+	}
+
+	// Everything downstream works on whole frames
+	if (length != int(M17_NETWORK_FRAME_LENGTH)) {
+		CUtils::dump(2U, "Rpt, received a frame of the wrong length", buffer, length);
+		m_invalid.inc();
+		return;
+	}
+
+	m_framesRx.inc();
+
+	// The frames are all the same length, so the records in the buffer are too
+	if (!m_buffer.hasSpace(sizeof(timestamp) + M17_NETWORK_FRAME_LENGTH)) {
+		m_dropped.inc();
 		return;
 	}
 
-	unsigned char c = length;
-	m_buffer.addData(&c, 1U);
+	m_buffer.addData((unsigned char*)&timestamp, sizeof(timestamp));
 
-	m_buffer.addData(buffer, length);
+	m_buffer.addData(buffer, M17_NETWORK_FRAME_LENGTH);
 }
 
 bool CRptNetwork::read(unsigned char* data)
@@ -123,10 +163,9 @@ bool CRptNetwork::read(unsigned char* data)
 	if (m_buffer.isEmpty())
 		return false;
 
-	unsigned char c = 0U;
-	m_buffer.getData(&c, 1U);
+	m_buffer.getData((unsigned char*)&m_timestamp, sizeof(m_timestamp));
 
-	m_buffer.getData(data, c);
+	m_buffer.getData(data, M17_NETWORK_FRAME_LENGTH);
 
 	return true;
 }
@@ -138,6 +177,29 @@ void CRptNetwork::close()
 	LogMessage("Closing Rpt network connection");
 }
 
+void CRptNetwork::setCapture(CPacketCapture* capture)
+{
+	m_capture = capture;
+}
+
+unsigned long long CRptNetwork::getTimestamp() const
+{
+	return m_timestamp;
+}
+
+unsigned long long CRptNetwork::getDropped() const
+{
+	return m_dropped.get();
+}
+
+void CRptNetwork::getStats(unsigned long long& received, unsigned long long& sent, unsigned long long& dropped, unsigned long long& invalid) const
+{
+	received = m_framesRx.get();
+	sent     = m_framesTx.get();
+	dropped  = m_dropped.get();
+	invalid  = m_invalid.get();
+}
+
 void CRptNetwork::sendPing()
 {
 	unsigned char buffer[5U];
@@ -150,5 +212,8 @@ void CRptNetwork::sendPing()
 	if (m_debug)
 		CUtils::dump(1U, "Rpt data transmitted", buffer, 4U);
 
+	if (m_capture != nullptr)
+		m_capture->write(CAPTURE_DIRECTION::OUTBOUND, m_localPort, m_addr, buffer, 4U);
+
 	m_socket.write(buffer, 4U, m_addr, m_addrLen);
 }
@@ -19,8 +19,10 @@
 #ifndef	RptNetwork_H
 #define	RptNetwork_H
 
+#include "PacketCapture.h"
 #include "M17Defines.h"
 #include "RingBuffer.h"
+#include "Metrics.h"
 #include "UDPSocket.h"
 #include "Timer.h"
 
@@ -28,26 +30,43 @@
 
 class CRptNetwork {
 public:
-	CRptNetwork(unsigned short localPort, const std::string& gwyAddress, unsigned short gwyPort, bool debug);
+	CRptNetwork(unsigned short localPort, const std::string& gwyAddress, unsigned short gwyPort, bool debug, const std::string& labels);
 	~CRptNetwork();
 
 	bool open();
 
 	bool write(const unsigned char* data);
 
+	// A whole frame of M17_NETWORK_FRAME_LENGTH bytes
 	bool read(unsigned char* data);
 
 	void close();
 
 	void clock(unsigned int ms);
 
+	void setCapture(CPacketCapture* capture);
+
+	// The time that the last frame read was received, from CStopWatch::nanoseconds()
+	unsigned long long getTimestamp() const;
+
+	unsigned long long getDropped() const;
+
+	void getStats(unsigned long long& received, unsigned long long& sent, unsigned long long& dropped, unsigned long long& invalid) const;
+
 private:
 	CUDPSocket       m_socket;
+	unsigned short   m_localPort;
 	sockaddr_storage m_addr;
 	unsigned int     m_addrLen;
 	bool             m_debug;
 	CRingBuffer<unsigned char> m_buffer;
 	CTimer           m_timer;
+	CPacketCapture*  m_capture;
+	unsigned long long m_timestamp;
+	CMetricCounter&  m_framesRx;
+	CMetricCounter&  m_framesTx;
+	CMetricCounter&  m_dropped;
+	CMetricCounter&  m_invalid;
 
 	void sendPing();
 };
@@ -0,0 +1,95 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef SPSCQueue_H
+#define SPSCQueue_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+
+// A bounded queue of fixed size items between exactly one producer thread and
+// one consumer thread. Each side owns one index and only reads the other, so
+// a push or a pop is a copy and a release store. A full queue makes push()
+// fail rather than wait.
+template<class T> class CSPSCQueue {
+public:
+	CSPSCQueue(unsigned int length) :
+	m_items(nullptr),
+	m_mask(0U),
+	m_head(0U),
+	m_tail(0U)
+	{
+		assert(length > 0U);
+
+		// Round up to a power of two
+		unsigned int size = 2U;
+		while (size < length)
+			size <<= 1;
+
+		m_items = new T[size];
+		m_mask  = size - 1U;
+	}
+
+	~CSPSCQueue()
+	{
+		delete[] m_items;
+	}
+
+	// Only from the producer
+	bool push(const T& item)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if ((head - m_tail.load(std::memory_order_acquire)) > m_mask)
+			return false;
+
+		m_items[head & m_mask] = item;
+		m_head.store(head + 1U, std::memory_order_release);
+
+		return true;
+	}
+
+	// Only from the consumer
+	bool pop(T& item)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail == m_head.load(std::memory_order_acquire))
+			return false;
+
+		item = m_items[tail & m_mask];
+		m_tail.store(tail + 1U, std::memory_order_release);
+
+		return true;
+	}
+
+	bool isEmpty() const
+	{
+		return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+	}
+
+private:
+	T*                  m_items;
+	size_t              m_mask;
+	char                m_pad0[64U];
+	std::atomic<size_t> m_head;
+	char                m_pad1[64U];
+	std::atomic<size_t> m_tail;
+	char                m_pad2[64U];
+};
+
+#endif
@@ -17,17 +17,13 @@
  */
 
 #include "StopWatch.h"
+#include "Clock.h"
 
-#if defined(_WIN32) || defined(_WIN64)
+// The clock is monotonic, so time() isn't stepped along with the wall clock
 
 CStopWatch::CStopWatch() :
-m_frequencyS(),
-m_frequencyMS(),
-m_start()
+m_startMS(0ULL)
 {
-	::QueryPerformanceFrequency(&m_frequencyS);
-
-	m_frequencyMS.QuadPart = m_frequencyS.QuadPart / 1000ULL;
 }
 
 CStopWatch::~CStopWatch()
@@ -36,70 +32,42 @@ CStopWatch::~CStopWatch()
 
 unsigned long long CStopWatch::time() const
 {
-	LARGE_INTEGER now;
-	::QueryPerformanceCounter(&now);
-
-	return (unsigned long long)(now.QuadPart / m_frequencyMS.QuadPart);
+	return CClock::get().nanoseconds() / 1000000ULL;
 }
 
 unsigned long long CStopWatch::start()
 {
-	::QueryPerformanceCounter(&m_start);
+	m_startMS = CClock::get().nanoseconds() / 1000000ULL;
 
-	return (unsigned long long)(m_start.QuadPart / m_frequencyS.QuadPart);
+	return m_startMS;
 }
 
 unsigned int CStopWatch::elapsed()
 {
-	LARGE_INTEGER now;
-	::QueryPerformanceCounter(&now);
+	unsigned long long nowMS = CClock::get().nanoseconds() / 1000000ULL;
 
-	LARGE_INTEGER temp;
-	temp.QuadPart = (now.QuadPart - m_start.QuadPart) * 1000;
-
-	return (unsigned int)(temp.QuadPart / m_frequencyS.QuadPart);
+	return (unsigned int)(nowMS - m_startMS);
 }
 
-#else
-
-#include <cstdio>
-#include <ctime>
-
-CStopWatch::CStopWatch() :
-m_startMS(0ULL)
+unsigned long long CStopWatch::nanoseconds()
 {
+	return CClock::get().nanoseconds();
 }
 
-CStopWatch::~CStopWatch()
+unsigned long long CStopWatch::realtime()
 {
-}
+#if defined(_WIN32) || defined(_WIN64)
+	FILETIME ft;
+	::GetSystemTimeAsFileTime(&ft);
 
-unsigned long long CStopWatch::time() const
-{
+	// 100ns intervals since 1601
+	unsigned long long t = (((unsigned long long)ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+
+	return (t - 116444736000000000ULL) * 100ULL;
+#else
 	struct timeval now;
 	::gettimeofday(&now, nullptr);
 
-	return now.tv_sec * 1000ULL + now.tv_usec / 1000ULL;
-}
-
-unsigned long long CStopWatch::start()
-{
-	struct timespec now;
-	::clock_gettime(CLOCK_MONOTONIC, &now);
-
-	m_startMS = now.tv_sec * 1000ULL + now.tv_nsec / 1000000ULL;
-
-	return m_startMS;
-}
-
-unsigned int CStopWatch::elapsed()
-{
-	struct timespec now;
-	::clock_gettime(CLOCK_MONOTONIC, &now);
-
-	unsigned long long nowMS = now.tv_sec * 1000ULL + now.tv_nsec / 1000000ULL;
-
-	return nowMS - m_startMS;
-}
-
+	return now.tv_sec * 1000000000ULL + now.tv_usec * 1000ULL;
 #endif
+}
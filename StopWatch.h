@@ -26,25 +26,26 @@
 #include <sys/time.h>
 #endif
 
+// Everything is timed by the current CClock, so it follows virtual time when that is in use
 class CStopWatch
 {
 public:
 	CStopWatch();
 	~CStopWatch();
 
+	// Milliseconds from an arbitrary point, not the time of day
 	unsigned long long time() const;
 
 	unsigned long long start();
 	unsigned int       elapsed();
 
+	static unsigned long long nanoseconds();
+
+	// Nanoseconds since the Unix epoch from the time of day clock, for the timestamps written to files
+	static unsigned long long realtime();
+
 private:
-#if defined(_WIN32) || defined(_WIN64)
-	LARGE_INTEGER  m_frequencyS;
-	LARGE_INTEGER  m_frequencyMS;
-	LARGE_INTEGER  m_start;
-#else
 	unsigned long long m_startMS;
-#endif
 };
 
 #endif
@@ -0,0 +1,136 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "StreamTracker.h"
+#include "M17Utils.h"
+
+#include <cassert>
+
+const unsigned int STREAM_TIMEOUT = 1000U;	// Without frames before a stream is ended
+
+CStreamTracker::CStreamTracker(const std::string& repeater, STREAM_DIRECTION direction, CEventLog* events) :
+m_repeater(repeater),
+m_direction(direction),
+m_events(events),
+m_active(false),
+m_id(0U),
+m_source(),
+m_dest(),
+m_fn(0U),
+m_frames(0U),
+m_lost(0U),
+m_duration(0U),
+m_idle(0U)
+{
+}
+
+CStreamTracker::~CStreamTracker()
+{
+}
+
+void CStreamTracker::write(const unsigned char* data)
+{
+	assert(data != nullptr);
+
+	uint16_t id = (data[4U] << 8) + (data[5U] << 0);
+	uint16_t fn = ((data[34U] << 8) + (data[35U] << 0)) & 0x7FFFU;
+
+	if (m_active && id != m_id)
+		end();
+
+	if (!m_active) {
+		CM17Utils::decodeCallsign(data + 12U, m_source);
+		CM17Utils::decodeCallsign(data + 6U, m_dest);
+
+		m_active   = true;
+		m_id       = id;
+		m_frames   = 0U;
+		m_lost     = 0U;
+		m_duration = 0U;
+
+		if (m_events != nullptr)
+			m_events->streamStart(m_repeater.c_str(), m_direction, m_id, m_source, m_dest);
+	} else {
+		// The frame number wraps at 15 bits
+		uint16_t gap = (fn - m_fn - 1U) & 0x7FFFU;
+		if (gap < 0x4000U)
+			m_lost += gap;
+	}
+
+	m_fn   = fn;
+	m_idle = 0U;
+	m_frames++;
+
+	if ((data[34U] & 0x80U) == 0x80U)
+		end();
+}
+
+void CStreamTracker::clock(unsigned int ms)
+{
+	if (!m_active)
+		return;
+
+	m_duration += ms;
+	m_idle     += ms;
+
+	if (m_idle >= STREAM_TIMEOUT)
+		end();
+}
+
+bool CStreamTracker::isActive() const
+{
+	return m_active;
+}
+
+uint16_t CStreamTracker::getId() const
+{
+	return m_id;
+}
+
+const char* CStreamTracker::getSource() const
+{
+	return m_source;
+}
+
+const char* CStreamTracker::getDest() const
+{
+	return m_dest;
+}
+
+unsigned int CStreamTracker::getDuration() const
+{
+	return m_duration;
+}
+
+unsigned int CStreamTracker::getFrames() const
+{
+	return m_frames;
+}
+
+unsigned int CStreamTracker::getLost() const
+{
+	return m_lost;
+}
+
+void CStreamTracker::end()
+{
+	if (m_events != nullptr)
+		m_events->streamEnd(m_repeater.c_str(), m_direction, m_id, m_source, m_dest, m_duration, m_frames, m_lost);
+
+	m_active = false;
+}
@@ -0,0 +1,64 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	StreamTracker_H
+#define	StreamTracker_H
+
+#include "M17Defines.h"
+#include "EventLog.h"
+
+#include <cstdint>
+#include <string>
+
+// Follows the streams in one direction, counting the frames and the gaps in
+// the frame numbers, and reports their start and end if there is an event log.
+class CStreamTracker {
+public:
+	CStreamTracker(const std::string& repeater, STREAM_DIRECTION direction, CEventLog* events);
+	~CStreamTracker();
+
+	void write(const unsigned char* data);
+
+	void clock(unsigned int ms);
+
+	bool         isActive() const;
+	uint16_t     getId() const;
+	const char*  getSource() const;
+	const char*  getDest() const;
+	unsigned int getDuration() const;
+	unsigned int getFrames() const;
+	unsigned int getLost() const;
+
+private:
+	std::string      m_repeater;
+	STREAM_DIRECTION m_direction;
+	CEventLog*       m_events;
+	bool             m_active;
+	uint16_t         m_id;
+	char             m_source[M17_CALLSIGN_LENGTH + 2U];
+	char             m_dest[M17_CALLSIGN_LENGTH + 2U];
+	uint16_t         m_fn;
+	unsigned int     m_frames;
+	unsigned int     m_lost;
+	unsigned int     m_duration;
+	unsigned int     m_idle;
+
+	void end();
+};
+
+#endif
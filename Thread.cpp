@@ -17,6 +17,7 @@
  */
 
 #include "Thread.h"
+#include "Clock.h"
 
 #if defined(_WIN32) || defined(_WIN64)
 
@@ -54,11 +55,6 @@ DWORD CThread::helper(LPVOID arg)
 	return 0UL;
 }
 
-void CThread::sleep(unsigned int ms)
-{
-	::Sleep(ms);
-}
-
 #else
 
 #include <unistd.h>
@@ -93,15 +89,10 @@ void* CThread::helper(void* arg)
 	return nullptr;
 }
 
+#endif
+
 void CThread::sleep(unsigned int ms)
 {
-	struct timespec ts;
-
-	ts.tv_sec  = ms / 1000U;
-	ts.tv_nsec = (ms % 1000U) * 1000000U;
-
-	::nanosleep(&ts, nullptr);
+	CClock::get().sleep(ms);
 }
 
-#endif
-
@@ -37,6 +37,7 @@ public:
 
   virtual void wait();
 
+  // On the current CClock, so a manual clock may move on rather than wait
   static void sleep(unsigned int ms);
 
 private:
@@ -0,0 +1,293 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "CaptureReader.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cstring>
+
+const uint32_t PCAPNG_SHB = 0x0A0D0D0AU;
+const uint32_t PCAPNG_IDB = 0x00000001U;
+const uint32_t PCAPNG_EPB = 0x00000006U;
+
+const uint32_t PCAPNG_MAGIC = 0x1A2B3C4DU;
+
+const uint16_t LINKTYPE_RAW = 101U;
+
+const uint16_t OPTION_END     = 0U;
+const uint16_t OPTION_FLAGS   = 2U;
+const uint16_t OPTION_TSRESOL = 9U;
+
+const uint32_t EPB_FLAGS_INBOUND  = 0x00000001U;
+const uint32_t EPB_FLAGS_OUTBOUND = 0x00000002U;
+
+const unsigned char IP_PROTOCOL_UDP = 17U;
+
+const unsigned int UDP_HEADER_LENGTH = 8U;
+
+static uint16_t swap16(uint16_t n)
+{
+	return uint16_t((n >> 8) | (n << 8));
+}
+
+static uint32_t swap32(uint32_t n)
+{
+	return ((n >> 24) & 0x000000FFU) | ((n >> 8) & 0x0000FF00U) | ((n << 8) & 0x00FF0000U) | ((n << 24) & 0xFF000000U);
+}
+
+CCaptureReader::CCaptureReader() :
+m_file(),
+m_fp(nullptr),
+m_swap(false),
+m_resolution(1000ULL),
+m_block()
+{
+}
+
+CCaptureReader::~CCaptureReader()
+{
+}
+
+bool CCaptureReader::open(const std::string& file)
+{
+	m_file = file;
+
+	m_fp = ::fopen(file.c_str(), "rb");
+	if (m_fp == nullptr) {
+		LogError("Unable to open the capture %s", file.c_str());
+		return false;
+	}
+
+	uint32_t type, length;
+	if (!readBlock(type, length) || type != PCAPNG_SHB) {
+		LogError("%s is not a pcapng file", file.c_str());
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool CCaptureReader::read(CCapturedPacket& packet)
+{
+	if (m_fp == nullptr)
+		return false;
+
+	uint32_t type, length;
+	while (readBlock(type, length)) {
+		switch (type) {
+		case PCAPNG_IDB:
+			if (!readInterface(length))
+				return false;
+			break;
+
+		case PCAPNG_EPB:
+			if (readPacket(length, packet))
+				return true;
+			break;
+
+		default:
+			// Statistics, name resolution and the like
+			break;
+		}
+	}
+
+	return false;
+}
+
+void CCaptureReader::close()
+{
+	if (m_fp != nullptr) {
+		::fclose(m_fp);
+		m_fp = nullptr;
+	}
+}
+
+bool CCaptureReader::readBlock(uint32_t& type, uint32_t& length)
+{
+	if (::fread(m_block, 1U, 8U, m_fp) != 8U)
+		return false;
+
+	type = get32(m_block + 0U);
+
+	// The byte order of each section is set by its header
+	if (type == PCAPNG_SHB) {
+		if (::fread(m_block + 8U, 1U, 4U, m_fp) != 4U)
+			return false;
+
+		uint32_t magic;
+		::memcpy(&magic, m_block + 8U, 4U);
+		if (magic == PCAPNG_MAGIC) {
+			m_swap = false;
+		} else if (magic == swap32(PCAPNG_MAGIC)) {
+			m_swap = true;
+		} else {
+			LogError("%s has an unknown byte order", m_file.c_str());
+			return false;
+		}
+
+		length = get32(m_block + 4U);
+		if (length < 28U || length > sizeof(m_block))
+			return false;
+
+		return ::fread(m_block + 12U, 1U, length - 12U, m_fp) == (length - 12U);
+	}
+
+	length = get32(m_block + 4U);
+	if (length < 12U || (length % 4U) != 0U) {
+		LogError("%s has a corrupt block", m_file.c_str());
+		return false;
+	}
+
+	// Too big to be one of ours
+	if (length > sizeof(m_block)) {
+		type = 0U;
+		return ::fseek(m_fp, long(length - 8U), SEEK_CUR) == 0;
+	}
+
+	return ::fread(m_block + 8U, 1U, length - 8U, m_fp) == (length - 8U);
+}
+
+bool CCaptureReader::readInterface(uint32_t length)
+{
+	if (length < 20U)
+		return false;
+
+	uint16_t linkType = get16(m_block + 8U);
+	if (linkType != LINKTYPE_RAW) {
+		LogError("%s has link type %u, only raw IP is supported", m_file.c_str(), linkType);
+		return false;
+	}
+
+	// Microseconds unless the interface says otherwise
+	m_resolution = 1000ULL;
+
+	unsigned int offset = 16U;
+	while (offset + 4U <= length - 4U) {
+		uint16_t code = get16(m_block + offset + 0U);
+		uint16_t size = get16(m_block + offset + 2U);
+		if (code == OPTION_END)
+			break;
+
+		if (code == OPTION_TSRESOL && size >= 1U) {
+			unsigned char value = m_block[offset + 4U];
+			if ((value & 0x80U) != 0U || value > 9U) {
+				LogError("%s has an unsupported timestamp resolution", m_file.c_str());
+				return false;
+			}
+
+			m_resolution = 1ULL;
+			for (unsigned char i = value; i < 9U; i++)
+				m_resolution *= 10ULL;
+		}
+
+		offset += 4U + ((size + 3U) & ~3U);
+	}
+
+	return true;
+}
+
+bool CCaptureReader::readPacket(uint32_t length, CCapturedPacket& packet)
+{
+	if (length < 32U)
+		return false;
+
+	uint32_t captured = get32(m_block + 20U);
+	if (28U + captured > length - 4U)
+		return false;
+
+	uint32_t flags = 0U;
+
+	unsigned int offset = 28U + ((captured + 3U) & ~3U);
+	while (offset + 4U <= length - 4U) {
+		uint16_t code = get16(m_block + offset + 0U);
+		uint16_t size = get16(m_block + offset + 2U);
+		if (code == OPTION_END)
+			break;
+
+		if (code == OPTION_FLAGS && size >= 4U)
+			flags = get32(m_block + offset + 4U);
+
+		offset += 4U + ((size + 3U) & ~3U);
+	}
+
+	// The direction is what tells the replay what to send and what to expect
+	if ((flags & 0x03U) == EPB_FLAGS_INBOUND)
+		packet.m_direction = CAPTURE_DIRECTION::INBOUND;
+	else if ((flags & 0x03U) == EPB_FLAGS_OUTBOUND)
+		packet.m_direction = CAPTURE_DIRECTION::OUTBOUND;
+	else
+		return false;
+
+	const unsigned char* ip = m_block + 28U;
+
+	unsigned int headerLength = 0U;
+	if ((ip[0U] & 0xF0U) == 0x40U && captured >= 20U) {
+		if (ip[9U] != IP_PROTOCOL_UDP)
+			return false;
+		headerLength = (ip[0U] & 0x0FU) * 4U;
+	} else if ((ip[0U] & 0xF0U) == 0x60U && captured >= 40U) {
+		if (ip[6U] != IP_PROTOCOL_UDP)
+			return false;
+		headerLength = 40U;
+	} else {
+		return false;
+	}
+
+	if (captured < headerLength + UDP_HEADER_LENGTH)
+		return false;
+
+	// The ports are in network order whatever the byte order of the file
+	const unsigned char* udp = ip + headerLength;
+	uint16_t srcPort = (udp[0U] << 8) | udp[1U];
+	uint16_t dstPort = (udp[2U] << 8) | udp[3U];
+
+	packet.m_localPort = (packet.m_direction == CAPTURE_DIRECTION::INBOUND) ? dstPort : srcPort;
+
+	unsigned long long timestamp = (((unsigned long long)get32(m_block + 12U)) << 32) | get32(m_block + 16U);
+	packet.m_timestamp = timestamp * m_resolution;
+
+	packet.m_length = captured - headerLength - UDP_HEADER_LENGTH;
+	if (packet.m_length > CAPTURE_DATA_LENGTH)
+		packet.m_length = CAPTURE_DATA_LENGTH;
+
+	::memcpy(packet.m_data, udp + UDP_HEADER_LENGTH, packet.m_length);
+
+	return true;
+}
+
+uint16_t CCaptureReader::get16(const unsigned char* p) const
+{
+	assert(p != nullptr);
+
+	uint16_t n;
+	::memcpy(&n, p, sizeof(uint16_t));
+
+	return m_swap ? swap16(n) : n;
+}
+
+uint32_t CCaptureReader::get32(const unsigned char* p) const
+{
+	assert(p != nullptr);
+
+	uint32_t n;
+	::memcpy(&n, p, sizeof(uint32_t));
+
+	return m_swap ? swap32(n) : n;
+}
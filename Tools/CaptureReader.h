@@ -0,0 +1,65 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(CaptureReader_H)
+#define	CaptureReader_H
+
+#include "PacketCapture.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+struct CCapturedPacket {
+	unsigned long long m_timestamp;		// ns
+	CAPTURE_DIRECTION  m_direction;
+	unsigned short     m_localPort;
+	unsigned int       m_length;
+	unsigned char      m_data[CAPTURE_DATA_LENGTH];
+};
+
+// Reads back the pcapng files written by CPacketCapture. The local port is
+// taken from the synthesised UDP header and the direction from the packet
+// flags, the peer address isn't needed for a replay.
+class CCaptureReader {
+public:
+	CCaptureReader();
+	~CCaptureReader();
+
+	bool open(const std::string& file);
+
+	// False at the end of the file, or at the first block that can't be read
+	bool read(CCapturedPacket& packet);
+
+	void close();
+
+private:
+	std::string        m_file;
+	FILE*              m_fp;
+	bool               m_swap;
+	unsigned long long m_resolution;
+	unsigned char      m_block[1024U];
+
+	bool readBlock(uint32_t& type, uint32_t& length);
+	bool readInterface(uint32_t length);
+	bool readPacket(uint32_t length, CCapturedPacket& packet);
+	uint16_t get16(const unsigned char* p) const;
+	uint32_t get32(const unsigned char* p) const;
+};
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Stands in for an MMDVM host. It sends M17 voice streams to the gateway at
+// the real rate of one frame every 40 ms per stream, either generated or
+// replayed from a flight recorder file, and counts the frames the gateway
+// sends back. Run with FakeReflector to test the gateway end to end.
+
+#include "SimRepeater.h"
+#include "StopWatch.h"
+#include "UDPSocket.h"
+#include "Log.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// How long to wait between looking at the socket, and so the resolution of the latencies
+const unsigned int POLL_TIME = 100U;		// us
+
+// After a replay, for the last frames from the other side
+const unsigned long long DRAIN_TIME = 1000000000ULL;
+
+static std::atomic<bool> m_killed(false);
+
+static void sigHandler(int signum)
+{
+	m_killed.store(true);
+}
+
+static void usage()
+{
+	::fprintf(stderr, "Usage: FakeMMDVM [options]\n"
+		"  --port <port>          the port to listen on, the gateway's RptPort (17011)\n"
+		"  --address <address>    the address of the gateway (127.0.0.1)\n"
+		"  --gateway <port>       the gateway's LocalPort (17010)\n"
+		"  --streams <n>          the number of streams sent at once (1)\n"
+		"  --frames <n>           the frames in each transmission (250)\n"
+		"  --source <callsign>    the start of the source callsigns (M1RF)\n"
+		"  --dest <callsign>      the destination, a reflector and module links to it (ALL)\n"
+		"  --replay <file>        replay the RF frames of a flight recorder file instead\n"
+		"  --time <seconds>       how long to run, 0 for until stopped (10)\n");
+}
+
+int main(int argc, char** argv)
+{
+	unsigned short port    = 17011U;
+	std::string address    = "127.0.0.1";
+	unsigned short gateway = 17010U;
+	unsigned int streams   = 1U;
+	unsigned int frames    = 250U;
+	std::string source     = "M1RF";
+	std::string dest       = "ALL";
+	std::string replay;
+	unsigned int seconds   = 10U;
+
+	for (int i = 1; i < argc; i += 2) {
+		if (i + 1 >= argc) {
+			usage();
+			return 1;
+		}
+
+		const char* option = argv[i];
+		const char* value  = argv[i + 1];
+
+		if (::strcmp(option, "--port") == 0)
+			port = (unsigned short)::atoi(value);
+		else if (::strcmp(option, "--address") == 0)
+			address = value;
+		else if (::strcmp(option, "--gateway") == 0)
+			gateway = (unsigned short)::atoi(value);
+		else if (::strcmp(option, "--streams") == 0)
+			streams = (unsigned int)::atoi(value);
+		else if (::strcmp(option, "--frames") == 0)
+			frames = (unsigned int)::atoi(value);
+		else if (::strcmp(option, "--source") == 0)
+			source = value;
+		else if (::strcmp(option, "--dest") == 0)
+			dest = value;
+		else if (::strcmp(option, "--replay") == 0)
+			replay = value;
+		else if (::strcmp(option, "--time") == 0)
+			seconds = (unsigned int)::atoi(value);
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (port == 0U || gateway == 0U || frames == 0U) {
+		usage();
+		return 1;
+	}
+
+	// The messages, warnings and errors
+	::LogInitialise(false, "/tmp", "FakeMMDVM", 0U, 2U, false);
+
+	CUDPSocket::startup();
+
+	CSimRepeater repeater(port, address, gateway, streams, frames, source, dest);
+	if (!replay.empty() && !repeater.replay(replay))
+		return 1;
+
+	if (!repeater.open())
+		return 1;
+
+	::signal(SIGINT,  sigHandler);
+	::signal(SIGTERM, sigHandler);
+
+	unsigned long long start = CStopWatch::nanoseconds();
+	unsigned long long stop  = (seconds > 0U) ? start + seconds * 1000000000ULL : ~0ULL;
+	unsigned long long finished = 0ULL;
+
+	repeater.start(start);
+
+	while (!m_killed.load()) {
+		unsigned long long now = CStopWatch::nanoseconds();
+		if (now >= stop)
+			break;
+
+		repeater.clock(now);
+
+		if (repeater.isFinished()) {
+			if (finished == 0ULL)
+				finished = now;
+			else if ((now - finished) >= DRAIN_TIME)
+				break;
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(POLL_TIME));
+	}
+
+	repeater.close();
+
+	repeater.getStats().print(stdout);
+
+	CUDPSocket::shutdown();
+
+	::LogFinalise();
+
+	return 0;
+}
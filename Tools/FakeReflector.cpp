@@ -0,0 +1,182 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Stands in for an M17 reflector, so that a gateway can be tested without a
+// live one. The streams it sends start with the first link to it. Run with
+// FakeMMDVM to test the gateway end to end.
+
+#include "SimReflector.h"
+#include "StopWatch.h"
+#include "UDPSocket.h"
+#include "Log.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+const unsigned int POLL_TIME = 100U;		// us
+
+static std::atomic<bool> m_killed(false);
+
+static void sigHandler(int signum)
+{
+	m_killed.store(true);
+}
+
+static void usage()
+{
+	::fprintf(stderr, "Usage: FakeReflector [options]\n"
+		"  --port <port>          the port to listen on (17000)\n"
+		"  --name <callsign>      the name of the reflector (M17-SIM)\n"
+		"  --nack                 refuse every link\n"
+		"  --streams <n>          the number of streams sent at once to every link (0)\n"
+		"  --frames <n>           the frames in each transmission (250)\n"
+		"  --source <callsign>    the start of the source callsigns (M1NET)\n"
+		"  --replay <file>        replay the network frames of a flight recorder file instead\n"
+		"  --loss <percent>       the frames not sent (0)\n"
+		"  --jitter <ms>          the most that each frame is delayed by (0)\n"
+		"  --reorder <percent>    the frames sent after the two following them (0)\n"
+		"  --duplicate <percent>  the frames sent twice (0)\n"
+		"  --seed <n>             for repeatable impairments\n"
+		"  --time <seconds>       how long to run, 0 for until stopped (0)\n");
+}
+
+int main(int argc, char** argv)
+{
+	unsigned short port  = 17000U;
+	std::string name     = "M17-SIM";
+	bool nack            = false;
+	unsigned int streams = 0U;
+	unsigned int frames  = 250U;
+	std::string source   = "M1NET";
+	std::string replay;
+	double loss          = 0.0;
+	unsigned int jitter  = 0U;
+	double reorder       = 0.0;
+	double duplicate     = 0.0;
+	unsigned int seconds = 0U;
+	bool seeded          = false;
+	unsigned int seed    = 0U;
+
+	for (int i = 1; i < argc; i++) {
+		const char* option = argv[i];
+
+		if (::strcmp(option, "--nack") == 0) {
+			nack = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			usage();
+			return 1;
+		}
+
+		const char* value = argv[++i];
+
+		if (::strcmp(option, "--port") == 0)
+			port = (unsigned short)::atoi(value);
+		else if (::strcmp(option, "--name") == 0)
+			name = value;
+		else if (::strcmp(option, "--streams") == 0)
+			streams = (unsigned int)::atoi(value);
+		else if (::strcmp(option, "--frames") == 0)
+			frames = (unsigned int)::atoi(value);
+		else if (::strcmp(option, "--source") == 0)
+			source = value;
+		else if (::strcmp(option, "--replay") == 0)
+			replay = value;
+		else if (::strcmp(option, "--loss") == 0)
+			loss = ::atof(value);
+		else if (::strcmp(option, "--jitter") == 0)
+			jitter = (unsigned int)::atoi(value);
+		else if (::strcmp(option, "--reorder") == 0)
+			reorder = ::atof(value);
+		else if (::strcmp(option, "--duplicate") == 0)
+			duplicate = ::atof(value);
+		else if (::strcmp(option, "--seed") == 0) {
+			seed   = (unsigned int)::strtoul(value, nullptr, 10);
+			seeded = true;
+		} else if (::strcmp(option, "--time") == 0)
+			seconds = (unsigned int)::atoi(value);
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (port == 0U || frames == 0U || name.size() > (M17_CALLSIGN_LENGTH - 2U)) {
+		usage();
+		return 1;
+	}
+
+	// The messages, warnings and errors
+	::LogInitialise(false, "/tmp", "FakeReflector", 0U, 2U, false);
+
+	CUDPSocket::startup();
+
+	CSimReflector reflector(port, name, streams, frames, source);
+	reflector.setNACK(nack);
+	reflector.setImpairments(loss, jitter, reorder, duplicate);
+	if (seeded)
+		reflector.setSeed(seed);
+
+	if (!replay.empty() && !reflector.replay(replay))
+		return 1;
+
+	if (!reflector.open())
+		return 1;
+
+	::signal(SIGINT,  sigHandler);
+	::signal(SIGTERM, sigHandler);
+
+	unsigned long long start = CStopWatch::nanoseconds();
+	unsigned long long stop  = (seconds > 0U) ? start + seconds * 1000000000ULL : ~0ULL;
+	bool sending = false;
+
+	while (!m_killed.load()) {
+		unsigned long long now = CStopWatch::nanoseconds();
+		if (now >= stop)
+			break;
+
+		reflector.clock(now);
+
+		// The streams start with the first link
+		if (!sending && reflector.getLinks() > 0U) {
+			reflector.start(now);
+			sending = true;
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(POLL_TIME));
+	}
+
+	reflector.close();
+
+	reflector.getStats().print(stdout);
+	::fprintf(stdout, "Impairments: %llu lost, %llu reordered, %llu duplicated\n", reflector.getDropped(), reflector.getReordered(), reflector.getDuplicated());
+
+	CUDPSocket::shutdown();
+
+	::LogFinalise();
+
+	return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Prints a file written by the flight recorder, one line per record
+
+#include "FlightRecorder.h"
+#include "M17Defines.h"
+#include "M17Utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+static const char* REASONS[]    = { "signal", "link lost", "buffer overflow" };
+static const char* DIRECTIONS[] = { "RF in  ", "RF out ", "Net in ", "Net out" };
+static const char* STATES[]     = { "not linked", "linked", "linking", "unlinking", "echo" };
+
+static const char* text(const char** table, unsigned int length, unsigned int n)
+{
+	return (n < length) ? table[n] : "?";
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2) {
+		::fprintf(stderr, "Usage: FlightDump <file>\n");
+		return 1;
+	}
+
+	FILE* fp = ::fopen(argv[1], "rb");
+	if (fp == nullptr) {
+		::fprintf(stderr, "FlightDump: cannot open %s\n", argv[1]);
+		return 1;
+	}
+
+	CFlightHeader header;
+	if (::fread(&header, sizeof(CFlightHeader), 1U, fp) != 1U || ::memcmp(header.m_magic, FLIGHT_MAGIC, sizeof(header.m_magic)) != 0) {
+		::fprintf(stderr, "FlightDump: %s is not a flight recorder file\n", argv[1]);
+		::fclose(fp);
+		return 1;
+	}
+
+	if (header.m_recordLength != sizeof(CFlightRecord)) {
+		::fprintf(stderr, "FlightDump: unsupported record length of %u\n", header.m_recordLength);
+		::fclose(fp);
+		return 1;
+	}
+
+	::fprintf(stdout, "%u records, written because of a %s\n", header.m_count, text(REASONS, 3U, header.m_reason));
+
+	CFlightRecord record;
+	while (::fread(&record, sizeof(CFlightRecord), 1U, fp) == 1U) {
+		uint64_t ns = record.m_timestamp + header.m_offset;
+
+		time_t t = time_t(ns / 1000000000ULL);
+		struct tm* tm = ::gmtime(&t);
+
+		char timestamp[50U];
+		::sprintf(timestamp, "%02d:%02d:%02d.%06u", tm->tm_hour, tm->tm_min, tm->tm_sec, (unsigned int)((ns % 1000000000ULL) / 1000ULL));
+
+		if (record.m_type == uint8_t(FLIGHT_TYPE::FRAME)) {
+			char source[M17_CALLSIGN_LENGTH + 2U];
+			char dest[M17_CALLSIGN_LENGTH + 2U];
+			CM17Utils::decodeCallsign(record.m_source, source);
+			CM17Utils::decodeCallsign(record.m_dest, dest);
+
+			::fprintf(stdout, "%s %s id %04X fn %04X%s %-9s > %s\n", timestamp, text(DIRECTIONS, 4U, record.m_direction),
+				record.m_id, record.m_fn & 0x7FFFU, (record.m_fn & 0x8000U) == 0x8000U ? " end" : "    ", source, dest);
+		} else if (record.m_type == uint8_t(FLIGHT_TYPE::STATE)) {
+			::fprintf(stdout, "%s State   %s > %s\n", timestamp, text(STATES, 5U, record.m_value >> 8), text(STATES, 5U, record.m_value & 0xFFU));
+		}
+	}
+
+	::fclose(fp);
+
+	return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "FuzzDatagrams.h"
+
+#include <cassert>
+
+CFuzzDatagrams::CFuzzDatagrams(const uint8_t* data, size_t size) :
+m_data(data),
+m_size(size)
+{
+	assert(data != nullptr || size == 0U);
+}
+
+bool CFuzzDatagrams::next(const unsigned char*& data, unsigned int& length, bool& stranger, bool& tick)
+{
+	if (m_size < 2U)
+		return false;
+
+	stranger = (m_data[0U] & 0x80U) == 0x80U;
+	tick     = (m_data[0U] & 0x40U) == 0x40U;
+	length   = ((m_data[0U] & 0x03U) << 8) + m_data[1U];
+
+	m_data += 2U;
+	m_size -= 2U;
+
+	if (length > m_size)
+		length = (unsigned int)m_size;
+
+	data = m_data;
+
+	m_data += length;
+	m_size -= length;
+
+	return true;
+}
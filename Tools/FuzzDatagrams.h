@@ -0,0 +1,43 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(FuzzDatagrams_H)
+#define	FuzzDatagrams_H
+
+#include <cstddef>
+#include <cstdint>
+
+// The entry point of each fuzz target, called by libFuzzer or by FuzzMain
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+// Splits a fuzz input into datagrams. Each has a two byte header: the top bit
+// sends it from an unknown address, the next moves the clock on by a second
+// before it is sent, and the bottom ten bits are its length. A length that is
+// longer than what is left takes what is left.
+class CFuzzDatagrams {
+public:
+	CFuzzDatagrams(const uint8_t* data, size_t size);
+
+	bool next(const unsigned char*& data, unsigned int& length, bool& stranger, bool& tick);
+
+private:
+	const uint8_t* m_data;
+	size_t         m_size;
+};
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "FuzzGateway.h"
+#include "M17Defines.h"
+#include "Clock.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+const unsigned short MMDVM_PORT     = 47400U;
+const unsigned short LOCAL_PORT     = 47401U;
+const unsigned short NETWORK_PORT   = 47402U;
+const unsigned short REMOTE_PORT    = 47403U;
+const unsigned short REFLECTOR_PORT = 47404U;
+
+const char* HOSTS_FILE = "/tmp/FuzzGateway.hosts";
+
+// A pass is idle when nothing was forwarded or sent, two in a row and the
+// gateway has settled. Any input should be over long before the limit.
+const unsigned int IDLE_PASSES = 2U;
+const unsigned int MAX_PASSES  = 1000U;
+
+const unsigned int BUFFER_LENGTH = 2000U;
+
+CFuzzGateway& CFuzzGateway::get()
+{
+	static CFuzzGateway gateway;
+
+	return gateway;
+}
+
+CFuzzGateway::CFuzzGateway() :
+m_clock(1000000000ULL),
+m_reflectors(nullptr),
+m_repeater(nullptr),
+m_mmdvm("127.0.0.1", MMDVM_PORT),
+m_reflector("127.0.0.1", REFLECTOR_PORT),
+m_remote("127.0.0.1"),
+m_stranger("127.0.0.1"),
+m_rptAddr(),
+m_networkAddr(),
+m_remoteAddr(),
+m_addrLen(0U),
+m_remoteBinary(false)
+{
+	CClock::set(&m_clock);
+	m_clock.setDriver();
+
+	// Malformed traffic is logged, which would only slow the fuzzing down
+	::LogInitialise(false, "/tmp", "FuzzGateway", 0U, 0U, false);
+
+	CUDPSocket::startup();
+
+	FILE* fp = ::fopen(HOSTS_FILE, "wt");
+	if (fp == nullptr) {
+		::fprintf(stderr, "FuzzGateway: unable to write %s\n", HOSTS_FILE);
+		::exit(1);
+	}
+
+	::fprintf(fp, "M17-FUZ 127.0.0.1 %u\n", REFLECTOR_PORT);
+	::fprintf(fp, "M17-AAA 127.0.0.1 %u\n", REFLECTOR_PORT);
+	::fclose(fp);
+
+	m_reflectors = new CReflectors(HOSTS_FILE, "", 0U);
+	m_reflectors->load();
+
+	CRepeaterConf conf;
+	conf.m_callsign    = "G4KLX";
+	conf.m_suffix      = "R";
+	conf.m_rptPort     = MMDVM_PORT;
+	conf.m_localPort   = LOCAL_PORT;
+	conf.m_networkPort = NETWORK_PORT;
+	conf.m_remotePort  = REMOTE_PORT;
+	conf.m_startup     = "M17-FUZ C";
+
+	CUDPSocket::lookup("127.0.0.1", LOCAL_PORT,   m_rptAddr,     m_addrLen);
+	CUDPSocket::lookup("127.0.0.1", NETWORK_PORT, m_networkAddr, m_addrLen);
+	CUDPSocket::lookup("127.0.0.1", REMOTE_PORT,  m_remoteAddr,  m_addrLen);
+
+	m_repeater = new CM17Repeater(conf, "", *m_reflectors, nullptr, false, false);
+
+	if (!m_mmdvm.open() || !m_reflector.open() || !m_remote.open() || !m_stranger.open() || !m_repeater->open()) {
+		::fprintf(stderr, "FuzzGateway: unable to open the sockets, is something else using ports %u to %u?\n", MMDVM_PORT, REFLECTOR_PORT);
+		::exit(1);
+	}
+
+	m_repeater->start();
+	run();
+}
+
+CFuzzGateway::~CFuzzGateway()
+{
+	m_repeater->close();
+	delete m_repeater;
+	delete m_reflectors;
+
+	m_mmdvm.close();
+	m_reflector.close();
+	m_remote.close();
+	m_stranger.close();
+
+	CUDPSocket::shutdown();
+
+	CClock::set(nullptr);
+
+	::LogFinalise();
+}
+
+void CFuzzGateway::fromMMDVM(const unsigned char* data, unsigned int length, bool stranger)
+{
+	assert(data != nullptr || length == 0U);
+
+	if (length == 0U)
+		return;
+
+	if (stranger)
+		m_stranger.write(data, length, m_rptAddr, m_addrLen);
+	else
+		m_mmdvm.write(data, length, m_rptAddr, m_addrLen);
+
+	run();
+}
+
+void CFuzzGateway::fromReflector(const unsigned char* data, unsigned int length, bool stranger)
+{
+	assert(data != nullptr || length == 0U);
+
+	if (length == 0U)
+		return;
+
+	if (stranger)
+		m_stranger.write(data, length, m_networkAddr, m_addrLen);
+	else
+		m_reflector.write(data, length, m_networkAddr, m_addrLen);
+
+	run();
+}
+
+void CFuzzGateway::fromRemote(const unsigned char* data, unsigned int length)
+{
+	assert(data != nullptr || length == 0U);
+
+	if (length == 0U)
+		return;
+
+	m_remoteBinary = data[0U] == '#';
+
+	m_remote.write(data, length, m_remoteAddr, m_addrLen);
+
+	run();
+}
+
+// Whatever the last input left behind, the unlink and link give a fresh link
+// which the reflector end accepts as soon as it sees the CONN
+void CFuzzGateway::link()
+{
+	const char* command = "unlink;link M17-FUZ_C";
+
+	fromRemote((const unsigned char*)command, (unsigned int)::strlen(command));
+}
+
+void CFuzzGateway::tick(unsigned int ms)
+{
+	m_clock.advance(ms * 1000000ULL);
+
+	m_reflectors->clock(ms);
+	m_repeater->clock(ms);
+
+	run();
+}
+
+void CFuzzGateway::run()
+{
+	unsigned int idle = 0U;
+
+	for (unsigned int n = 0U; idle < IDLE_PASSES; n++) {
+		check(n < MAX_PASSES, "the forwarding path is still busy", nullptr, 0U);
+
+		bool busy = m_repeater->process();
+
+		m_repeater->clock(0U);
+
+		if (collect())
+			busy = true;
+
+		idle = busy ? 0U : idle + 1U;
+	}
+}
+
+// Everything that the gateway sends has to be well formed, whatever it was sent
+bool CFuzzGateway::collect()
+{
+	bool busy = false;
+
+	unsigned char buffer[BUFFER_LENGTH];
+	sockaddr_storage addr;
+	unsigned int addrLen;
+
+	int length;
+	while ((length = m_mmdvm.read(buffer, BUFFER_LENGTH, addr, addrLen)) > 0) {
+		bool ok = (length == 4 && ::memcmp(buffer, "PING", 4U) == 0) ||
+			  (length == int(M17_NETWORK_FRAME_LENGTH) && ::memcmp(buffer, "M17 ", 4U) == 0);
+		check(ok, "a bad datagram was sent to the MMDVM", buffer, length);
+		busy = true;
+	}
+
+	while ((length = m_reflector.read(buffer, BUFFER_LENGTH, addr, addrLen)) > 0) {
+		bool ok = (length == 11 && ::memcmp(buffer, "CONN", 4U) == 0) ||
+			  (length == 10 && ::memcmp(buffer, "DISC", 4U) == 0) ||
+			  (length == 10 && ::memcmp(buffer, "PONG", 4U) == 0) ||
+			  (length == int(M17_NETWORK_FRAME_LENGTH) && ::memcmp(buffer, "M17 ", 4U) == 0);
+		check(ok, "a bad datagram was sent to the reflector", buffer, length);
+
+		if (::memcmp(buffer, "CONN", 4U) == 0)
+			m_reflector.write((const unsigned char*)"ACKN", 4U, addr, addrLen);
+
+		busy = true;
+	}
+
+	while ((length = m_remote.read(buffer, BUFFER_LENGTH, addr, addrLen)) > 0) {
+		if (m_remoteBinary)
+			check(length >= 6 && ::memcmp(buffer, "M17R", 4U) == 0, "a bad binary reply was sent", buffer, length);
+		busy = true;
+	}
+
+	// Nothing should ever be sent to an address that the gateway doesn't know
+	length = m_stranger.read(buffer, BUFFER_LENGTH, addr, addrLen);
+	check(length <= 0, "a datagram was sent to an unknown address", buffer, length);
+
+	return busy;
+}
+
+void CFuzzGateway::check(bool ok, const char* text, const unsigned char* data, int length) const
+{
+	assert(text != nullptr);
+
+	if (ok)
+		return;
+
+	::fprintf(stderr, "FuzzGateway: %s\n", text);
+
+	for (int i = 0; i < length && data != nullptr; i++)
+		::fprintf(stderr, "%02X%s", data[i], ((i % 16) == 15) ? "\n" : " ");
+	::fprintf(stderr, "\n");
+
+	::abort();
+}
@@ -0,0 +1,76 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(FuzzGateway_H)
+#define	FuzzGateway_H
+
+#include "FuzzDatagrams.h"
+#include "M17Repeater.h"
+#include "ManualClock.h"
+#include "Reflectors.h"
+#include "UDPSocket.h"
+
+// A repeater with the MMDVM, the reflector and a remote command client all
+// played from sockets on the loopback, so that whatever a fuzz target sends
+// goes through the real parsers and the forwarding path behind them. Time is
+// virtual, and only moves when a target says so. Anything that the gateway
+// sends that isn't well formed, or a forwarding path that stays busy after
+// the input has run out, aborts so that the fuzzer reports it.
+class CFuzzGateway {
+public:
+	static CFuzzGateway& get();
+
+	// From the MMDVM, or from an address that the gateway doesn't know
+	void fromMMDVM(const unsigned char* data, unsigned int length, bool stranger);
+
+	// From the reflector, or from an address that the gateway doesn't know
+	void fromReflector(const unsigned char* data, unsigned int length, bool stranger);
+
+	void fromRemote(const unsigned char* data, unsigned int length);
+
+	// Links to the reflector and waits for the link to be up
+	void link();
+
+	// Moves the clock on, for the timers
+	void tick(unsigned int ms);
+
+	// Passes until the forwarding path is idle
+	void run();
+
+private:
+	CFuzzGateway();
+	~CFuzzGateway();
+
+	CManualClock  m_clock;
+	CReflectors*  m_reflectors;
+	CM17Repeater* m_repeater;
+	CUDPSocket    m_mmdvm;
+	CUDPSocket    m_reflector;
+	CUDPSocket    m_remote;
+	CUDPSocket    m_stranger;
+	sockaddr_storage m_rptAddr;
+	sockaddr_storage m_networkAddr;
+	sockaddr_storage m_remoteAddr;
+	unsigned int  m_addrLen;
+	bool          m_remoteBinary;
+
+	bool collect();
+	void check(bool ok, const char* text, const unsigned char* data, int length) const;
+};
+
+#endif
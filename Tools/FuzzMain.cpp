@@ -0,0 +1,197 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Runs a fuzz target over files and directories of inputs, for when it has
+// been built without libFuzzer. With --mutate each input is also run with
+// that many random mutations, which is a long way short of what libFuzzer
+// does but is enough to find the shallow bugs under the sanitizers.
+
+#include "FuzzDatagrams.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+const size_t MAX_INPUT_LENGTH = 4096U;
+
+// Each mutated input is written here before it is run, so that one which
+// crashes the target can be run again on its own
+const char* LAST_INPUT = "fuzz-input.last";
+
+static void usage()
+{
+	::fprintf(stderr,
+		"Usage: <fuzz target> [options] <file or directory> ...\n"
+		"  --mutate <count>   run this many random mutations of each input (0)\n"
+		"  --seed <seed>      the seed for the mutations (1)\n"
+		"The mutated input being run is kept in %s\n", LAST_INPUT);
+}
+
+static bool readFile(const std::string& file, std::vector<uint8_t>& data)
+{
+	FILE* fp = ::fopen(file.c_str(), "rb");
+	if (fp == nullptr)
+		return false;
+
+	data.resize(MAX_INPUT_LENGTH);
+	size_t n = ::fread(data.data(), 1U, MAX_INPUT_LENGTH, fp);
+	data.resize(n);
+
+	::fclose(fp);
+
+	return true;
+}
+
+static void writeFile(const char* file, const std::vector<uint8_t>& data)
+{
+	FILE* fp = ::fopen(file, "wb");
+	if (fp == nullptr)
+		return;
+
+	::fwrite(data.data(), 1U, data.size(), fp);
+	::fclose(fp);
+}
+
+static bool addInputs(const std::string& path, std::vector<std::string>& files)
+{
+	struct stat st;
+	if (::stat(path.c_str(), &st) != 0)
+		return false;
+
+	if (!S_ISDIR(st.st_mode)) {
+		files.push_back(path);
+		return true;
+	}
+
+	DIR* dir = ::opendir(path.c_str());
+	if (dir == nullptr)
+		return false;
+
+	struct dirent* entry;
+	while ((entry = ::readdir(dir)) != nullptr) {
+		if (entry->d_name[0U] != '.')
+			files.push_back(path + "/" + entry->d_name);
+	}
+
+	::closedir(dir);
+
+	return true;
+}
+
+// The usual mutations: flipped bits, changed, inserted and deleted bytes,
+// truncation, and a repeated run which is often a datagram
+static void mutate(std::vector<uint8_t>& data, std::mt19937& random)
+{
+	unsigned int changes = 1U + random() % 4U;
+
+	for (unsigned int i = 0U; i < changes; i++) {
+		size_t size = data.size();
+		size_t pos  = (size > 0U) ? random() % size : 0U;
+
+		switch (random() % 6U) {
+		case 0U:
+			if (size > 0U)
+				data[pos] ^= 1U << (random() % 8U);
+			break;
+		case 1U:
+			if (size > 0U)
+				data[pos] = uint8_t(random());
+			break;
+		case 2U:
+			if (size < MAX_INPUT_LENGTH)
+				data.insert(data.begin() + pos, uint8_t(random()));
+			break;
+		case 3U:
+			if (size > 0U)
+				data.erase(data.begin() + pos);
+			break;
+		case 4U:
+			data.resize(pos);
+			break;
+		default:
+			if (size > 0U) {
+				size_t length = 1U + random() % (size - pos);
+				if (size + length <= MAX_INPUT_LENGTH)
+					data.insert(data.end(), data.begin() + pos, data.begin() + pos + length);
+			}
+			break;
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int mutations = 0U;
+	unsigned int seed      = 1U;
+
+	std::vector<std::string> files;
+
+	for (int i = 1; i < argc; i++) {
+		if (::strcmp(argv[i], "--mutate") == 0 && (i + 1) < argc) {
+			mutations = (unsigned int)::atoi(argv[++i]);
+		} else if (::strcmp(argv[i], "--seed") == 0 && (i + 1) < argc) {
+			seed = (unsigned int)::atoi(argv[++i]);
+		} else if (argv[i][0U] == '-') {
+			usage();
+			return 1;
+		} else if (!addInputs(argv[i], files)) {
+			::fprintf(stderr, "Unable to read %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (files.empty()) {
+		usage();
+		return 1;
+	}
+
+	std::mt19937 random(seed);
+
+	unsigned long long runs = 0ULL;
+
+	for (std::vector<std::string>::const_iterator it = files.cbegin(); it != files.cend(); ++it) {
+		std::vector<uint8_t> input;
+		if (!readFile(*it, input)) {
+			::fprintf(stderr, "Unable to read %s\n", it->c_str());
+			return 1;
+		}
+
+		::LLVMFuzzerTestOneInput(input.data(), input.size());
+		runs++;
+
+		for (unsigned int i = 0U; i < mutations; i++) {
+			std::vector<uint8_t> data = input;
+			mutate(data, random);
+
+			writeFile(LAST_INPUT, data);
+
+			::LLVMFuzzerTestOneInput(data.data(), data.size());
+			runs++;
+		}
+	}
+
+	::fprintf(stdout, "%llu inputs from %u files were run\n", runs, (unsigned int)files.size());
+
+	return 0;
+}
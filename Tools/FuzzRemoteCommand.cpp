@@ -0,0 +1,39 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// A datagram to the remote command port, through CRemoteCommand::parse() and
+// the commands that it finds, which are carried out. The input is the whole
+// datagram, the corpus is in Tools/Corpus/RemoteCommand.
+
+#include "FuzzDatagrams.h"
+#include "FuzzGateway.h"
+
+// A little longer than the gateway reads, so that the truncation is covered
+const size_t MAX_COMMAND_LENGTH = 1100U;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	CFuzzGateway& gateway = CFuzzGateway::get();
+
+	if (size > MAX_COMMAND_LENGTH)
+		size = MAX_COMMAND_LENGTH;
+
+	gateway.fromRemote(data, (unsigned int)size);
+
+	return 0;
+}
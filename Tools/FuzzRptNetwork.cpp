@@ -0,0 +1,45 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Datagrams from the MMDVM, through CRptNetwork::clock() and on through the
+// forwarding path to the reflector, the echo and the stream tracking. The
+// input is split up by CFuzzDatagrams, the corpus is in Tools/Corpus/RptNetwork.
+
+#include "FuzzDatagrams.h"
+#include "FuzzGateway.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	CFuzzGateway& gateway = CFuzzGateway::get();
+
+	gateway.link();
+
+	CFuzzDatagrams datagrams(data, size);
+
+	const unsigned char* datagram = nullptr;
+	unsigned int length = 0U;
+	bool stranger = false, tick = false;
+	while (datagrams.next(datagram, length, stranger, tick)) {
+		if (tick)
+			gateway.tick(1000U);
+
+		gateway.fromMMDVM(datagram, length, stranger);
+	}
+
+	return 0;
+}
@@ -0,0 +1,343 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Times the primitives run for every frame, in ns per operation. The
+// process is pinned to one CPU, each primitive is warmed up and then timed
+// over several batches, and the median and fastest batches are shown, so
+// that a change to one of them can be measured rather than guessed.
+//
+// Usage: M17Bench [cpu], the CPU is 0 by default and -1 leaves it unpinned.
+
+#include "M17Network.h"
+#include "RptNetwork.h"
+#include "RingBuffer.h"
+#include "M17Defines.h"
+#include "UDPSocket.h"
+#include "M17Utils.h"
+#include "RealTime.h"
+#include "M17LSF.h"
+#include "Thread.h"
+#include "Utils.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Long enough for the CPU to reach its full clock, and the caches to be filled
+const unsigned int WARMUP_TIME = 200U;		// ms
+
+const unsigned int BATCHES = 9U;
+
+const unsigned int CALLSIGN_COUNT = 16U;
+
+// The networks and their far ends on the loopback
+const unsigned short NETWORK_PORT   = 47500U;
+const unsigned short REFLECTOR_PORT = 47501U;
+const unsigned short RPT_PORT       = 47502U;
+const unsigned short MMDVM_PORT     = 47503U;
+
+const char* CALLSIGNS[CALLSIGN_COUNT] = {
+	"G4KLX", "M17-M17 C", "N0CALL", "ECHO", "W1AW/P", "M17-USA A", "DL1ABC-7", "INFO",
+	"VK2XYZ", "M17-GBR Z", "JA1ZZZ", "UNLINK", "F4ABC", "M17-DEU B", "EA3XYZ", "ALL"
+};
+
+static unsigned char m_frame[M17_NETWORK_FRAME_LENGTH];
+
+static std::vector<std::string> m_callsigns;
+static unsigned char m_encoded[CALLSIGN_COUNT][6U];
+static unsigned char m_lsfs[CALLSIGN_COUNT][M17_LSF_LENGTH_BYTES];
+
+static CRingBuffer<unsigned char>* m_buffer = nullptr;
+
+static CM17Network* m_network   = nullptr;
+static CRptNetwork* m_rpt       = nullptr;
+static CUDPSocket*  m_reflector = nullptr;
+static CUDPSocket*  m_mmdvm     = nullptr;
+static sockaddr_storage m_rptAddr;
+static unsigned int m_addrLen   = 0U;
+
+// Keeps the results alive so that the work isn't optimised away
+static volatile unsigned int m_sink = 0U;
+
+// A frame sent by the real CM17Network::write() with debugging on, and taken
+// off the loopback by the reflector end
+static void networkWrite(unsigned int n)
+{
+	m_network->write(m_frame);
+
+	unsigned char buffer[100U];
+	sockaddr_storage addr;
+	unsigned int addrLen;
+	m_sink += m_reflector->read(buffer, 100U, addr, addrLen);
+}
+
+// A frame sent over the loopback by the MMDVM end, and received by the real
+// CRptNetwork::clock() and read() with debugging on
+static void rptClock(unsigned int n)
+{
+	m_mmdvm->write(m_frame, M17_NETWORK_FRAME_LENGTH, m_rptAddr, m_addrLen);
+
+	m_rpt->clock(0U);
+
+	unsigned char data[M17_NETWORK_FRAME_LENGTH];
+	if (m_rpt->read(data))
+		m_sink += data[5U];
+}
+
+static void encodeCallsign(unsigned int n)
+{
+	unsigned char encoded[6U];
+	CM17Utils::encodeCallsign(m_callsigns[n % CALLSIGN_COUNT], encoded);
+	m_sink += encoded[5U];
+}
+
+static void decodeCallsign(unsigned int n)
+{
+	char callsign[M17_CALLSIGN_LENGTH + 2U];
+	CM17Utils::decodeCallsign(m_encoded[n % CALLSIGN_COUNT], callsign);
+	m_sink += callsign[0U];
+}
+
+static void decodeCallsignString(unsigned int n)
+{
+	std::string callsign = CM17Utils::decodeCallsign(m_encoded[n % CALLSIGN_COUNT]);
+	m_sink += callsign.size();
+}
+
+static void lsfGet(unsigned int n)
+{
+	CM17LSF lsf;
+	lsf.setNetwork(m_lsfs[n % CALLSIGN_COUNT]);
+
+	char source[M17_CALLSIGN_LENGTH + 2U], dest[M17_CALLSIGN_LENGTH + 2U];
+	lsf.getSource(source);
+	lsf.getDest(dest);
+
+	m_sink += source[0U] + dest[0U] + lsf.getDataType();
+}
+
+static void lsfSet(unsigned int n)
+{
+	CM17LSF lsf;
+	lsf.setSource(m_callsigns[n % CALLSIGN_COUNT]);
+	lsf.setDest(m_callsigns[(n + 1U) % CALLSIGN_COUNT]);
+	lsf.setPacketStream(M17_STREAM_TYPE);
+	lsf.setDataType(M17_DATA_TYPE_VOICE);
+	lsf.setEncryptionType(M17_ENCRYPTION_TYPE_NONE);
+	lsf.setCAN(0U);
+
+	unsigned char data[M17_LSF_LENGTH_BYTES];
+	lsf.getNetwork(data);
+	m_sink += data[5U];
+}
+
+// A frame in and out with its timestamp, the fixed length record CRptNetwork and CM17Network queue
+static void ringBuffer(unsigned int n)
+{
+	unsigned long long timestamp = n;
+
+	if (m_buffer->hasSpace(sizeof(timestamp) + M17_NETWORK_FRAME_LENGTH)) {
+		m_buffer->addData((unsigned char*)&timestamp, sizeof(timestamp));
+		m_buffer->addData(m_frame, M17_NETWORK_FRAME_LENGTH);
+	}
+
+	if (m_buffer->isEmpty())
+		return;
+
+	unsigned char data[M17_NETWORK_FRAME_LENGTH];
+	m_buffer->getData((unsigned char*)&timestamp, sizeof(timestamp));
+	m_buffer->getData(data, M17_NETWORK_FRAME_LENGTH);
+
+	m_sink += data[n % M17_NETWORK_FRAME_LENGTH];
+}
+
+// The hex dump the networks make of every frame when debugging is on
+static void dumpFrame(unsigned int n)
+{
+	CUtils::dump(1U, "Network Data Received", m_frame, M17_NETWORK_FRAME_LENGTH);
+
+	m_sink += n;
+}
+
+// As CM17Forwarder puts the callsigns into the META field of a frame from the reflector
+static void metaInjection(unsigned int n)
+{
+	unsigned char frame[M17_NETWORK_FRAME_LENGTH];
+	::memcpy(frame, m_frame, M17_NETWORK_FRAME_LENGTH);
+
+	CM17Utils::injectCallsigns(frame, m_encoded[n % CALLSIGN_COUNT]);
+
+	m_sink += frame[20U + n % 14U];
+}
+
+// The reflector end answers the CONN, so that the network is linked and writes
+static bool openNetworks()
+{
+	CUDPSocket::startup();
+
+	m_reflector = new CUDPSocket("127.0.0.1", REFLECTOR_PORT);
+	m_mmdvm     = new CUDPSocket("127.0.0.1", MMDVM_PORT);
+	if (!m_reflector->open() || !m_mmdvm->open())
+		return false;
+
+	m_rpt = new CRptNetwork(RPT_PORT, "127.0.0.1", MMDVM_PORT, true, "");
+	if (!m_rpt->open())
+		return false;
+
+	CUDPSocket::lookup("127.0.0.1", RPT_PORT, m_rptAddr, m_addrLen);
+
+	sockaddr_storage addr;
+	unsigned int addrLen;
+	CUDPSocket::lookup("127.0.0.1", REFLECTOR_PORT, addr, addrLen);
+
+	m_network = new CM17Network("G4KLX", "R", NETWORK_PORT, true, "");
+	if (!m_network->link("M17-BEN C", addr, addrLen, 'C'))
+		return false;
+
+	unsigned char buffer[100U];
+	for (unsigned int i = 0U; i < 100U && m_network->getStatus() != M17NET_STATUS::LINKED; i++) {
+		if (m_reflector->read(buffer, 100U, addr, addrLen) > 0 && ::memcmp(buffer, "CONN", 4U) == 0)
+			m_reflector->write((const unsigned char*)"ACKN", 4U, addr, addrLen);
+
+		m_network->clock(0U);
+
+		CThread::sleep(1U);
+	}
+
+	return m_network->getStatus() == M17NET_STATUS::LINKED;
+}
+
+static void closeNetworks()
+{
+	m_network->close();
+	m_rpt->close();
+	m_reflector->close();
+	m_mmdvm->close();
+
+	delete m_network;
+	delete m_rpt;
+	delete m_reflector;
+	delete m_mmdvm;
+
+	CUDPSocket::shutdown();
+}
+
+static double batch(void (*func)(unsigned int), unsigned int iterations)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (unsigned int i = 0U; i < iterations; i++)
+		func(i);
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	return double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / double(iterations);
+}
+
+static void run(const char* name, void (*func)(unsigned int), unsigned int iterations)
+{
+	// Warm up for a fixed time rather than a number of calls, however slow the primitive is
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::milliseconds(WARMUP_TIME);
+	while (std::chrono::steady_clock::now() < end)
+		batch(func, 1000U);
+
+	std::vector<double> times;
+	for (unsigned int i = 0U; i < BATCHES; i++)
+		times.push_back(batch(func, iterations));
+
+	std::sort(times.begin(), times.end());
+
+	::fprintf(stdout, "%-40s %10.1f ns/op %10.1f min\n", name, times.at(BATCHES / 2U), times.front());
+}
+
+int main(int argc, char** argv)
+{
+	int cpu = (argc > 1) ? ::atoi(argv[1]) : 0;
+
+	bool pinned = cpu >= 0 && CRealTime::setAffinity("M17Bench", cpu);
+	if (cpu >= 0 && !pinned)
+		::fprintf(stderr, "M17Bench: unable to pin to CPU %d, the times will be less stable\n", cpu);
+
+	for (unsigned int i = 0U; i < M17_NETWORK_FRAME_LENGTH; i++)
+		m_frame[i] = i;
+	::memcpy(m_frame, "M17 ", 4U);
+
+	for (unsigned int i = 0U; i < CALLSIGN_COUNT; i++) {
+		m_callsigns.push_back(CALLSIGNS[i]);
+
+		CM17Utils::encodeCallsign(CALLSIGNS[i], m_encoded[i]);
+
+		CM17LSF lsf;
+		lsf.setDest(CALLSIGNS[i]);
+		lsf.setSource(CALLSIGNS[(i + 1U) % CALLSIGN_COUNT]);
+		lsf.getNetwork(m_lsfs[i]);
+	}
+
+	m_buffer = new CRingBuffer<unsigned char>(1000U, "Bench");
+
+	// Debug enabled in the gateway, but level 1 filtered out of the log
+	::LogInitialise(false, "/tmp", "M17Bench", 0U, 2U, false);
+
+	if (!openNetworks()) {
+		::fprintf(stderr, "M17Bench: unable to open the networks, is something else using ports %u to %u?\n", NETWORK_PORT, MMDVM_PORT);
+		return 1;
+	}
+
+	if (pinned)
+		::fprintf(stdout, "Pinned to CPU %d, the median and fastest of %u batches\n", cpu, BATCHES);
+	else
+		::fprintf(stdout, "Not pinned, the median and fastest of %u batches\n", BATCHES);
+	run("CM17Utils::encodeCallsign", encodeCallsign, 1000000U);
+	run("CM17Utils::decodeCallsign to char*", decodeCallsign, 1000000U);
+	run("CM17Utils::decodeCallsign to string", decodeCallsignString, 1000000U);
+	run("CM17LSF set and get source and dest", lsfGet, 1000000U);
+	run("CM17LSF build from callsigns", lsfSet, 1000000U);
+	run("CRingBuffer add and get frame", ringBuffer, 1000000U);
+	run("META injection", metaInjection, 1000000U);
+	run("CUtils::dump, level 1 filtered out", dumpFrame, 1000000U);
+
+	::fprintf(stdout, "Over the loopback with debugging on, level 1 filtered out\n");
+	run("CM17Network::write", networkWrite, 100000U);
+	run("CRptNetwork::clock and read", rptClock, 100000U);
+
+	// For comparison, the same calls with level 1 written to a file
+	::LogInitialise(false, "/tmp", "M17Bench", 1U, 0U, false);
+
+	::fprintf(stdout, "Level 1 written to /tmp/M17Bench.log\n");
+	run("CUtils::dump", dumpFrame, 10000U);
+
+	::fprintf(stdout, "Over the loopback with debugging on, level 1 written to /tmp/M17Bench.log\n");
+	run("CM17Network::write", networkWrite, 10000U);
+	run("CRptNetwork::clock and read", rptClock, 10000U);
+
+	// Nothing to say about closing
+	::LogInitialise(false, "/tmp", "M17Bench", 0U, 0U, false);
+
+	closeNetworks();
+
+	::LogFinalise();
+
+	delete m_buffer;
+
+	return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Drives a number of repeaters with as many frames as their sockets will take,
+// with the repeaters shared among 1, 2, 4 ... workers, and reports the frames
+// handled per second for each. The senders run on the same machine, so there
+// need to be spare cores for them if the figures are to mean anything.
+
+#include "M17Repeater.h"
+#include "Reflectors.h"
+#include "M17Defines.h"
+#include "M17Utils.h"
+#include "UDPSocket.h"
+#include "Metrics.h"
+#include "Worker.h"
+#include "Log.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+const unsigned short LOCAL_PORT   = 40000U;
+const unsigned short RPT_PORT     = 41000U;
+const unsigned short NETWORK_PORT = 42000U;
+
+static std::atomic<bool> m_sending(false);
+
+static std::string repeaterName(unsigned int n)
+{
+	char name[20U];
+	::sprintf(name, "LOAD %u", n);
+	return name;
+}
+
+// Sends frames from where the repeater expects the MMDVM host to be, as fast as it can
+static void sender(unsigned int n)
+{
+	CUDPSocket socket("127.0.0.1", RPT_PORT + n);
+	if (!socket.open())
+		return;
+
+	sockaddr_storage addr;
+	unsigned int addrLen;
+	CUDPSocket::lookup("127.0.0.1", LOCAL_PORT + n, addr, addrLen);
+
+	unsigned char frame[M17_NETWORK_FRAME_LENGTH];
+	::memset(frame, 0x00U, M17_NETWORK_FRAME_LENGTH);
+	::memcpy(frame, "M17 ", 4U);
+	frame[4U] = n >> 8;
+	frame[5U] = n >> 0;
+	CM17Utils::encodeCallsign("ALL", frame + 6U);
+	CM17Utils::encodeCallsign("G4KLX", frame + 12U);
+
+	uint16_t fn = 0U;
+	while (m_sending.load()) {
+		frame[34U] = (fn >> 8) & 0x7FU;
+		frame[35U] = (fn >> 0) & 0xFFU;
+		fn++;
+
+		socket.write(frame, M17_NETWORK_FRAME_LENGTH, addr, addrLen);
+	}
+
+	socket.close();
+}
+
+static unsigned long long received(unsigned int count)
+{
+	unsigned long long total = 0ULL;
+
+	for (unsigned int i = 0U; i < count; i++)
+		total += CMetrics::counter("m17gateway_frames_received_total", "", CMetrics::join("network=\"repeater\"", "repeater=\"" + repeaterName(i) + "\"")).get();
+
+	return total;
+}
+
+static double run(CReflectors& reflectors, unsigned int repeaters, unsigned int workers, unsigned int seconds)
+{
+	std::vector<CM17Repeater*> list;
+	for (unsigned int i = 0U; i < repeaters; i++) {
+		CRepeaterConf conf;
+		conf.m_callsign    = "LOAD";
+		conf.m_rptPort     = RPT_PORT + i;
+		conf.m_localPort   = LOCAL_PORT + i;
+		conf.m_networkPort = NETWORK_PORT + i;
+
+		CM17Repeater* repeater = new CM17Repeater(conf, repeaterName(i), reflectors, nullptr, false, false);
+		if (!repeater->open()) {
+			::fprintf(stderr, "M17Load: unable to open repeater %u\n", i);
+			::exit(1);
+		}
+
+		list.push_back(repeater);
+	}
+
+	unsigned int cpus = std::thread::hardware_concurrency();
+
+	std::vector<CWorker*> pool;
+	for (unsigned int i = 0U; i < workers; i++)
+		pool.push_back(new CWorker(i + 1U, (cpus > 0U) ? int(i % cpus) : -1));
+
+	for (unsigned int i = 0U; i < repeaters; i++)
+		pool.at(i % workers)->add(list.at(i));
+
+	for (std::vector<CWorker*>::const_iterator it = pool.cbegin(); it != pool.cend(); ++it)
+		(*it)->start();
+
+	m_sending.store(true);
+
+	std::vector<std::thread> senders;
+	for (unsigned int i = 0U; i < repeaters; i++)
+		senders.push_back(std::thread(sender, i));
+
+	// Let everything settle before counting
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+	unsigned long long start = received(repeaters);
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+	unsigned long long end = received(repeaters);
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	m_sending.store(false);
+	for (std::vector<std::thread>::iterator it = senders.begin(); it != senders.end(); ++it)
+		it->join();
+
+	for (std::vector<CWorker*>::const_iterator it = pool.cbegin(); it != pool.cend(); ++it) {
+		(*it)->stop();
+		delete *it;
+	}
+
+	for (std::vector<CM17Repeater*>::const_iterator it = list.cbegin(); it != list.cend(); ++it) {
+		(*it)->close();
+		delete *it;
+	}
+
+	return double(end - start) / elapsed;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int repeaters = (argc > 1) ? (unsigned int)::atoi(argv[1]) : 8U;
+	unsigned int workers   = (argc > 2) ? (unsigned int)::atoi(argv[2]) : std::thread::hardware_concurrency();
+	unsigned int seconds   = (argc > 3) ? (unsigned int)::atoi(argv[3]) : 3U;
+
+	if (repeaters == 0U || workers == 0U || seconds == 0U) {
+		::fprintf(stderr, "Usage: M17Load [repeaters] [max workers] [seconds]\n");
+		return 1;
+	}
+
+	if (workers > repeaters)
+		workers = repeaters;
+
+	// Nothing but errors, from several threads
+	::LogInitialise(false, "/tmp", "M17Load", 0U, 5U, false);
+	::LogStartAsync(256U);
+
+	CUDPSocket::startup();
+
+	CReflectors reflectors("", "", 0U);
+
+	::fprintf(stdout, "%u repeaters, %u CPUs\n", repeaters, std::thread::hardware_concurrency());
+	::fprintf(stdout, "%-8s %12s %8s\n", "Workers", "Frames/s", "Scaling");
+
+	double base = 0.0;
+	for (unsigned int n = 1U; n <= workers; n = (n * 2U > workers && n < workers) ? workers : n * 2U) {
+		double rate = run(reflectors, repeaters, n, seconds);
+		if (n == 1U)
+			base = rate;
+
+		::fprintf(stdout, "%-8u %12.0f %8.2f\n", n, rate, (base > 0.0) ? rate / base : 0.0);
+	}
+
+	CUDPSocket::shutdown();
+
+	::LogFinalise();
+
+	return 0;
+}
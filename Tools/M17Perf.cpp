@@ -0,0 +1,463 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Runs the gateway against a simulated MMDVM host and reflector and measures
+// it from the outside. Each run starts a fresh gateway, links it, and sends
+// the same number of streams each way for a while. The frames per second,
+// the latency across the gateway and as it measured it itself, the CPU it
+// used and the frames lost are written as JSON. A last run adds loss,
+// jitter, reordering and duplication to the reflector, to show how the
+// gateway copes.
+
+#include "SimReflector.h"
+#include "SimRepeater.h"
+#include "StopWatch.h"
+#include "UDPSocket.h"
+#include "Version.h"
+#include "Log.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32) || defined(_WIN64)
+int main(int argc, char** argv)
+{
+	::fprintf(stderr, "M17Perf: only runs on Linux\n");
+	return 1;
+}
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+const unsigned short REFLECTOR_PORT = 47000U;
+const unsigned short NETWORK_PORT   = 47001U;
+const unsigned short LOCAL_PORT     = 47010U;
+const unsigned short RPT_PORT       = 47011U;
+const unsigned short REMOTE_PORT    = 47076U;
+
+const char* REFLECTOR_NAME = "M17-SIM";
+
+const char* CONFIG_FILE = "/tmp/M17Perf.ini";
+const char* HOSTS_FILE  = "/tmp/M17Perf.hosts";
+
+const unsigned int POLL_TIME = 100U;		// us
+
+// Each transmission is ten seconds long
+const unsigned int FRAMES = 250U;
+
+struct CPerfLatency {
+	double m_p50;
+	double m_p90;
+	double m_p99;
+	double m_p999;
+	double m_max;
+};
+
+struct CPerfImpairments {
+	double       m_loss;
+	unsigned int m_jitter;
+	double       m_reorder;
+	double       m_duplicate;
+};
+
+static void usage()
+{
+	::fprintf(stderr, "Usage: M17Perf [options]\n"
+		"  --gateway <file>       the gateway to run (./M17Gateway)\n"
+		"  --streams <n>          the most streams each way, runs are made with 1, 2, 4 ... n (8)\n"
+		"  --time <seconds>       the length of each run (5)\n"
+		"  --io                   forward on the gateway's IO thread\n"
+		"  --label <text>         stored with the results, such as a release\n"
+		"  --output <file>        the JSON results (bench.json)\n");
+}
+
+static bool writeConfig(bool io)
+{
+	FILE* fp = ::fopen(HOSTS_FILE, "wt");
+	if (fp == nullptr)
+		return false;
+
+	::fprintf(fp, "%s 127.0.0.1 %u\n", REFLECTOR_NAME, REFLECTOR_PORT);
+	::fclose(fp);
+
+	fp = ::fopen(CONFIG_FILE, "wt");
+	if (fp == nullptr)
+		return false;
+
+	::fprintf(fp, "[General]\nCallsign=M17PERF\nSuffix=R\nRptAddress=127.0.0.1\nRptPort=%u\nLocalPort=%u\nDebug=0\nDaemon=0\n\n", RPT_PORT, LOCAL_PORT);
+	::fprintf(fp, "[Log]\nDisplayLevel=0\nFileLevel=0\nFilePath=/tmp\nFileRoot=M17Perf\n\n");
+	::fprintf(fp, "[Voice]\nEnabled=0\n\n");
+	::fprintf(fp, "[Network]\nPort=%u\nHostsFile1=%s\nHostsFile2=%s\nReloadTime=0\nRevert=0\nHangTime=240\nDebug=0\n\n", NETWORK_PORT, HOSTS_FILE, HOSTS_FILE);
+	::fprintf(fp, "[Remote Commands]\nEnable=1\nPort=%u\n\n", REMOTE_PORT);
+	::fprintf(fp, "[IO Thread]\nEnable=%d\n", io ? 1 : 0);
+
+	::fclose(fp);
+
+	return true;
+}
+
+static pid_t startGateway(const std::string& gateway)
+{
+	pid_t pid = ::fork();
+	if (pid != 0)
+		return pid;
+
+	int fd = ::open("/dev/null", O_WRONLY);
+	if (fd >= 0) {
+		::dup2(fd, STDOUT_FILENO);
+		::dup2(fd, STDERR_FILENO);
+		::close(fd);
+	}
+
+	::execl(gateway.c_str(), gateway.c_str(), CONFIG_FILE, (char*)nullptr);
+	::_exit(127);
+}
+
+// The user and system time used by a process, in seconds
+static double cpuTime(pid_t pid)
+{
+	char file[50U];
+	::sprintf(file, "/proc/%d/stat", int(pid));
+
+	FILE* fp = ::fopen(file, "rt");
+	if (fp == nullptr)
+		return 0.0;
+
+	char buffer[1000U];
+	size_t length = ::fread(buffer, 1U, sizeof(buffer) - 1U, fp);
+	::fclose(fp);
+	buffer[length] = '\0';
+
+	// The fields after the name, which may hold spaces, utime and stime are the 12th and 13th
+	const char* p = ::strrchr(buffer, ')');
+	if (p == nullptr)
+		return 0.0;
+
+	unsigned long utime = 0UL, stime = 0UL;
+	if (::sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2)
+		return 0.0;
+
+	return double(utime + stime) / double(::sysconf(_SC_CLK_TCK));
+}
+
+// Sends a remote command to the gateway, clocking the simulators while waiting for the reply
+static bool command(CUDPSocket& socket, const char* text, std::string& reply, CSimReflector& reflector, CSimRepeater& repeater)
+{
+	sockaddr_storage addr;
+	unsigned int addrLen;
+	if (CUDPSocket::lookup("127.0.0.1", REMOTE_PORT, addr, addrLen) != 0)
+		return false;
+
+	socket.write((const unsigned char*)text, (unsigned int)::strlen(text), addr, addrLen);
+
+	unsigned long long end = CStopWatch::nanoseconds() + 500000000ULL;
+	while (CStopWatch::nanoseconds() < end) {
+		unsigned long long now = CStopWatch::nanoseconds();
+		reflector.clock(now);
+		repeater.clock(now);
+
+		unsigned char buffer[5000U];
+		sockaddr_storage from;
+		unsigned int fromLen;
+		int length = socket.read(buffer, sizeof(buffer) - 1U, from, fromLen);
+		if (length > 0) {
+			reply.assign((const char*)buffer, length);
+			return true;
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(POLL_TIME));
+	}
+
+	return false;
+}
+
+// Picks one histogram out of the reply to the latency command, in us
+static bool parseLatency(const std::string& reply, const char* name, CPerfLatency& latency)
+{
+	std::string::size_type pos = reply.find(std::string(name) + ": count");
+	if (pos == std::string::npos)
+		return false;
+
+	unsigned long long count;
+	double mean, min;
+	return ::sscanf(reply.c_str() + pos + ::strlen(name), ": count %llu, mean %lfus, min %lfus, p50 %lfus, p90 %lfus, p99 %lfus, p99.9 %lfus, max %lfus",
+		&count, &mean, &min, &latency.m_p50, &latency.m_p90, &latency.m_p99, &latency.m_p999, &latency.m_max) == 8;
+}
+
+static void fromHistogram(const CLatencyHistogram& histogram, CPerfLatency& latency)
+{
+	latency.m_p50  = double(histogram.getPercentile(0.5))   / 1000.0;
+	latency.m_p90  = double(histogram.getPercentile(0.9))   / 1000.0;
+	latency.m_p99  = double(histogram.getPercentile(0.99))  / 1000.0;
+	latency.m_p999 = double(histogram.getPercentile(0.999)) / 1000.0;
+	latency.m_max  = double(histogram.getPercentile(1.0))   / 1000.0;
+}
+
+static void jsonLatency(std::string& out, const char* name, const CPerfLatency& latency)
+{
+	char text[200U];
+	::snprintf(text, sizeof(text), "\"%s\":{\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"p99.9\":%.1f,\"max\":%.1f}",
+		name, latency.m_p50, latency.m_p90, latency.m_p99, latency.m_p999, latency.m_max);
+
+	out += text;
+}
+
+// One direction across the gateway, as seen by the simulator at the far end
+static void jsonDirection(std::string& out, const char* name, const CSimStats& sent, const CSimStats& received, double seconds, const CPerfLatency& gateway)
+{
+	CPerfLatency latency;
+	fromHistogram(received.getLatency(), latency);
+
+	char text[300U];
+	::snprintf(text, sizeof(text), "\"%s\":{\"sent\":%llu,\"received\":%llu,\"lost\":%llu,\"duplicated\":%llu,\"reordered\":%llu,\"fps\":%.1f,",
+		name, sent.getSent(), received.getReceived(), received.getLost(), received.getDuplicates(), received.getReordered(), double(received.getReceived()) / seconds);
+
+	out += text;
+	jsonLatency(out, "latency_us", latency);
+	out += ",";
+	jsonLatency(out, "gateway_latency_us", gateway);
+	out += "}";
+}
+
+static bool run(const std::string& gateway, unsigned int streams, unsigned int seconds, const CPerfImpairments* impairments, std::string& out)
+{
+	CSimReflector reflector(REFLECTOR_PORT, REFLECTOR_NAME, streams, FRAMES, "M1NET");
+	CSimRepeater repeater(RPT_PORT, "127.0.0.1", LOCAL_PORT, streams, FRAMES, "M1RF", "ALL");
+	CUDPSocket remote;
+
+	if (impairments != nullptr) {
+		reflector.setImpairments(impairments->m_loss, impairments->m_jitter, impairments->m_reorder, impairments->m_duplicate);
+		reflector.setSeed(17U);
+	}
+
+	if (!reflector.open() || !repeater.open() || !remote.open())
+		return false;
+
+	pid_t pid = startGateway(gateway);
+	if (pid < 0) {
+		::fprintf(stderr, "M17Perf: unable to start %s\n", gateway.c_str());
+		return false;
+	}
+
+	bool ok = false;
+	std::string reply;
+
+	// Wait for the gateway to start, and then link it
+	for (unsigned int i = 0U; i < 20U && !ok; i++)
+		ok = command(remote, "status", reply, reflector, repeater);
+
+	if (ok) {
+		std::string name = std::string("link ") + REFLECTOR_NAME + "_C";
+		ok = command(remote, name.c_str(), reply, reflector, repeater);
+	}
+
+	if (ok) {
+		ok = false;
+		for (unsigned int i = 0U; i < 20U && !ok; i++)
+			ok = command(remote, "status", reply, reflector, repeater) && reply == "m17:conn";
+	}
+
+	if (!ok) {
+		::fprintf(stderr, "M17Perf: the gateway did not link to the reflector\n");
+		::kill(pid, SIGTERM);
+		::waitpid(pid, nullptr, 0);
+		return false;
+	}
+
+	unsigned long long start = CStopWatch::nanoseconds();
+	double cpuStart = cpuTime(pid);
+
+	reflector.start(start);
+	repeater.start(start);
+
+	unsigned long long stop = start + seconds * 1000000000ULL;
+	for (;;) {
+		unsigned long long now = CStopWatch::nanoseconds();
+		if (now >= stop)
+			break;
+
+		reflector.clock(now);
+		repeater.clock(now);
+
+		std::this_thread::sleep_for(std::chrono::microseconds(POLL_TIME));
+	}
+
+	double cpu = cpuTime(pid) - cpuStart;
+
+	reflector.stop();
+	repeater.stop();
+
+	// The frames still on their way, and those held back by the impairments
+	unsigned long long drain = CStopWatch::nanoseconds() + 500000000ULL;
+	while (CStopWatch::nanoseconds() < drain) {
+		unsigned long long now = CStopWatch::nanoseconds();
+		reflector.clock(now);
+		repeater.clock(now);
+
+		std::this_thread::sleep_for(std::chrono::microseconds(POLL_TIME));
+	}
+
+	CPerfLatency rfToNet, netToRf;
+	::memset(&rfToNet, 0x00U, sizeof(CPerfLatency));
+	::memset(&netToRf, 0x00U, sizeof(CPerfLatency));
+	if (command(remote, "latency", reply, reflector, repeater)) {
+		parseLatency(reply, "RF to network", rfToNet);
+		parseLatency(reply, "Network to RF", netToRf);
+	}
+
+	::kill(pid, SIGTERM);
+	::waitpid(pid, nullptr, 0);
+
+	reflector.close();
+	repeater.close();
+	remote.close();
+
+	char text[300U];
+	::snprintf(text, sizeof(text), "{\"streams\":%u,\"seconds\":%u,\"cpu_percent\":%.2f,\"cpu_percent_per_stream\":%.3f,",
+		streams, seconds, cpu * 100.0 / double(seconds), cpu * 100.0 / double(seconds) / double(streams * 2U));
+	out += text;
+
+	if (impairments != nullptr) {
+		::snprintf(text, sizeof(text), "\"impairments\":{\"loss\":%.1f,\"jitter_ms\":%u,\"reorder\":%.1f,\"duplicate\":%.1f,\"dropped\":%llu,\"reordered\":%llu,\"duplicated\":%llu},",
+			impairments->m_loss, impairments->m_jitter, impairments->m_reorder, impairments->m_duplicate, reflector.getDropped(), reflector.getReordered(), reflector.getDuplicated());
+		out += text;
+	}
+
+	jsonDirection(out, "rf_to_net", repeater.getStats(), reflector.getStats(), double(seconds), rfToNet);
+	out += ",";
+	jsonDirection(out, "net_to_rf", reflector.getStats(), repeater.getStats(), double(seconds), netToRf);
+	out += "}";
+
+	::fprintf(stdout, "%-8u %10.1f %10.1f %10.1f %10.2f %8llu\n", streams,
+		double(reflector.getStats().getReceived() + repeater.getStats().getReceived()) / double(seconds),
+		rfToNet.m_p50, netToRf.m_p50, cpu * 100.0 / double(seconds),
+		reflector.getStats().getLost() + repeater.getStats().getLost());
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::string gateway = "./M17Gateway";
+	unsigned int streams = 8U;
+	unsigned int seconds = 5U;
+	bool io = false;
+	std::string label;
+	std::string output = "bench.json";
+
+	for (int i = 1; i < argc; i++) {
+		const char* option = argv[i];
+
+		if (::strcmp(option, "--io") == 0) {
+			io = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			usage();
+			return 1;
+		}
+
+		const char* value = argv[++i];
+
+		if (::strcmp(option, "--gateway") == 0)
+			gateway = value;
+		else if (::strcmp(option, "--streams") == 0)
+			streams = (unsigned int)::atoi(value);
+		else if (::strcmp(option, "--time") == 0)
+			seconds = (unsigned int)::atoi(value);
+		else if (::strcmp(option, "--label") == 0)
+			label = value;
+		else if (::strcmp(option, "--output") == 0)
+			output = value;
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (streams == 0U || seconds == 0U) {
+		usage();
+		return 1;
+	}
+
+	if (!writeConfig(io)) {
+		::fprintf(stderr, "M17Perf: unable to write %s\n", CONFIG_FILE);
+		return 1;
+	}
+
+	// Nothing but warnings and errors
+	::LogInitialise(false, "/tmp", "M17Perf", 0U, 4U, false);
+
+	CUDPSocket::startup();
+
+	std::string out = std::string("{\"version\":\"") + VERSION + "\",\"label\":\"" + label + "\",\"mode\":\"" + (io ? "io thread" : "main loop") + "\",\"runs\":[";
+
+	::fprintf(stdout, "%-8s %10s %10s %10s %10s %8s\n", "Streams", "Frames/s", "RF>Net us", "Net>RF us", "CPU %", "Lost");
+
+	bool ok = true;
+	for (unsigned int n = 1U; n <= streams && ok; n = (n * 2U > streams && n < streams) ? streams : n * 2U) {
+		if (n > 1U)
+			out += ",";
+
+		ok = run(gateway, n, seconds, nullptr, out);
+	}
+
+	out += "],\"impaired\":";
+
+	// A single stream each way through a poor network
+	CPerfImpairments impairments;
+	impairments.m_loss      = 5.0;
+	impairments.m_jitter    = 20U;
+	impairments.m_reorder   = 2.0;
+	impairments.m_duplicate = 2.0;
+
+	if (ok) {
+		::fprintf(stdout, "With %.0f%% loss, %ums jitter, %.0f%% reordered and %.0f%% duplicated\n", impairments.m_loss, impairments.m_jitter, impairments.m_reorder, impairments.m_duplicate);
+		ok = run(gateway, 1U, seconds, &impairments, out);
+	}
+
+	out += "}\n";
+
+	CUDPSocket::shutdown();
+
+	::LogFinalise();
+
+	if (!ok)
+		return 1;
+
+	FILE* fp = ::fopen(output.c_str(), "wt");
+	if (fp == nullptr) {
+		::fprintf(stderr, "M17Perf: unable to write %s\n", output.c_str());
+		return 1;
+	}
+
+	::fputs(out.c_str(), fp);
+	::fclose(fp);
+
+	::fprintf(stdout, "Results written to %s\n", output.c_str());
+
+	return 0;
+}
+#endif
@@ -0,0 +1,784 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Replays a capture written by the gateway through the gateway's own code, in
+// virtual time. The datagrams that came in from the MMDVM hosts and the
+// reflectors are sent to repeaters built from the same .ini file at the times
+// they were recorded, and what the repeaters send out is checked against the
+// outbound datagrams of a golden capture, by default those of the capture
+// being replayed. Nothing waits for the real clock unless asked to, so hours
+// of traffic are replayed in seconds.
+//
+// Only the MMDVM and reflector traffic is captured, so links made by remote
+// commands are not replayed.
+
+#include "CaptureReader.h"
+#include "PacketCapture.h"
+#include "M17Repeater.h"
+#include "ManualClock.h"
+#include "VoiceAssets.h"
+#include "M17Defines.h"
+#include "Reflectors.h"
+#include "StopWatch.h"
+#include "UDPSocket.h"
+#include "Thread.h"
+#include "M17Utils.h"
+#include "Clock.h"
+#include "Conf.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+const char* HOSTS_FILE = "/tmp/M17Replay.hosts";
+
+const unsigned short REFLECTOR_PORT = 47100U;
+
+// The virtual time of the first datagram from the MMDVM or a reflector, far
+// enough from zero for anything sent by the gateway before it
+const unsigned long long CLOCK_BASE = 1000000000000000ULL;
+
+struct CReplayPacket {
+	unsigned long long m_time;		// ns in virtual time
+	unsigned int       m_channel;		// the repeater times two, plus one for its reflector
+	unsigned int       m_length;
+	unsigned char      m_data[CAPTURE_DATA_LENGTH];
+};
+
+struct CReplayGateway {
+	std::vector<CRepeaterConf>              m_confs;
+	std::vector<CM17Repeater*>              m_repeaters;
+	std::vector<CUDPSocket*>                m_mmdvms;
+	std::vector<sockaddr_storage>           m_locals;
+	std::vector<sockaddr_storage>           m_peers;
+	std::vector<bool>                       m_linked;
+	std::map<unsigned short, unsigned int>  m_ports;
+	unsigned int                            m_addrLen;
+	CUDPSocket*                             m_reflector;
+	CReflectors*                            m_reflectors;
+	CManualClock*                           m_clock;
+	unsigned long long                      m_origin;
+	CStopWatch                              m_stopWatch;
+	std::vector<std::vector<CReplayPacket>> m_output;
+};
+
+static void usage()
+{
+	::fprintf(stderr, "Usage: M17Replay [options] <ini file> <capture>\n"
+		"  --golden <capture>     what the gateway should send, from the capture being replayed by default\n"
+		"  --output <directory>   write a capture of the replay, to use as a golden capture later\n"
+		"  --speed <n>            1 for real time, 10 for ten times as fast, 0 for as fast as possible (0)\n"
+		"  --step <ms>            the time between passes of the gateway, as in its main loop (5)\n"
+		"  --skew <ms>            fail when a datagram is sent this much earlier or later, 0 to not check (0)\n"
+		"  --idle <seconds>       run on this long after the capture, for the hang timer, relinks and reloads (0)\n"
+		"  --port <port>          the port of the stand in for the reflectors (47100)\n"
+		"  --pings                compare the gateway's pings to the MMDVM, which depend on when it started\n"
+		"  --verbose              show the gateway's messages\n");
+}
+
+// The repeater that a CONN came from
+static int findConnect(const std::vector<CRepeaterConf>& confs, const unsigned char* data, unsigned int length)
+{
+	if (length < 10U || ::memcmp(data, "CONN", 4U) != 0)
+		return -1;
+
+	for (unsigned int i = 0U; i < confs.size(); i++) {
+		std::string call = confs.at(i).m_callsign;
+		call.resize(M17_CALLSIGN_LENGTH - 1U, ' ');
+		call += confs.at(i).m_suffix.substr(0U, 1U);
+
+		unsigned char encoded[6U];
+		CM17Utils::encodeCallsign(call, encoded);
+
+		if (::memcmp(data + 4U, encoded, 6U) == 0)
+			return int(i);
+	}
+
+	return -1;
+}
+
+// The network ports are usually chosen by the system each time a repeater
+// links, so they are learned from the CONN that each one sends first
+static int findChannel(const std::vector<CRepeaterConf>& confs, std::map<unsigned short, unsigned int>& ports, unsigned short port, bool outbound, const unsigned char* data, unsigned int length)
+{
+	for (unsigned int i = 0U; i < confs.size(); i++) {
+		if (confs.at(i).m_localPort == port)
+			return int(i * 2U);
+	}
+
+	if (outbound) {
+		int repeater = findConnect(confs, data, length);
+		if (repeater >= 0)
+			ports[port] = (unsigned int)repeater;
+	}
+
+	std::map<unsigned short, unsigned int>::const_iterator it = ports.find(port);
+	if (it != ports.cend())
+		return int(it->second * 2U + 1U);
+
+	// With only one repeater it can't be anything else
+	if (confs.size() == 1U)
+		return 1;
+
+	return -1;
+}
+
+static void setPorts(const std::vector<CRepeaterConf>& confs, std::map<unsigned short, unsigned int>& ports)
+{
+	for (unsigned int i = 0U; i < confs.size(); i++) {
+		if (confs.at(i).m_networkPort > 0U)
+			ports[confs.at(i).m_networkPort] = i;
+	}
+}
+
+static std::string describe(const std::vector<CRepeaterConf>& confs, unsigned int channel)
+{
+	const CRepeaterConf& conf = confs.at(channel / 2U);
+
+	std::string text = conf.m_callsign + " " + conf.m_suffix;
+	text += ((channel % 2U) == 0U) ? " to the MMDVM" : " to the reflector";
+
+	return text;
+}
+
+static bool isEarlier(const CReplayPacket& a, const CReplayPacket& b)
+{
+	return a.m_time < b.m_time;
+}
+
+// One direction of a capture, with the times of its first packet and of its first inbound packet
+static bool load(const std::string& file, const std::vector<CRepeaterConf>& confs, CAPTURE_DIRECTION direction, std::vector<CReplayPacket>& packets, unsigned long long& start, unsigned long long& first)
+{
+	CCaptureReader reader;
+	if (!reader.open(file))
+		return false;
+
+	std::map<unsigned short, unsigned int> ports;
+	setPorts(confs, ports);
+
+	start = first = 0ULL;
+
+	unsigned int count   = 0U;
+	unsigned int unknown = 0U;
+
+	CCapturedPacket packet;
+	while (reader.read(packet)) {
+		if (count++ == 0U)
+			start = packet.m_timestamp;
+
+		if (packet.m_direction == CAPTURE_DIRECTION::INBOUND && (first == 0ULL || packet.m_timestamp < first))
+			first = packet.m_timestamp;
+
+		int channel = findChannel(confs, ports, packet.m_localPort, packet.m_direction == CAPTURE_DIRECTION::OUTBOUND, packet.m_data, packet.m_length);
+
+		if (packet.m_direction != direction)
+			continue;
+
+		if (channel < 0) {
+			unknown++;
+			continue;
+		}
+
+		CReplayPacket replay;
+		replay.m_time    = packet.m_timestamp;
+		replay.m_channel = (unsigned int)channel;
+		replay.m_length  = packet.m_length;
+		::memcpy(replay.m_data, packet.m_data, packet.m_length);
+
+		packets.push_back(replay);
+	}
+
+	reader.close();
+
+	if (count == 0U) {
+		LogError("%s holds no packets", file.c_str());
+		return false;
+	}
+
+	if (unknown > 0U)
+		LogWarning("%u packets in %s are for ports that aren't in the .ini file", unknown, file.c_str());
+
+	if (first == 0ULL)
+		first = start;
+
+	// The capture is written in the order the packets were queued, which isn't quite the order of their times
+	std::stable_sort(packets.begin(), packets.end(), isEarlier);
+
+	return true;
+}
+
+static void addName(std::set<std::string>& names, const std::string& text)
+{
+	std::string name = text.substr(0U, M17_CALLSIGN_LENGTH - 2U);
+
+	size_t pos = name.find_last_not_of(' ');
+	if (pos == std::string::npos)
+		return;
+	name.resize(pos + 1U);
+
+	if (name.find_first_of(" \t#") == std::string::npos)
+		names.insert(name);
+}
+
+static void addNames(std::set<std::string>& names, const std::string& file)
+{
+	FILE* fp = ::fopen(file.c_str(), "rt");
+	if (fp == nullptr)
+		return;
+
+	char buffer[100U];
+	while (::fgets(buffer, 100U, fp) != nullptr) {
+		if (buffer[0U] == '#')
+			continue;
+
+		char* p = ::strtok(buffer, " \t\r\n");
+		if (p != nullptr)
+			addName(names, p);
+	}
+
+	::fclose(fp);
+}
+
+// Every reflector that the gateway might look up is the stand in, whatever the
+// hosts files say. Anything the MMDVM sent to is included, so that the replay
+// doesn't need the hosts files of the machine the capture was made on.
+static bool writeHosts(const CConf& conf, const std::vector<CRepeaterConf>& confs, const std::vector<CReplayPacket>& inbound, unsigned short port)
+{
+	std::set<std::string> names;
+
+	addNames(names, conf.getNetworkHosts1());
+	addNames(names, conf.getNetworkHosts2());
+
+	for (std::vector<CRepeaterConf>::const_iterator it = confs.cbegin(); it != confs.cend(); ++it) {
+		if (!it->m_startup.empty())
+			addName(names, it->m_startup);
+	}
+
+	for (std::vector<CReplayPacket>::const_iterator it = inbound.cbegin(); it != inbound.cend(); ++it) {
+		if ((it->m_channel % 2U) == 0U && it->m_length == M17_NETWORK_FRAME_LENGTH && ::memcmp(it->m_data, "M17 ", 4U) == 0) {
+			char dest[M17_CALLSIGN_LENGTH + 2U];
+			CM17Utils::decodeCallsign(it->m_data + 6U, dest);
+			addName(names, dest);
+		}
+	}
+
+	FILE* fp = ::fopen(HOSTS_FILE, "wt");
+	if (fp == nullptr)
+		return false;
+
+	for (std::set<std::string>::const_iterator it = names.cbegin(); it != names.cend(); ++it)
+		::fprintf(fp, "%s 127.0.0.1 %u\n", it->c_str(), port);
+
+	::fclose(fp);
+
+	return true;
+}
+
+static unsigned short getPort(const sockaddr_storage& addr)
+{
+	if (addr.ss_family == AF_INET6)
+		return ntohs(((const sockaddr_in6*)&addr)->sin6_port);
+	else
+		return ntohs(((const sockaddr_in*)&addr)->sin_port);
+}
+
+static void store(CReplayGateway& gateway, unsigned int channel, const unsigned char* data, unsigned int length)
+{
+	CReplayPacket packet;
+	packet.m_time    = gateway.m_clock->nanoseconds();
+	packet.m_channel = channel;
+	packet.m_length  = length;
+	::memcpy(packet.m_data, data, length);
+
+	gateway.m_output.at(channel).push_back(packet);
+}
+
+// Everything the gateway has sent since the last time
+static void collect(CReplayGateway& gateway)
+{
+	unsigned char buffer[CAPTURE_DATA_LENGTH];
+	sockaddr_storage addr;
+	unsigned int addrLen;
+	int length;
+
+	for (unsigned int i = 0U; i < gateway.m_mmdvms.size(); i++) {
+		while ((length = gateway.m_mmdvms.at(i)->read(buffer, CAPTURE_DATA_LENGTH, addr, addrLen)) > 0)
+			store(gateway, i * 2U, buffer, (unsigned int)length);
+	}
+
+	// The repeater is known by the port that it sends from, which is where the reflector replies to
+	while ((length = gateway.m_reflector->read(buffer, CAPTURE_DATA_LENGTH, addr, addrLen)) > 0) {
+		unsigned short port = getPort(addr);
+
+		int channel = findChannel(gateway.m_confs, gateway.m_ports, port, true, buffer, (unsigned int)length);
+		if (channel < 0 || (channel % 2) == 0) {
+			LogWarning("Received a datagram from unknown port %u", port);
+			continue;
+		}
+
+		gateway.m_peers.at(channel / 2) = addr;
+		gateway.m_linked.at(channel / 2) = true;
+
+		store(gateway, (unsigned int)channel, buffer, (unsigned int)length);
+	}
+}
+
+// As in the main loop of the gateway, true if any of the repeaters had frames to handle
+static bool pass(CReplayGateway& gateway)
+{
+	bool busy = false;
+
+	for (std::vector<CM17Repeater*>::const_iterator it = gateway.m_repeaters.cbegin(); it != gateway.m_repeaters.cend(); ++it) {
+		if ((*it)->process())
+			busy = true;
+	}
+
+	unsigned int ms = gateway.m_stopWatch.elapsed();
+	gateway.m_stopWatch.start();
+
+	gateway.m_reflectors->clock(ms);
+
+	for (std::vector<CM17Repeater*>::const_iterator it = gateway.m_repeaters.cbegin(); it != gateway.m_repeaters.cend(); ++it)
+		(*it)->clock(ms);
+
+	collect(gateway);
+
+	return busy;
+}
+
+static void send(CReplayGateway& gateway, const CReplayPacket& packet)
+{
+	unsigned int repeater = packet.m_channel / 2U;
+
+	if ((packet.m_channel % 2U) == 0U) {
+		gateway.m_mmdvms.at(repeater)->write(packet.m_data, packet.m_length, gateway.m_locals.at(repeater), gateway.m_addrLen);
+	} else if (gateway.m_linked.at(repeater)) {
+		gateway.m_reflector->write(packet.m_data, packet.m_length, gateway.m_peers.at(repeater), gateway.m_addrLen);
+	} else {
+		LogWarning("Dropped a datagram from the reflector at %.3fs, the gateway hasn't linked", double(packet.m_time - gateway.m_origin) / 1.0E9);
+		return;
+	}
+
+	// The datagram is read by one pass and handled by the next, with no time
+	// passing, and so on for whatever that sets off
+	pass(gateway);
+	while (pass(gateway))
+		;
+}
+
+// The gateway's own pings to the MMDVM are timed from its start, not from the traffic
+static bool isCompared(const CReplayPacket& packet, bool pings)
+{
+	if (!pings && (packet.m_channel % 2U) == 0U && packet.m_length >= 4U && ::memcmp(packet.m_data, "PING", 4U) == 0)
+		return false;
+
+	return true;
+}
+
+static bool matches(const CReplayPacket& expected, const CReplayPacket& actual, std::map<uint16_t, uint16_t>& ids)
+{
+	if (expected.m_length != actual.m_length)
+		return false;
+
+	if (expected.m_length != M17_NETWORK_FRAME_LENGTH || ::memcmp(expected.m_data, "M17 ", 4U) != 0)
+		return ::memcmp(expected.m_data, actual.m_data, expected.m_length) == 0;
+
+	if (::memcmp(actual.m_data, "M17 ", 4U) != 0)
+		return false;
+
+	// The gateway makes up the stream ids of its announcements, so the ids only have to correspond
+	uint16_t expectedId = (expected.m_data[4U] << 8) | expected.m_data[5U];
+	uint16_t actualId   = (actual.m_data[4U] << 8) | actual.m_data[5U];
+
+	std::map<uint16_t, uint16_t>::const_iterator it = ids.find(expectedId);
+	if (it == ids.cend())
+		ids[expectedId] = actualId;
+	else if (it->second != actualId)
+		return false;
+
+	// The CRC covers the stream id
+	unsigned int length = (expectedId == actualId) ? M17_NETWORK_FRAME_LENGTH : M17_NETWORK_FRAME_LENGTH - M17_CRC_LENGTH_BYTES;
+
+	return ::memcmp(expected.m_data + 6U, actual.m_data + 6U, length - 6U) == 0;
+}
+
+static void printPacket(const char* title, const CReplayPacket& packet, unsigned long long origin)
+{
+	::fprintf(stdout, "    %-9s at %.3fs:", title, double((long long)(packet.m_time - origin)) / 1.0E9);
+	for (unsigned int i = 0U; i < packet.m_length; i++)
+		::fprintf(stdout, " %02X", packet.m_data[i]);
+	::fprintf(stdout, "\n");
+}
+
+static bool compare(const std::vector<CRepeaterConf>& confs, unsigned int channel, const std::vector<CReplayPacket>& golden, const std::vector<CReplayPacket>& output, unsigned long long origin, bool pings, unsigned long long skew)
+{
+	std::vector<const CReplayPacket*> expected;
+	for (std::vector<CReplayPacket>::const_iterator it = golden.cbegin(); it != golden.cend(); ++it) {
+		if (isCompared(*it, pings))
+			expected.push_back(&(*it));
+	}
+
+	std::vector<const CReplayPacket*> actual;
+	for (std::vector<CReplayPacket>::const_iterator it = output.cbegin(); it != output.cend(); ++it) {
+		if (isCompared(*it, pings))
+			actual.push_back(&(*it));
+	}
+
+	std::string name = describe(confs, channel);
+
+	std::map<uint16_t, uint16_t> ids;
+	unsigned long long maxSkew = 0ULL;
+
+	size_t count = std::min(expected.size(), actual.size());
+	for (size_t i = 0U; i < count; i++) {
+		if (!matches(*expected.at(i), *actual.at(i), ids)) {
+			::fprintf(stdout, "%-32s differs at datagram %u of %u\n", name.c_str(), (unsigned int)(i + 1U), (unsigned int)expected.size());
+			printPacket("Expected", *expected.at(i), origin);
+			printPacket("Sent", *actual.at(i), origin);
+			return false;
+		}
+
+		unsigned long long t1 = expected.at(i)->m_time;
+		unsigned long long t2 = actual.at(i)->m_time;
+		unsigned long long diff = (t1 > t2) ? t1 - t2 : t2 - t1;
+		if (diff > maxSkew)
+			maxSkew = diff;
+
+		if (skew > 0ULL && diff > skew) {
+			::fprintf(stdout, "%-32s datagram %u of %u was sent %.1fms %s\n", name.c_str(), (unsigned int)(i + 1U), (unsigned int)expected.size(), double(diff) / 1.0E6, (t2 > t1) ? "late" : "early");
+			printPacket("Expected", *expected.at(i), origin);
+			printPacket("Sent", *actual.at(i), origin);
+			return false;
+		}
+	}
+
+	if (expected.size() != actual.size()) {
+		::fprintf(stdout, "%-32s expected %u datagrams, %u were sent\n", name.c_str(), (unsigned int)expected.size(), (unsigned int)actual.size());
+		if (expected.size() > count)
+			printPacket("Missing", *expected.at(count), origin);
+		else
+			printPacket("Extra", *actual.at(count), origin);
+		return false;
+	}
+
+	::fprintf(stdout, "%-32s %u datagrams match, within %.1fms\n", name.c_str(), (unsigned int)count, double(maxSkew) / 1.0E6);
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	std::string golden;
+	std::string output;
+	double speed = 0.0;
+	unsigned int step = 5U;
+	unsigned int skew = 0U;
+	unsigned int idle = 0U;
+	unsigned short port = REFLECTOR_PORT;
+	bool pings = false;
+	bool verbose = false;
+
+	std::vector<std::string> files;
+
+	for (int i = 1; i < argc; i++) {
+		const char* option = argv[i];
+
+		if (::strcmp(option, "--pings") == 0) {
+			pings = true;
+			continue;
+		} else if (::strcmp(option, "--verbose") == 0) {
+			verbose = true;
+			continue;
+		} else if (::strncmp(option, "--", 2U) != 0) {
+			files.push_back(option);
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			usage();
+			return 1;
+		}
+
+		const char* value = argv[++i];
+
+		if (::strcmp(option, "--golden") == 0)
+			golden = value;
+		else if (::strcmp(option, "--output") == 0)
+			output = value;
+		else if (::strcmp(option, "--speed") == 0)
+			speed = ::atof(value);
+		else if (::strcmp(option, "--step") == 0)
+			step = (unsigned int)::atoi(value);
+		else if (::strcmp(option, "--skew") == 0)
+			skew = (unsigned int)::atoi(value);
+		else if (::strcmp(option, "--idle") == 0)
+			idle = (unsigned int)::atoi(value);
+		else if (::strcmp(option, "--port") == 0)
+			port = (unsigned short)::atoi(value);
+		else {
+			usage();
+			return 1;
+		}
+	}
+
+	if (files.size() != 2U || step == 0U || step > 1000U || speed < 0.0 || port == 0U) {
+		usage();
+		return 1;
+	}
+
+	if (golden.empty())
+		golden = files.at(1U);
+
+	CConf conf(files.at(0U));
+	if (!conf.read()) {
+		::fprintf(stderr, "M17Replay: cannot read the .ini file\n");
+		return 1;
+	}
+
+	::LogInitialise(false, "/tmp", "M17Replay", 0U, verbose ? 2U : 4U, false);
+
+	CReplayGateway gateway;
+	gateway.m_confs = conf.getRepeaters();
+	gateway.m_confs.insert(gateway.m_confs.begin(), conf.getRepeater());
+
+	unsigned long long start, first;
+	std::vector<CReplayPacket> inbound;
+	if (!load(files.at(1U), gateway.m_confs, CAPTURE_DIRECTION::INBOUND, inbound, start, first))
+		return 1;
+
+	unsigned long long goldenStart, goldenFirst;
+	std::vector<CReplayPacket> expected;
+	if (!load(golden, gateway.m_confs, CAPTURE_DIRECTION::OUTBOUND, expected, goldenStart, goldenFirst))
+		return 1;
+
+	// Both captures are lined up on their first inbound datagram, which is the
+	// same in a capture of the replay. Putting it at the same virtual time on
+	// every run means that the times are rounded to milliseconds in the same
+	// way, and so the replay is repeatable.
+	for (std::vector<CReplayPacket>::iterator it = inbound.begin(); it != inbound.end(); ++it)
+		it->m_time = CLOCK_BASE + (it->m_time - first);
+
+	for (std::vector<CReplayPacket>::iterator it = expected.begin(); it != expected.end(); ++it)
+		it->m_time = CLOCK_BASE + it->m_time - goldenFirst;
+
+	unsigned long long lead = (first > start) ? std::min(first - start, CLOCK_BASE) : 0ULL;
+
+	if (!writeHosts(conf, gateway.m_confs, inbound, port)) {
+		::fprintf(stderr, "M17Replay: unable to write %s\n", HOSTS_FILE);
+		return 1;
+	}
+
+	CUDPSocket::startup();
+
+	// Everything from here on runs in virtual time, from the start of the capture
+	CManualClock clock(CLOCK_BASE - lead);
+	clock.setDriver();
+	CClock::set(&clock);
+
+	gateway.m_clock  = &clock;
+	gateway.m_origin = clock.nanoseconds();
+	gateway.m_stopWatch.start();
+
+	gateway.m_reflectors = new CReflectors(HOSTS_FILE, "", conf.getNetworkReloadTime());
+	gateway.m_reflectors->load();
+
+	CVoiceAssets* assets = nullptr;
+	if (conf.getVoiceEnabled()) {
+		assets = new CVoiceAssets(conf.getVoiceDirectory(), conf.getVoiceLanguage());
+		if (!assets->open()) {
+			delete assets;
+			assets = nullptr;
+		}
+	}
+
+	CPacketCapture* capture = nullptr;
+	if (!output.empty()) {
+		capture = new CPacketCapture(output, "M17Replay", 0U, 0U);
+		if (!capture->open(false)) {
+			delete capture;
+			return 1;
+		}
+	}
+
+	gateway.m_reflector = new CUDPSocket(port);
+
+	bool named = gateway.m_confs.size() > 1U;
+
+	bool ok = true;
+	for (std::vector<CRepeaterConf>::iterator it = gateway.m_confs.begin(); it != gateway.m_confs.end() && ok; ++it) {
+		// The MMDVM is this tool, and the remote commands weren't captured
+		it->m_rptAddress = "127.0.0.1";
+		it->m_remotePort = 0U;
+
+		sockaddr_storage local, network;
+		if (CUDPSocket::lookup(it->m_rptAddress, it->m_localPort, local, gateway.m_addrLen) != 0 ||
+			CUDPSocket::lookup(it->m_rptAddress, it->m_networkPort, network, gateway.m_addrLen) != 0) {
+			ok = false;
+			break;
+		}
+
+		gateway.m_locals.push_back(local);
+		gateway.m_peers.push_back(network);
+		gateway.m_linked.push_back(it->m_networkPort > 0U);
+
+		if (it == gateway.m_confs.begin() && !gateway.m_reflector->open(local)) {
+			LogError("Unable to open port %u for the reflectors", port);
+			ok = false;
+			break;
+		}
+
+		CUDPSocket* mmdvm = new CUDPSocket(it->m_rptPort);
+		gateway.m_mmdvms.push_back(mmdvm);
+		if (!mmdvm->open(local)) {
+			LogError("Unable to open port %u for the MMDVM", it->m_rptPort);
+			ok = false;
+			break;
+		}
+
+		std::string name = named ? it->m_callsign + " " + it->m_suffix : std::string();
+
+		CM17Repeater* repeater = new CM17Repeater(*it, name, *gateway.m_reflectors, nullptr, false, false);
+		if (!repeater->open()) {
+			LogError("Unable to open the repeater in the [%s] section", it->m_name.c_str());
+			delete repeater;
+			ok = false;
+			break;
+		}
+
+		repeater->setVoice(assets);
+		repeater->setCapture(capture);
+
+		gateway.m_repeaters.push_back(repeater);
+	}
+
+	gateway.m_output.resize(gateway.m_confs.size() * 2U);
+	setPorts(gateway.m_confs, gateway.m_ports);
+
+	unsigned long long last = gateway.m_origin;
+	if (!inbound.empty())
+		last = inbound.back().m_time;
+
+	// Until the last datagram either way, which is usually the unlink as the
+	// gateway stopped, or until the idle time after the last one in is up
+	unsigned long long end = last;
+	if (idle > 0U)
+		end += idle * 1000000000ULL;
+	else if (!expected.empty())
+		end = std::max(end, expected.back().m_time);
+
+	unsigned long long stepNS = step * 1000000ULL;
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	if (ok) {
+		for (std::vector<CM17Repeater*>::const_iterator it = gateway.m_repeaters.cbegin(); it != gateway.m_repeaters.cend(); ++it)
+			(*it)->start();
+
+		// The passes fall on a grid from the first inbound datagram, however the capture starts
+		unsigned long long phase = CLOCK_BASE % stepNS;
+
+		unsigned long long now = clock.nanoseconds();
+		size_t next = 0U;
+
+		for (;;) {
+			while (next < inbound.size() && inbound.at(next).m_time <= now)
+				send(gateway, inbound.at(next++));
+
+			if (now >= end)
+				break;
+
+			if (next >= inbound.size() && speed == 0.0 && (end - now) >= stepNS && ((now - phase) % stepNS) == 0U) {
+				// Only the timers are left, so this is the main loop sleeping between passes
+				CThread::sleep(step);
+				now = clock.nanoseconds();
+			} else {
+				unsigned long long target = now - ((now - phase) % stepNS) + stepNS;
+				if (next < inbound.size())
+					target = std::min(target, inbound.at(next).m_time);
+				target = std::min(target, end);
+
+				clock.set(target);
+				now = target;
+			}
+
+			if (speed > 0.0)
+				std::this_thread::sleep_until(begin + std::chrono::nanoseconds((unsigned long long)(double(now - gateway.m_origin) / speed)));
+
+			pass(gateway);
+		}
+	}
+
+	// Closing unlinks from the reflectors
+	for (std::vector<CM17Repeater*>::const_iterator it = gateway.m_repeaters.cbegin(); it != gateway.m_repeaters.cend(); ++it)
+		(*it)->close();
+
+	if (ok)
+		collect(gateway);
+
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	for (std::vector<CM17Repeater*>::const_iterator it = gateway.m_repeaters.cbegin(); it != gateway.m_repeaters.cend(); ++it)
+		delete *it;
+
+	for (std::vector<CUDPSocket*>::const_iterator it = gateway.m_mmdvms.cbegin(); it != gateway.m_mmdvms.cend(); ++it) {
+		(*it)->close();
+		delete *it;
+	}
+
+	gateway.m_reflector->close();
+	delete gateway.m_reflector;
+
+	if (capture != nullptr) {
+		capture->close();
+		delete capture;
+	}
+
+	delete assets;
+	delete gateway.m_reflectors;
+
+	CClock::set(nullptr);
+
+	if (ok) {
+		::fprintf(stdout, "Replayed %u datagrams, %.1fs of traffic in %.2fs\n", (unsigned int)inbound.size(), double(end - gateway.m_origin) / 1.0E9, elapsed);
+
+		std::vector<std::vector<CReplayPacket>> goldens(gateway.m_output.size());
+		for (std::vector<CReplayPacket>::const_iterator it = expected.cbegin(); it != expected.cend(); ++it)
+			goldens.at(it->m_channel).push_back(*it);
+
+		for (unsigned int i = 0U; i < gateway.m_output.size(); i++) {
+			if (!compare(gateway.m_confs, i, goldens.at(i), gateway.m_output.at(i), gateway.m_origin, pings, skew * 1000000ULL))
+				ok = false;
+		}
+
+		::fprintf(stdout, "%s\n", ok ? "Passed" : "FAILED");
+	}
+
+	CUDPSocket::shutdown();
+
+	::LogFinalise();
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "SimFrame.h"
+#include "M17Defines.h"
+#include "M17LSF.h"
+
+#include <cassert>
+#include <cstring>
+
+const unsigned char SIM_MARKER[] = { 'S', 'I', 'M', '1' };
+
+void CSimFrame::build(unsigned char* frame, uint16_t id, uint16_t fn, bool end, const unsigned char* source, const unsigned char* dest)
+{
+	assert(frame != nullptr);
+	assert(source != nullptr);
+	assert(dest != nullptr);
+
+	::memset(frame, 0x00U, M17_NETWORK_FRAME_LENGTH);
+
+	frame[0U] = 'M';
+	frame[1U] = '1';
+	frame[2U] = '7';
+	frame[3U] = ' ';
+
+	frame[4U] = id >> 8;
+	frame[5U] = id >> 0;
+
+	CM17LSF lsf;
+	lsf.setPacketStream(M17_STREAM_TYPE);
+	lsf.setDataType(M17_DATA_TYPE_VOICE);
+	lsf.setEncryptionType(M17_ENCRYPTION_TYPE_NONE);
+	lsf.setEncryptionSubType(M17_ENCRYPTION_SUB_TYPE_TEXT);
+	lsf.setCAN(0U);
+	lsf.getNetwork(frame + 6U);
+
+	::memcpy(frame + 6U, dest, 6U);
+	::memcpy(frame + 12U, source, 6U);
+
+	fn &= 0x7FFFU;
+	if (end)
+		fn |= 0x8000U;
+
+	frame[34U] = fn >> 8;
+	frame[35U] = fn >> 0;
+
+	::memcpy(frame + 44U, SIM_MARKER, 4U);
+}
+
+void CSimFrame::stamp(unsigned char* frame, unsigned long long ns)
+{
+	assert(frame != nullptr);
+
+	for (unsigned int i = 0U; i < 8U; i++)
+		frame[36U + i] = (unsigned char)(ns >> (56U - i * 8U));
+}
+
+bool CSimFrame::read(const unsigned char* frame, unsigned int length, uint16_t& id, uint16_t& fn, bool& end, unsigned long long& ns)
+{
+	assert(frame != nullptr);
+
+	if (length != M17_NETWORK_FRAME_LENGTH)
+		return false;
+
+	if (::memcmp(frame + 0U, "M17 ", 4U) != 0 || ::memcmp(frame + 44U, SIM_MARKER, 4U) != 0)
+		return false;
+
+	id = (frame[4U] << 8) + (frame[5U] << 0);
+
+	uint16_t value = (frame[34U] << 8) + (frame[35U] << 0);
+	fn  = value & 0x7FFFU;
+	end = (value & 0x8000U) == 0x8000U;
+
+	ns = 0ULL;
+	for (unsigned int i = 0U; i < 8U; i++)
+		ns = (ns << 8) | frame[36U + i];
+
+	return true;
+}
@@ -0,0 +1,41 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(SimFrame_H)
+#define	SimFrame_H
+
+#include <cstdint>
+
+// The frames sent by the simulators. They are ordinary M17 voice stream frames,
+// but the first twelve bytes of the payload carry the time the frame was sent
+// and a marker, so that the other simulator can measure the time it took to
+// cross the gateway. Both simulators must run on the same machine for the
+// times to be comparable.
+class CSimFrame {
+public:
+	// The callsigns are encoded, the time is from CStopWatch::nanoseconds()
+	static void build(unsigned char* frame, uint16_t id, uint16_t fn, bool end, const unsigned char* source, const unsigned char* dest);
+
+	// Sets the time sent just before the frame is written
+	static void stamp(unsigned char* frame, unsigned long long ns);
+
+	// False if this isn't a frame from a simulator
+	static bool read(const unsigned char* frame, unsigned int length, uint16_t& id, uint16_t& fn, bool& end, unsigned long long& ns);
+};
+
+#endif
@@ -0,0 +1,334 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "SimReflector.h"
+#include "StopWatch.h"
+#include "SimFrame.h"
+#include "M17Utils.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cstring>
+
+const unsigned long long PING_TIME    = 3000000000ULL;
+const unsigned long long TIMEOUT_TIME = 30000000000ULL;
+
+// How much later a reordered frame is sent, it lets the next two frames of its stream go first
+const unsigned long long REORDER_TIME = 80000000ULL;
+
+CSimReflector::CSimReflector(unsigned short port, const std::string& name, unsigned int streams, unsigned int frames, const std::string& source) :
+m_port(port),
+m_name(name),
+m_encoded(),
+m_nack(false),
+m_socket(port),
+m_sender(streams, frames, source, name),
+m_stats("RF to network"),
+m_replay(false),
+m_sending(false),
+m_clients(),
+m_pending(),
+m_random(),
+m_loss(0.0),
+m_jitter(0U),
+m_reorder(0.0),
+m_duplicate(0.0),
+m_ping(0ULL),
+m_dropped(0ULL),
+m_reordered(0ULL),
+m_duplicated(0ULL)
+{
+	CM17Utils::encodeCallsign(name, m_encoded);
+
+	std::random_device rd;
+	m_random.seed(rd());
+}
+
+CSimReflector::~CSimReflector()
+{
+}
+
+void CSimReflector::setNACK(bool nack)
+{
+	m_nack = nack;
+}
+
+void CSimReflector::setImpairments(double loss, unsigned int jitter, double reorder, double duplicate)
+{
+	m_loss      = loss;
+	m_jitter    = jitter;
+	m_reorder   = reorder;
+	m_duplicate = duplicate;
+}
+
+void CSimReflector::setSeed(unsigned int seed)
+{
+	m_random.seed(seed);
+}
+
+bool CSimReflector::replay(const std::string& file)
+{
+	m_replay = m_sender.replay(file, FLIGHT_DIRECTION::NET_IN);
+
+	return m_replay;
+}
+
+bool CSimReflector::open()
+{
+	if (!m_socket.open()) {
+		LogError("Unable to open port %u for the reflector", m_port);
+		return false;
+	}
+
+	LogMessage("Reflector %s on port %u", m_name.c_str(), m_port);
+
+	return true;
+}
+
+void CSimReflector::start(unsigned long long now)
+{
+	m_sender.start(now);
+	m_sending = true;
+}
+
+void CSimReflector::stop()
+{
+	m_sending = false;
+}
+
+void CSimReflector::clock(unsigned long long now)
+{
+	unsigned char buffer[200U];
+	sockaddr_storage addr;
+	unsigned int addrLen;
+	int length;
+	while ((length = m_socket.read(buffer, 200U, addr, addrLen)) > 0)
+		read(buffer, (unsigned int)length, addr, addrLen, CStopWatch::nanoseconds());
+
+	if (m_sending) {
+		unsigned char frame[M17_NETWORK_FRAME_LENGTH];
+		while (m_sender.read(frame, now)) {
+			for (std::vector<CSimClient>::const_iterator it = m_clients.cbegin(); it != m_clients.cend(); ++it) {
+				// A replayed frame keeps its recorded destination
+				if (!m_replay)
+					::memcpy(frame + 6U, it->m_dest, 6U);
+
+				send(*it, frame, now);
+			}
+		}
+	}
+
+	flush(now);
+
+	if (now >= m_ping) {
+		for (std::vector<CSimClient>::iterator it = m_clients.begin(); it != m_clients.end();) {
+			if ((now - it->m_heard) >= TIMEOUT_TIME) {
+				LogMessage("%s timed out", it->m_callsign);
+				it = m_clients.erase(it);
+			} else {
+				write("PING", true, it->m_addr, it->m_addrLen);
+				++it;
+			}
+		}
+
+		m_ping = now + PING_TIME;
+	}
+}
+
+unsigned int CSimReflector::getLinks() const
+{
+	return (unsigned int)m_clients.size();
+}
+
+bool CSimReflector::isFinished() const
+{
+	return m_sender.isFinished();
+}
+
+const CSimStats& CSimReflector::getStats() const
+{
+	return m_stats;
+}
+
+unsigned long long CSimReflector::getDropped() const
+{
+	return m_dropped;
+}
+
+unsigned long long CSimReflector::getReordered() const
+{
+	return m_reordered;
+}
+
+unsigned long long CSimReflector::getDuplicated() const
+{
+	return m_duplicated;
+}
+
+void CSimReflector::close()
+{
+	for (std::vector<CSimClient>::const_iterator it = m_clients.cbegin(); it != m_clients.cend(); ++it)
+		write("DISC", false, it->m_addr, it->m_addrLen);
+
+	m_clients.clear();
+	m_pending.clear();
+
+	m_socket.close();
+}
+
+void CSimReflector::read(const unsigned char* buffer, unsigned int length, const sockaddr_storage& addr, unsigned int addrLen, unsigned long long now)
+{
+	assert(buffer != nullptr);
+
+	std::vector<CSimClient>::iterator client = find(addr);
+
+	if (length == 11U && ::memcmp(buffer, "CONN", 4U) == 0) {
+		char module = buffer[10U];
+		if (m_nack || module < 'A' || module > 'Z') {
+			write("NACK", false, addr, addrLen);
+			return;
+		}
+
+		if (client == m_clients.end()) {
+			CSimClient newClient;
+			newClient.m_addr    = addr;
+			newClient.m_addrLen = addrLen;
+
+			client = m_clients.insert(m_clients.end(), newClient);
+		}
+
+		CM17Utils::decodeCallsign(buffer + 4U, client->m_callsign);
+		client->m_module = module;
+		client->m_heard  = now;
+
+		// The frames sent to the link are addressed to its module
+		std::string dest = m_name;
+		dest.resize(M17_CALLSIGN_LENGTH - 1U, ' ');
+		dest += module;
+		CM17Utils::encodeCallsign(dest, client->m_dest);
+
+		LogMessage("%s linked to module %c", client->m_callsign, module);
+
+		write("ACKN", false, addr, addrLen);
+		return;
+	}
+
+	if (client == m_clients.end())
+		return;
+
+	client->m_heard = now;
+
+	if (length >= 4U && ::memcmp(buffer, "DISC", 4U) == 0) {
+		LogMessage("%s unlinked", client->m_callsign);
+
+		write("DISC", false, addr, addrLen);
+		m_clients.erase(client);
+	} else if (length == M17_NETWORK_FRAME_LENGTH && ::memcmp(buffer, "M17 ", 4U) == 0) {
+		m_stats.received(buffer, length, now);
+
+		// On to the other links to the same module, as a reflector would
+		for (std::vector<CSimClient>::const_iterator it = m_clients.cbegin(); it != m_clients.cend(); ++it) {
+			if (!CUDPSocket::match(it->m_addr, addr) && it->m_module == client->m_module)
+				send(*it, buffer, now);
+		}
+	}
+}
+
+// Applies the impairments and queues the frame to go when its time comes
+void CSimReflector::send(const CSimClient& client, const unsigned char* data, unsigned long long now)
+{
+	assert(data != nullptr);
+
+	if (chance(m_loss)) {
+		m_dropped++;
+		return;
+	}
+
+	CSimPending pending;
+	pending.m_addr    = client.m_addr;
+	pending.m_addrLen = client.m_addrLen;
+	::memcpy(pending.m_data, data, M17_NETWORK_FRAME_LENGTH);
+
+	unsigned long long due = now;
+
+	if (m_jitter > 0U) {
+		std::uniform_int_distribution<unsigned int> dist(0U, m_jitter * 1000U);
+		due += dist(m_random) * 1000ULL;
+	}
+
+	if (chance(m_reorder)) {
+		due += REORDER_TIME;
+		m_reordered++;
+	}
+
+	m_pending.insert(std::make_pair(due, pending));
+
+	if (chance(m_duplicate)) {
+		m_pending.insert(std::make_pair(due + 1000ULL, pending));
+		m_duplicated++;
+	}
+}
+
+// The frames are stamped as they go, so that the impairments don't count as latency
+void CSimReflector::flush(unsigned long long now)
+{
+	while (!m_pending.empty() && m_pending.begin()->first <= now) {
+		CSimPending& pending = m_pending.begin()->second;
+
+		CSimFrame::stamp(pending.m_data, CStopWatch::nanoseconds());
+		m_socket.write(pending.m_data, M17_NETWORK_FRAME_LENGTH, pending.m_addr, pending.m_addrLen);
+		m_stats.sent();
+
+		m_pending.erase(m_pending.begin());
+	}
+}
+
+void CSimReflector::write(const char* type, bool name, const sockaddr_storage& addr, unsigned int addrLen)
+{
+	assert(type != nullptr);
+
+	unsigned char buffer[10U];
+	::memcpy(buffer, type, 4U);
+
+	if (name) {
+		::memcpy(buffer + 4U, m_encoded, 6U);
+		m_socket.write(buffer, 10U, addr, addrLen);
+	} else {
+		m_socket.write(buffer, 4U, addr, addrLen);
+	}
+}
+
+bool CSimReflector::chance(double percent)
+{
+	if (percent <= 0.0)
+		return false;
+
+	std::uniform_real_distribution<double> dist(0.0, 100.0);
+
+	return dist(m_random) < percent;
+}
+
+std::vector<CSimClient>::iterator CSimReflector::find(const sockaddr_storage& addr)
+{
+	for (std::vector<CSimClient>::iterator it = m_clients.begin(); it != m_clients.end(); ++it) {
+		if (CUDPSocket::match(it->m_addr, addr))
+			return it;
+	}
+
+	return m_clients.end();
+}
@@ -0,0 +1,116 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(SimReflector_H)
+#define	SimReflector_H
+
+#include "M17Defines.h"
+#include "SimSender.h"
+#include "SimStats.h"
+#include "UDPSocket.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+struct CSimClient {
+	sockaddr_storage   m_addr;
+	unsigned int       m_addrLen;
+	char               m_callsign[M17_CALLSIGN_LENGTH + 2U];
+	char               m_module;
+	unsigned char      m_dest[6U];
+	unsigned long long m_heard;
+};
+
+struct CSimPending {
+	sockaddr_storage   m_addr;
+	unsigned int       m_addrLen;
+	unsigned char      m_data[M17_NETWORK_FRAME_LENGTH];
+};
+
+// The reflector end of a gateway. It accepts links with CONN and answers
+// with ACKN, or NACK when told to refuse them, keeps them alive with PING
+// and PONG, and takes DISC. The frames from each link are passed on to the
+// others on the same module, and its own streams go to every link. Loss,
+// jitter, reordering and duplication can be added to every frame it sends.
+class CSimReflector {
+public:
+	CSimReflector(unsigned short port, const std::string& name, unsigned int streams, unsigned int frames, const std::string& source);
+	~CSimReflector();
+
+	void setNACK(bool nack);
+
+	// The percentages of frames lost, reordered and duplicated, and the most a frame is delayed by
+	void setImpairments(double loss, unsigned int jitter, double reorder, double duplicate);
+	void setSeed(unsigned int seed);
+
+	bool replay(const std::string& file);
+
+	bool open();
+
+	void start(unsigned long long now);
+	void stop();
+
+	// One pass, answers the links and sends the frames which are due
+	void clock(unsigned long long now);
+
+	unsigned int getLinks() const;
+
+	bool isFinished() const;
+
+	const CSimStats& getStats() const;
+
+	unsigned long long getDropped() const;
+	unsigned long long getReordered() const;
+	unsigned long long getDuplicated() const;
+
+	// Sends a DISC to every link
+	void close();
+
+private:
+	unsigned short                                 m_port;
+	std::string                                    m_name;
+	unsigned char                                  m_encoded[6U];
+	bool                                           m_nack;
+	CUDPSocket                                     m_socket;
+	CSimSender                                     m_sender;
+	CSimStats                                      m_stats;
+	bool                                           m_replay;
+	bool                                           m_sending;
+	std::vector<CSimClient>                        m_clients;
+	std::multimap<unsigned long long, CSimPending> m_pending;
+	std::mt19937                                   m_random;
+	double                                         m_loss;
+	unsigned int                                   m_jitter;
+	double                                         m_reorder;
+	double                                         m_duplicate;
+	unsigned long long                             m_ping;
+	unsigned long long                             m_dropped;
+	unsigned long long                             m_reordered;
+	unsigned long long                             m_duplicated;
+
+	void read(const unsigned char* buffer, unsigned int length, const sockaddr_storage& addr, unsigned int addrLen, unsigned long long now);
+	void send(const CSimClient& client, const unsigned char* data, unsigned long long now);
+	void flush(unsigned long long now);
+	void write(const char* type, bool name, const sockaddr_storage& addr, unsigned int addrLen);
+	bool chance(double percent);
+	std::vector<CSimClient>::iterator find(const sockaddr_storage& addr);
+};
+
+#endif
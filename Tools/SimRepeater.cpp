@@ -0,0 +1,109 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "SimRepeater.h"
+#include "M17Defines.h"
+#include "StopWatch.h"
+#include "SimFrame.h"
+#include "Log.h"
+
+#include <cassert>
+
+CSimRepeater::CSimRepeater(unsigned short port, const std::string& address, unsigned short gateway, unsigned int streams, unsigned int frames, const std::string& source, const std::string& dest) :
+m_port(port),
+m_address(address),
+m_gateway(gateway),
+m_socket(port),
+m_addr(),
+m_addrLen(0U),
+m_sender(streams, frames, source, dest),
+m_stats("Network to RF"),
+m_sending(false)
+{
+}
+
+CSimRepeater::~CSimRepeater()
+{
+}
+
+bool CSimRepeater::replay(const std::string& file)
+{
+	return m_sender.replay(file, FLIGHT_DIRECTION::RF_IN);
+}
+
+bool CSimRepeater::open()
+{
+	if (CUDPSocket::lookup(m_address, m_gateway, m_addr, m_addrLen) != 0) {
+		LogError("Unable to resolve the gateway address %s", m_address.c_str());
+		return false;
+	}
+
+	if (!m_socket.open(m_addr)) {
+		LogError("Unable to open port %u for the repeater", m_port);
+		return false;
+	}
+
+	LogMessage("Repeater on port %u, sending to %s:%u", m_port, m_address.c_str(), m_gateway);
+
+	return true;
+}
+
+void CSimRepeater::start(unsigned long long now)
+{
+	m_sender.start(now);
+	m_sending = true;
+}
+
+void CSimRepeater::stop()
+{
+	m_sending = false;
+}
+
+void CSimRepeater::clock(unsigned long long now)
+{
+	if (m_sending) {
+		unsigned char frame[M17_NETWORK_FRAME_LENGTH];
+		while (m_sender.read(frame, now)) {
+			CSimFrame::stamp(frame, CStopWatch::nanoseconds());
+			m_socket.write(frame, M17_NETWORK_FRAME_LENGTH, m_addr, m_addrLen);
+			m_stats.sent();
+		}
+	}
+
+	unsigned char buffer[200U];
+	sockaddr_storage addr;
+	unsigned int addrLen;
+	int length;
+	while ((length = m_socket.read(buffer, 200U, addr, addrLen)) > 0)
+		m_stats.received(buffer, (unsigned int)length, CStopWatch::nanoseconds());
+}
+
+bool CSimRepeater::isFinished() const
+{
+	return m_sender.isFinished();
+}
+
+const CSimStats& CSimRepeater::getStats() const
+{
+	return m_stats;
+}
+
+void CSimRepeater::close()
+{
+	m_socket.close();
+}
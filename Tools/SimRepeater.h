@@ -0,0 +1,63 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(SimRepeater_H)
+#define	SimRepeater_H
+
+#include "SimSender.h"
+#include "SimStats.h"
+#include "UDPSocket.h"
+
+#include <string>
+
+// The MMDVM host end of a gateway: sends the streams to the gateway's
+// LocalPort from its RptPort, and counts the frames the gateway sends back.
+class CSimRepeater {
+public:
+	CSimRepeater(unsigned short port, const std::string& address, unsigned short gateway, unsigned int streams, unsigned int frames, const std::string& source, const std::string& dest);
+	~CSimRepeater();
+
+	bool replay(const std::string& file);
+
+	bool open();
+
+	void start(unsigned long long now);
+	void stop();
+
+	// One pass, sends the frames which are due and reads any waiting
+	void clock(unsigned long long now);
+
+	bool isFinished() const;
+
+	const CSimStats& getStats() const;
+
+	void close();
+
+private:
+	unsigned short   m_port;
+	std::string      m_address;
+	unsigned short   m_gateway;
+	CUDPSocket       m_socket;
+	sockaddr_storage m_addr;
+	unsigned int     m_addrLen;
+	CSimSender       m_sender;
+	CSimStats        m_stats;
+	bool             m_sending;
+};
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "SimSender.h"
+#include "SimFrame.h"
+#include "M17Defines.h"
+#include "M17Utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+const unsigned long long FRAME_TIME = 40000000ULL;		// 40 ms in ns
+
+static bool earlier(const CSimReplay& a, const CSimReplay& b)
+{
+	return a.m_offset < b.m_offset;
+}
+
+CSimSender::CSimSender(unsigned int streams, unsigned int frames, const std::string& source, const std::string& dest) :
+m_streams(streams),
+m_frames(frames),
+m_sources(streams * 6U),
+m_dest(),
+m_due(streams),
+m_ids(streams),
+m_fns(streams),
+m_replay(),
+m_position(0U),
+m_start(0ULL),
+m_random()
+{
+	assert(frames > 0U);
+
+	std::random_device rd;
+	m_random.seed(rd());
+
+	for (unsigned int i = 0U; i < streams; i++) {
+		char callsign[20U];
+		::snprintf(callsign, sizeof(callsign), "%s%u", source.c_str(), i + 1U);
+
+		CM17Utils::encodeCallsign(callsign, m_sources.data() + i * 6U);
+	}
+
+	CM17Utils::encodeCallsign(dest, m_dest);
+}
+
+CSimSender::~CSimSender()
+{
+}
+
+bool CSimSender::replay(const std::string& file, FLIGHT_DIRECTION direction)
+{
+	FILE* fp = ::fopen(file.c_str(), "rb");
+	if (fp == nullptr) {
+		::fprintf(stderr, "Cannot open %s\n", file.c_str());
+		return false;
+	}
+
+	CFlightHeader header;
+	if (::fread(&header, sizeof(CFlightHeader), 1U, fp) != 1U || ::memcmp(header.m_magic, FLIGHT_MAGIC, sizeof(header.m_magic)) != 0 ||
+		header.m_recordLength != sizeof(CFlightRecord)) {
+		::fprintf(stderr, "%s is not a flight recorder file\n", file.c_str());
+		::fclose(fp);
+		return false;
+	}
+
+	m_replay.clear();
+
+	CFlightRecord record;
+	while (::fread(&record, sizeof(CFlightRecord), 1U, fp) == 1U) {
+		if (record.m_type != uint8_t(FLIGHT_TYPE::FRAME) || record.m_direction != uint8_t(direction))
+			continue;
+
+		CSimReplay replay;
+		replay.m_offset = record.m_timestamp;
+		replay.m_id     = record.m_id;
+		replay.m_fn     = record.m_fn;
+		::memcpy(replay.m_source, record.m_source, 6U);
+		::memcpy(replay.m_dest,   record.m_dest,   6U);
+
+		m_replay.push_back(replay);
+	}
+
+	::fclose(fp);
+
+	if (m_replay.empty()) {
+		::fprintf(stderr, "%s holds no frames to replay\n", file.c_str());
+		return false;
+	}
+
+	// The records from several threads may be slightly out of order
+	std::stable_sort(m_replay.begin(), m_replay.end(), earlier);
+
+	unsigned long long first = m_replay.front().m_offset;
+	for (std::vector<CSimReplay>::iterator it = m_replay.begin(); it != m_replay.end(); ++it)
+		it->m_offset -= first;
+
+	return true;
+}
+
+void CSimSender::start(unsigned long long now)
+{
+	m_start    = now;
+	m_position = 0U;
+
+	// The streams are spread across the frame time rather than all sent at once
+	for (unsigned int i = 0U; i < m_streams; i++) {
+		m_due.at(i) = now + (FRAME_TIME * i) / m_streams;
+		m_ids.at(i) = newId();
+		m_fns.at(i) = 0U;
+	}
+}
+
+bool CSimSender::read(unsigned char* frame, unsigned long long now)
+{
+	assert(frame != nullptr);
+
+	if (!m_replay.empty()) {
+		if (m_position >= m_replay.size())
+			return false;
+
+		const CSimReplay& replay = m_replay.at(m_position);
+		if ((m_start + replay.m_offset) > now)
+			return false;
+
+		CSimFrame::build(frame, replay.m_id, replay.m_fn, (replay.m_fn & 0x8000U) == 0x8000U, replay.m_source, replay.m_dest);
+		m_position++;
+
+		return true;
+	}
+
+	for (unsigned int i = 0U; i < m_streams; i++) {
+		if (m_due.at(i) > now)
+			continue;
+
+		bool end = m_fns.at(i) == (m_frames - 1U);
+
+		CSimFrame::build(frame, m_ids.at(i), m_fns.at(i), end, m_sources.data() + i * 6U, m_dest);
+
+		m_due.at(i) += FRAME_TIME;
+
+		if (end) {
+			m_ids.at(i) = newId();
+			m_fns.at(i) = 0U;
+		} else {
+			m_fns.at(i)++;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+unsigned long long CSimSender::getNext() const
+{
+	if (!m_replay.empty()) {
+		if (m_position >= m_replay.size())
+			return ~0ULL;
+
+		return m_start + m_replay.at(m_position).m_offset;
+	}
+
+	unsigned long long next = ~0ULL;
+	for (unsigned int i = 0U; i < m_streams; i++) {
+		if (m_due.at(i) < next)
+			next = m_due.at(i);
+	}
+
+	return next;
+}
+
+bool CSimSender::isFinished() const
+{
+	return !m_replay.empty() && m_position >= m_replay.size();
+}
+
+// Not zero, and not the id of another of the streams
+uint16_t CSimSender::newId()
+{
+	std::uniform_int_distribution<uint16_t> dist(0x0001U, 0xFFFEU);
+
+	for (;;) {
+		uint16_t id = dist(m_random);
+		if (std::find(m_ids.cbegin(), m_ids.cend(), id) == m_ids.cend())
+			return id;
+	}
+}
@@ -0,0 +1,79 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(SimSender_H)
+#define	SimSender_H
+
+#include "FlightRecorder.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// One frame to be replayed, at a time relative to the first
+struct CSimReplay {
+	unsigned long long m_offset;
+	uint16_t           m_id;
+	uint16_t           m_fn;
+	unsigned char      m_source[6U];
+	unsigned char      m_dest[6U];
+};
+
+// The frames a simulator sends, either generated or replayed. Generated
+// streams run side by side at one frame every 40 ms, each sending
+// transmissions of a fixed number of frames back to back with a new id for
+// each. Replayed frames are the frame headers held in a flight recorder
+// file, sent with the same spacing as they were recorded.
+class CSimSender {
+public:
+	// Stream n comes from the source callsign followed by n
+	CSimSender(unsigned int streams, unsigned int frames, const std::string& source, const std::string& dest);
+	~CSimSender();
+
+	// Replaces the generated streams with the frames recorded in one direction
+	bool replay(const std::string& file, FLIGHT_DIRECTION direction);
+
+	void start(unsigned long long now);
+
+	// A frame which is due by now, call it until it returns false
+	bool read(unsigned char* frame, unsigned long long now);
+
+	// The time the next frame is due
+	unsigned long long getNext() const;
+
+	// Only a replay finishes
+	bool isFinished() const;
+
+private:
+	unsigned int                    m_streams;
+	unsigned int                    m_frames;
+	std::vector<unsigned char>      m_sources;
+	unsigned char                   m_dest[6U];
+	std::vector<unsigned long long> m_due;
+	std::vector<uint16_t>           m_ids;
+	std::vector<uint16_t>           m_fns;
+	std::vector<CSimReplay>         m_replay;
+	unsigned int                    m_position;
+	unsigned long long              m_start;
+	std::mt19937                    m_random;
+
+	uint16_t newId();
+};
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "SimStats.h"
+#include "SimFrame.h"
+
+#include <cassert>
+
+CSimStats::CSimStats(const std::string& name) :
+m_name(name),
+m_latency(name),
+m_streams(),
+m_sent(0ULL),
+m_received(0ULL),
+m_other(0ULL),
+m_duplicates(0ULL),
+m_reordered(0ULL)
+{
+}
+
+CSimStats::~CSimStats()
+{
+}
+
+void CSimStats::sent()
+{
+	m_sent++;
+}
+
+void CSimStats::received(const unsigned char* data, unsigned int length, unsigned long long now)
+{
+	assert(data != nullptr);
+
+	uint16_t id, fn;
+	bool end;
+	unsigned long long ns;
+	if (!CSimFrame::read(data, length, id, fn, end, ns)) {
+		// Such as the voice announcements and the echo from the gateway
+		m_other++;
+		return;
+	}
+
+	m_received++;
+
+	if (now > ns)
+		m_latency.record(now - ns);
+
+	std::unordered_map<uint16_t, CSimStream>::iterator it = m_streams.find(id);
+	if (it == m_streams.end()) {
+		CSimStream stream;
+		stream.m_count = 0U;
+		stream.m_max   = -1;
+		stream.m_end   = -1;
+
+		it = m_streams.insert(std::make_pair(id, stream)).first;
+	}
+
+	CSimStream& stream = it->second;
+
+	if (fn >= stream.m_seen.size())
+		stream.m_seen.resize(fn + 1U, false);
+
+	if (stream.m_seen.at(fn)) {
+		m_duplicates++;
+		return;
+	}
+
+	stream.m_seen.at(fn) = true;
+	stream.m_count++;
+
+	if (int(fn) < stream.m_max)
+		m_reordered++;
+	else
+		stream.m_max = fn;
+
+	if (end)
+		stream.m_end = fn;
+}
+
+unsigned long long CSimStats::getSent() const
+{
+	return m_sent;
+}
+
+unsigned long long CSimStats::getReceived() const
+{
+	return m_received;
+}
+
+// The gaps in the frame numbers of each stream, up to the last frame seen or the end
+unsigned long long CSimStats::getLost() const
+{
+	unsigned long long lost = 0ULL;
+
+	for (std::unordered_map<uint16_t, CSimStream>::const_iterator it = m_streams.cbegin(); it != m_streams.cend(); ++it) {
+		const CSimStream& stream = it->second;
+
+		int last = (stream.m_end >= 0) ? stream.m_end : stream.m_max;
+		if ((unsigned int)(last + 1) > stream.m_count)
+			lost += (unsigned int)(last + 1) - stream.m_count;
+	}
+
+	return lost;
+}
+
+unsigned long long CSimStats::getDuplicates() const
+{
+	return m_duplicates;
+}
+
+unsigned long long CSimStats::getReordered() const
+{
+	return m_reordered;
+}
+
+const CLatencyHistogram& CSimStats::getLatency() const
+{
+	return m_latency;
+}
+
+void CSimStats::print(FILE* fp) const
+{
+	assert(fp != nullptr);
+
+	::fprintf(fp, "Sent %llu frames\n", m_sent);
+	::fprintf(fp, "Received %llu frames in %u streams, %llu lost, %llu duplicated, %llu out of order, %llu others\n",
+		m_received, (unsigned int)m_streams.size(), getLost(), m_duplicates, m_reordered, m_other);
+
+	std::string text;
+	m_latency.format(text);
+	::fputs(text.c_str(), fp);
+}
@@ -0,0 +1,71 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(SimStats_H)
+#define	SimStats_H
+
+#include "LatencyHistogram.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// What has been seen of one stream id, the frame numbers index m_seen
+struct CSimStream {
+	std::vector<bool> m_seen;
+	unsigned int      m_count;
+	int               m_max;
+	int               m_end;
+};
+
+// Counts the frames a simulator sends and receives. The received frames from
+// the other simulator give the latency across the gateway, and their frame
+// numbers show any that were lost, duplicated or arrived out of order.
+class CSimStats {
+public:
+	CSimStats(const std::string& name);
+	~CSimStats();
+
+	void sent();
+
+	void received(const unsigned char* data, unsigned int length, unsigned long long now);
+
+	unsigned long long getSent() const;
+	unsigned long long getReceived() const;
+	unsigned long long getLost() const;
+	unsigned long long getDuplicates() const;
+	unsigned long long getReordered() const;
+
+	const CLatencyHistogram& getLatency() const;
+
+	void print(FILE* fp) const;
+
+private:
+	std::string                                  m_name;
+	CLatencyHistogram                            m_latency;
+	std::unordered_map<uint16_t, CSimStream>     m_streams;
+	unsigned long long                           m_sent;
+	unsigned long long                           m_received;
+	unsigned long long                           m_other;
+	unsigned long long                           m_duplicates;
+	unsigned long long                           m_reordered;
+};
+
+#endif
@@ -279,7 +279,12 @@ int CUDPSocket::read(unsigned char* buffer, unsigned int length, sockaddr_storag
 #else
 	ssize_t len = ::recvfrom(m_fd, (char*)buffer, length, 0, (sockaddr *)&address, &size);
 #endif
-	if (len <= 0) {
+
+	// An empty datagram is just ignored
+	if (len == 0)
+		return 0;
+
+	if (len < 0) {
 #if defined(_WIN32) || defined(_WIN64)
 		LogError("Error returned from recvfrom, err: %lu", ::GetLastError());
 #else
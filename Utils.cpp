@@ -17,18 +17,23 @@
 #include <cstdio>
 #include <cassert>
 
-void CUtils::dump(const std::string& title, const unsigned char* data, unsigned int length)
+void CUtils::dump(const char* title, const unsigned char* data, unsigned int length)
 {
 	assert(data != nullptr);
 
 	dump(2U, title, data, length);
 }
 
-void CUtils::dump(int level, const std::string& title, const unsigned char* data, unsigned int length)
+void CUtils::dump(int level, const char* title, const unsigned char* data, unsigned int length)
 {
+	assert(title != nullptr);
 	assert(data != nullptr);
 
-	::Log(level, "%s", title.c_str());
+	// Don't do any of the formatting if nothing will be written
+	if (!::LogIsEnabled(level))
+		return;
+
+	::Log(level, "%s", title);
 
 	unsigned int offset = 0U;
 
@@ -70,17 +75,20 @@ void CUtils::dump(int level, const std::string& title, const unsigned char* data
 	}
 }
 
-void CUtils::dump(const std::string& title, const bool* bits, unsigned int length)
+void CUtils::dump(const char* title, const bool* bits, unsigned int length)
 {
 	assert(bits != nullptr);
 
 	dump(2U, title, bits, length);
 }
 
-void CUtils::dump(int level, const std::string& title, const bool* bits, unsigned int length)
+void CUtils::dump(int level, const char* title, const bool* bits, unsigned int length)
 {
 	assert(bits != nullptr);
 
+	if (!::LogIsEnabled(level))
+		return;
+
 	unsigned char bytes[100U];
 	unsigned int nBytes = 0U;
 	for (unsigned int n = 0U; n < length; n += 8U, nBytes++)
@@ -18,11 +18,11 @@
 
 class CUtils {
 public:
-	static void dump(const std::string& title, const unsigned char* data, unsigned int length);
-	static void dump(int level, const std::string& title, const unsigned char* data, unsigned int length);
+	static void dump(const char* title, const unsigned char* data, unsigned int length);
+	static void dump(int level, const char* title, const unsigned char* data, unsigned int length);
 
-	static void dump(const std::string& title, const bool* bits, unsigned int length);
-	static void dump(int level, const std::string& title, const bool* bits, unsigned int length);
+	static void dump(const char* title, const bool* bits, unsigned int length);
+	static void dump(int level, const char* title, const bool* bits, unsigned int length);
 
 	static void byteToBitsBE(unsigned char byte, bool* bits);
 	static void byteToBitsLE(unsigned char byte, bool* bits);
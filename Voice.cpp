@@ -18,15 +18,13 @@
 
 #include "Voice.h"
 #include "M17Defines.h"
+#include "EventLog.h"
 #include "Log.h"
 
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
 #include <cassert>
-#include <random>
-
-#include <sys/stat.h>
 
 const unsigned int SILENCE_LENGTH = 4U;
 
@@ -35,36 +33,32 @@ const unsigned char BIT_MASK_TABLE[] = { 0x80U, 0x40U, 0x20U, 0x10U, 0x08U, 0x04
 #define WRITE_BIT1(p,i,b) p[(i)>>3] = (b) ? (p[(i)>>3] | BIT_MASK_TABLE[(i)&7]) : (p[(i)>>3] & ~BIT_MASK_TABLE[(i)&7])
 #define READ_BIT1(p,i)    (p[(i)>>3] & BIT_MASK_TABLE[(i)&7])
 
-CVoice::CVoice(const std::string& directory, const std::string& language, const std::string& callsign) :
-m_language(language),
-m_indxFile(),
-m_m17File(),
+CVoice::CVoice(const CVoiceAssets& assets, const std::string& callsign) :
+m_assets(assets),
+m_language(assets.getLanguage()),
 m_lsf(),
 m_status(VOICE_STATUS::NONE),
 m_timer(1000U, 2U),
 m_stopWatch(),
 m_sent(0U),
-m_m17(nullptr),
 m_voiceData(nullptr),
 m_voiceLength(0U),
-m_positions(),
-m_metaArray(),
-m_itMeta()
+m_meta(),
+m_metaCount(0U),
+m_metaIndex(0U),
+m_random(),
+m_text(),
+m_events(nullptr),
+m_announcements(CMetrics::counter("m17gateway_voice_announcements_total", "Voice announcements played")),
+m_framesSent(CMetrics::counter("m17gateway_voice_frames_sent_total", "Voice announcement frames sent"))
 {
-	assert(!directory.empty());
-	assert(!language.empty());
-
-#if defined(_WIN32) || defined(_WIN64)
-	m_indxFile = directory + "\\" + language + ".indx";
-	m_m17File  = directory + "\\" + language + ".m17";
-#else
-	m_indxFile = directory + "/" + language + ".indx";
-	m_m17File  = directory + "/" + language + ".m17";
-#endif
-
 	// 15s of audio maximum
 	m_voiceData = new unsigned char[15U * 25U * M17_NETWORK_FRAME_LENGTH];
 
+	// Seeded once, rather than opening the random device for every announcement
+	std::random_device rd;
+	m_random.seed(rd());
+
 	m_lsf.setSource(callsign);
 	m_lsf.setDest("INFO");
 	m_lsf.setPacketStream(M17_STREAM_TYPE);
@@ -77,74 +71,23 @@ m_itMeta()
 
 CVoice::~CVoice()
 {
-	for (std::unordered_map<std::string, CPositions*>::iterator it = m_positions.begin(); it != m_positions.end(); ++it)
-		delete it->second;
-
-	m_positions.clear();
-
-	delete[] m_m17;
 	delete[] m_voiceData;
 }
 
-bool CVoice::open()
+void CVoice::setEvents(CEventLog* events)
 {
-	FILE* fpindx = ::fopen(m_indxFile.c_str(), "rt");
-	if (fpindx == nullptr) {
-		LogError("Unable to open the index file - %s", m_indxFile.c_str());
-		return false;
-	}
-
-	struct stat statStruct;
-	int ret = ::stat(m_m17File.c_str(), &statStruct);
-	if (ret != 0) {
-		LogError("Unable to stat the M17 file - %s", m_m17File.c_str());
-		::fclose(fpindx);
-		return false;
-	}
-
-	FILE* fpm17 = ::fopen(m_m17File.c_str(), "rb");
-	if (fpm17 == nullptr) {
-		LogError("Unable to open the M17 file - %s", m_m17File.c_str());
-		::fclose(fpindx);
-		return false;
-	}
-
-	m_m17 = new unsigned char[statStruct.st_size];
-
-	size_t sizeRead = ::fread(m_m17, 1U, statStruct.st_size, fpm17);
-	if (sizeRead != 0U) {
-		char buffer[80U];
-		while (::fgets(buffer, 80, fpindx) != nullptr) {
-			char* p1 = ::strtok(buffer, "\t\r\n");
-			char* p2 = ::strtok(nullptr, "\t\r\n");
-			char* p3 = ::strtok(nullptr, "\t\r\n");
-
-			if (p1 != nullptr && p2 != nullptr && p3 != nullptr) {
-				std::string symbol  = std::string(p1);
-				unsigned int start  = ::atoi(p2) * M17_3200_LENGTH_BYTES;
-				unsigned int length = (::atoi(p3) + 1U) / 2U;
-
-				CPositions* pos = new CPositions;
-				pos->m_start = start;
-				pos->m_length = length;
-
-				m_positions[symbol] = pos;
-			}
-		}
-	}
-
-	::fclose(fpindx);
-	::fclose(fpm17);
-
-	LogInfo("Loaded the audio and index file for %s", m_language.c_str());
+	m_events = events;
+}
 
-	return true;
+void CVoice::prefault()
+{
+	::memset(m_voiceData, 0x00U, 15U * 25U * M17_NETWORK_FRAME_LENGTH);
 }
 
 void CVoice::linkedTo(const std::string& reflector)
 {
 	std::vector<std::string> words;
-	if (m_positions.count("linkedto") == 0U) {
+	if (m_assets.find("linkedto") == nullptr) {
 		words.push_back("linked");
 		words.push_back("2");
 	} else {
@@ -237,6 +180,8 @@ void CVoice::createVoice(const std::vector<std::string>& words, const char* text
 {
 	assert(text != nullptr);
 
+	::snprintf(m_text, sizeof(m_text), "%s", text);
+
 	size_t textSize = ::strlen(text);
 	unsigned char count = textSize / (M17_META_LENGTH_BYTES - 1U);
 	if ((textSize % (M17_META_LENGTH_BYTES - 1U)) > 0U)
@@ -256,7 +201,7 @@ void CVoice::createVoice(const std::vector<std::string>& words, const char* text
 		bitMap = 0xF0U;
 
 	for (unsigned char n = 0U; n < count; n++) {
-		unsigned char* meta = new unsigned char[M17_META_LENGTH_BYTES];
+		unsigned char* meta = m_meta[n];
 		::memset(meta, ' ', M17_META_LENGTH_BYTES);
 
 		meta[0U] = (0x01U << n) | bitMap;
@@ -267,19 +212,18 @@ void CVoice::createVoice(const std::vector<std::string>& words, const char* text
 			::memcpy(meta + 1U, p, textSize);
 		else
 			::memcpy(meta + 1U, p, M17_META_LENGTH_BYTES - 1U);
-
-		m_metaArray.push_back(meta);
 	}
 
-	m_itMeta = m_metaArray.cbegin();
-	m_lsf.setMeta(*m_itMeta);
+	m_metaCount = count;
+	m_metaIndex = 0U;
+	m_lsf.setMeta(m_meta[0U]);
 
 	m_voiceLength = 0U;
 
 	unsigned int m17Length = 0U;
 	for (std::vector<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
-		if (m_positions.count(*it) > 0U) {
-			CPositions* position = m_positions.at(*it);
+		const CPositions* position = m_assets.find(*it);
+		if (position != nullptr) {
 			m17Length += position->m_length;
 		} else {
 			LogWarning("Unable to find character/phrase \"%s\" in the index", (*it).c_str());
@@ -295,10 +239,8 @@ void CVoice::createVoice(const std::vector<std::string>& words, const char* text
 	m17Length += SILENCE_LENGTH;
 
 	// Create a random id for this transmission if needed
-	std::random_device rd;
-	std::mt19937 mt(rd());
 	std::uniform_int_distribution<uint16_t> dist(0x0001, 0xFFFE);
-	uint16_t id = dist(mt);
+	uint16_t id = dist(m_random);
 
 	uint16_t fn = 0U;
 
@@ -307,12 +249,9 @@ void CVoice::createVoice(const std::vector<std::string>& words, const char* text
 		createFrame(id, fn, M17_3200_SILENCE, 1U, false);
 
 	for (std::vector<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
-		if (m_positions.count(*it) > 0U) {
-			CPositions* position = m_positions.at(*it);
-			unsigned int start  = position->m_start;
-			unsigned int length = position->m_length;
-			createFrame(id, fn, m_m17 + start, length, false);
-		}
+		const CPositions* position = m_assets.find(*it);
+		if (position != nullptr)
+			createFrame(id, fn, m_assets.getAudio() + position->m_start, position->m_length, false);
 	}
 
 	// End with silence
@@ -320,10 +259,6 @@ void CVoice::createVoice(const std::vector<std::string>& words, const char* text
 		createFrame(id, fn, M17_3200_SILENCE, 1U, false);
 
 	createFrame(id, fn, M17_3200_SILENCE, 1U, true);
-
-	for (std::vector<const unsigned char*>::iterator it = m_metaArray.begin(); it != m_metaArray.end(); ++it)
-		delete *it;
-	m_metaArray.clear();
 }
 
 bool CVoice::read(unsigned char* data)
@@ -342,9 +277,14 @@ bool CVoice::read(unsigned char* data)
 		offset += M17_NETWORK_FRAME_LENGTH;
 		m_sent++;
 
+		m_framesSent.inc();
+
 		if (offset >= m_voiceLength) {
 			m_timer.stop();
 			m_status = VOICE_STATUS::NONE;
+
+			if (m_events != nullptr)
+				m_events->voice("end", m_text);
 		}
 
 		return true;
@@ -371,6 +311,11 @@ void CVoice::clock(unsigned int ms)
 			m_stopWatch.start();
 			m_status = VOICE_STATUS::SENDING;
 			m_sent = 0U;
+
+			m_announcements.inc();
+
+			if (m_events != nullptr)
+				m_events->voice("start", m_text);
 		}
 	}
 }
@@ -399,11 +344,11 @@ void CVoice::createFrame(uint16_t id, uint16_t& fn, const unsigned char* audio,
 			frame[34U] |= 0x80U;
 		fn++;
 		if ((fn % 6U) == 0U) {
-			++m_itMeta;
-			if (m_itMeta == m_metaArray.cend())
-				m_itMeta = m_metaArray.cbegin();
+			m_metaIndex++;
+			if (m_metaIndex >= m_metaCount)
+				m_metaIndex = 0U;
 
-			m_lsf.setMeta(*m_itMeta);
+			m_lsf.setMeta(m_meta[m_metaIndex]);
 		}
 
 		::memcpy(frame + 36U, audio, M17_PAYLOAD_LENGTH_BYTES);
@@ -19,14 +19,19 @@
 #if !defined(Voice_H)
 #define	Voice_H
 
+#include "VoiceAssets.h"
 #include "StopWatch.h"
+#include "Metrics.h"
+#include "M17Defines.h"
 #include "M17LSF.h"
 #include "Timer.h"
 
 #include <cstdint>
+#include <random>
 #include <string>
 #include <vector>
-#include <unordered_map>
+
+class CEventLog;
 
 enum class VOICE_STATUS {
 	NONE,
@@ -34,17 +39,15 @@ enum class VOICE_STATUS {
 	SENDING
 };
 
-struct CPositions {
-	unsigned int m_start;
-	unsigned int m_length;
-};
-
 class CVoice {
 public:
-	CVoice(const std::string& directory, const std::string& language, const std::string& callsign);
+	CVoice(const CVoiceAssets& assets, const std::string& callsign);
 	~CVoice();
 
-	bool open();
+	void setEvents(CEventLog* events);
+
+	// Touches the announcement buffer now rather than when it is first used
+	void prefault();
 
 	void linkedTo(const std::string& reflector);
 	void unlinked();
@@ -56,20 +59,23 @@ public:
 	void clock(unsigned int ms);
 
 private:
+	const CVoiceAssets&                    m_assets;
 	std::string                            m_language;
-	std::string                            m_indxFile;
-	std::string                            m_m17File;
 	CM17LSF                                m_lsf;
 	VOICE_STATUS                           m_status;
 	CTimer                                 m_timer;
 	CStopWatch                             m_stopWatch;
 	unsigned int                           m_sent;
-	unsigned char*                         m_m17;
 	unsigned char*                         m_voiceData;
 	unsigned int                           m_voiceLength;
-	std::unordered_map<std::string, CPositions*> m_positions;
-	std::vector<const unsigned char*>      m_metaArray;
-	std::vector<const unsigned char*>::const_iterator m_itMeta;
+	unsigned char                          m_meta[4U][M17_META_LENGTH_BYTES];
+	unsigned int                           m_metaCount;
+	unsigned int                           m_metaIndex;
+	std::mt19937                           m_random;
+	char                                   m_text[50U];
+	CEventLog*                             m_events;
+	CMetricCounter&                        m_announcements;
+	CMetricCounter&                        m_framesSent;
 
 	void createVoice(const std::vector<std::string>& words, const char* text);
 	void createFrame(uint16_t id, uint16_t& fn, const unsigned char* audio, unsigned int length, bool end);
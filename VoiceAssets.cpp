@@ -0,0 +1,122 @@
+/*
+ *   Copyright (C) 2017,2018,2021,2024,2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "VoiceAssets.h"
+#include "M17Defines.h"
+#include "Log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+
+#include <sys/stat.h>
+
+CVoiceAssets::CVoiceAssets(const std::string& directory, const std::string& language) :
+m_language(language),
+m_indxFile(),
+m_m17File(),
+m_m17(nullptr),
+m_positions()
+{
+	assert(!directory.empty());
+	assert(!language.empty());
+
+#if defined(_WIN32) || defined(_WIN64)
+	m_indxFile = directory + "\\" + language + ".indx";
+	m_m17File  = directory + "\\" + language + ".m17";
+#else
+	m_indxFile = directory + "/" + language + ".indx";
+	m_m17File  = directory + "/" + language + ".m17";
+#endif
+}
+
+CVoiceAssets::~CVoiceAssets()
+{
+	delete[] m_m17;
+}
+
+bool CVoiceAssets::open()
+{
+	FILE* fpindx = ::fopen(m_indxFile.c_str(), "rt");
+	if (fpindx == nullptr) {
+		LogError("Unable to open the index file - %s", m_indxFile.c_str());
+		return false;
+	}
+
+	struct stat statStruct;
+	int ret = ::stat(m_m17File.c_str(), &statStruct);
+	if (ret != 0) {
+		LogError("Unable to stat the M17 file - %s", m_m17File.c_str());
+		::fclose(fpindx);
+		return false;
+	}
+
+	FILE* fpm17 = ::fopen(m_m17File.c_str(), "rb");
+	if (fpm17 == nullptr) {
+		LogError("Unable to open the M17 file - %s", m_m17File.c_str());
+		::fclose(fpindx);
+		return false;
+	}
+
+	m_m17 = new unsigned char[statStruct.st_size];
+
+	size_t sizeRead = ::fread(m_m17, 1U, statStruct.st_size, fpm17);
+	if (sizeRead != 0U) {
+		char buffer[80U];
+		while (::fgets(buffer, 80, fpindx) != nullptr) {
+			char* p1 = ::strtok(buffer, "\t\r\n");
+			char* p2 = ::strtok(nullptr, "\t\r\n");
+			char* p3 = ::strtok(nullptr, "\t\r\n");
+
+			if (p1 != nullptr && p2 != nullptr && p3 != nullptr) {
+				CPositions pos;
+				pos.m_start  = ::atoi(p2) * M17_3200_LENGTH_BYTES;
+				pos.m_length = (::atoi(p3) + 1U) / 2U;
+
+				m_positions[std::string(p1)] = pos;
+			}
+		}
+	}
+
+	::fclose(fpindx);
+	::fclose(fpm17);
+
+	LogInfo("Loaded the audio and index file for %s", m_language.c_str());
+
+	return true;
+}
+
+const std::string& CVoiceAssets::getLanguage() const
+{
+	return m_language;
+}
+
+const CPositions* CVoiceAssets::find(const std::string& symbol) const
+{
+	std::unordered_map<std::string, CPositions>::const_iterator it = m_positions.find(symbol);
+	if (it == m_positions.cend())
+		return nullptr;
+
+	return &it->second;
+}
+
+const unsigned char* CVoiceAssets::getAudio() const
+{
+	return m_m17;
+}
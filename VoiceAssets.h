@@ -0,0 +1,54 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(VoiceAssets_H)
+#define	VoiceAssets_H
+
+#include <string>
+#include <unordered_map>
+
+struct CPositions {
+	unsigned int m_start;
+	unsigned int m_length;
+};
+
+// The Codec 2 audio and its index for one language. It is loaded once and
+// not changed afterwards, so every repeater's CVoice can share it.
+class CVoiceAssets {
+public:
+	CVoiceAssets(const std::string& directory, const std::string& language);
+	~CVoiceAssets();
+
+	bool open();
+
+	const std::string& getLanguage() const;
+
+	// Returns nullptr if the word or phrase isn't in the index
+	const CPositions* find(const std::string& symbol) const;
+
+	const unsigned char* getAudio() const;
+
+private:
+	std::string                                 m_language;
+	std::string                                 m_indxFile;
+	std::string                                 m_m17File;
+	unsigned char*                              m_m17;
+	std::unordered_map<std::string, CPositions> m_positions;
+};
+
+#endif
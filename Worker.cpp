@@ -0,0 +1,154 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "Worker.h"
+#include "StopWatch.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cstdio>
+
+// Work done in one pass of a worker's loop, in microseconds
+static const unsigned long long LOOP_BUCKETS[] = { 10ULL, 25ULL, 50ULL, 100ULL, 250ULL, 500ULL, 1000ULL, 2500ULL, 5000ULL, 10000ULL, 25000ULL };
+
+static std::string workerName(unsigned int id)
+{
+	char text[20U];
+	::sprintf(text, "Worker %u loop", id);
+
+	return text;
+}
+
+CWorker::CWorker(unsigned int id, int cpu) :
+CThread(),
+m_id(id),
+m_cpu(cpu),
+m_realTime(nullptr),
+m_repeaters(),
+m_killed(false),
+m_latency(false),
+m_started(false),
+m_loopTime(workerName(id)),
+m_loopMetric(CMetrics::histogram("m17gateway_worker_loop_duration_seconds", "Time spent working in one pass of a worker loop", LOOP_BUCKETS, sizeof(LOOP_BUCKETS) / sizeof(LOOP_BUCKETS[0U]), 1.0E-6, "worker=\"" + std::to_string(id) + "\""))
+{
+}
+
+CWorker::~CWorker()
+{
+}
+
+void CWorker::add(CM17Repeater* repeater)
+{
+	assert(repeater != nullptr);
+
+	// The remote latency command reports what this thread writes, and nothing else
+	std::vector<CLatencyHistogram*> latencies;
+	latencies.push_back(&m_loopTime);
+	repeater->setLatencies(latencies);
+
+	m_repeaters.push_back(repeater);
+}
+
+void CWorker::setRealTime(const CRealTime* realTime)
+{
+	m_realTime = realTime;
+}
+
+bool CWorker::start()
+{
+	m_started = run();
+	if (!m_started) {
+		LogError("Worker %u, unable to start the thread", m_id);
+		return false;
+	}
+
+	return true;
+}
+
+void CWorker::logLatencies()
+{
+	m_latency.store(true);
+}
+
+void CWorker::stop()
+{
+	m_killed.store(true);
+
+	if (m_started)
+		wait();
+
+	m_started = false;
+}
+
+void CWorker::entry()
+{
+	char name[20U];
+	::sprintf(name, "Worker %u", m_id);
+
+	bool pinned = CRealTime::setAffinity(name, m_cpu);
+
+	// A worker keeps the CPU it was given
+	if (m_realTime != nullptr)
+		m_realTime->apply(name, false);
+
+	if (pinned)
+		LogMessage("Worker %u, running %u repeater%s on CPU %d", m_id, (unsigned int)m_repeaters.size(), (m_repeaters.size() == 1U) ? "" : "s", m_cpu);
+	else
+		LogMessage("Worker %u, running %u repeater%s", m_id, (unsigned int)m_repeaters.size(), (m_repeaters.size() == 1U) ? "" : "s");
+
+	CStopWatch stopWatch;
+	stopWatch.start();
+
+	while (!m_killed.load()) {
+		unsigned long long loopStart = CStopWatch::nanoseconds();
+
+		bool busy = false;
+		for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it) {
+			if ((*it)->process())
+				busy = true;
+		}
+
+		unsigned int ms = stopWatch.elapsed();
+		stopWatch.start();
+
+		for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it)
+			(*it)->clock(ms);
+
+		unsigned long long now = CStopWatch::nanoseconds();
+		m_loopTime.record(now - loopStart);
+		m_loopMetric.observe((now - loopStart) / 1000ULL);
+
+		if (m_latency.exchange(false)) {
+			std::vector<CLatencyHistogram*> latencies;
+			latencies.push_back(&m_loopTime);
+			for (std::vector<CM17Repeater*>::const_iterator it = m_repeaters.cbegin(); it != m_repeaters.cend(); ++it)
+				(*it)->getLatencies(latencies);
+
+			for (std::vector<CLatencyHistogram*>::const_iterator it = latencies.cbegin(); it != latencies.cend(); ++it) {
+				std::string text;
+				(*it)->format(text);
+				text.pop_back();
+				LogMessage("Latency, %s", text.c_str());
+			}
+		}
+
+		// Keep going while the frames are coming in, a full queue is worse than a busy core
+		if (!busy)
+			CThread::sleep(5U);
+	}
+}
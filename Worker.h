@@ -0,0 +1,66 @@
+/*
+ *   Copyright (C) 2025 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(Worker_H)
+#define	Worker_H
+
+#include "LatencyHistogram.h"
+#include "M17Repeater.h"
+#include "RealTime.h"
+#include "Metrics.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Runs the loop for a share of the repeaters on its own thread, in place of
+// the main loop. A repeater belongs to one worker for its whole life, so none
+// of its state is shared between threads.
+class CWorker : public CThread {
+public:
+	// A CPU of -1 leaves the thread to run anywhere
+	CWorker(unsigned int id, int cpu);
+	virtual ~CWorker();
+
+	// Only before the worker is started
+	void add(CM17Repeater* repeater);
+	void setRealTime(const CRealTime* realTime);
+
+	bool start();
+
+	// Logs the latencies of the worker and its repeaters from its own thread
+	void logLatencies();
+
+	void stop();
+
+	virtual void entry();
+
+private:
+	unsigned int               m_id;
+	int                        m_cpu;
+	const CRealTime*           m_realTime;
+	std::vector<CM17Repeater*> m_repeaters;
+	std::atomic<bool>          m_killed;
+	std::atomic<bool>          m_latency;
+	bool                       m_started;
+	CLatencyHistogram          m_loopTime;
+	CMetricHistogram&          m_loopMetric;
+};
+
+#endif